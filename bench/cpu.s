@@ -0,0 +1,202 @@
+; CPU-bound 68K loop mix: the main loop never waits for the V blank and
+; cycles through ALU, multiply/divide, block copy, table dispatch and bit
+; operation kernels. The screen is static apart from the frame counter and
+; the number of finished rounds, so nearly all time goes to the 68K core.
+
+rom_name macro
+        dc.b    "BENCH CPU MIX"
+        endm
+        include "common.inc"
+
+rounds          equ RAM_USER
+checksum        equ RAM_USER+4
+copy_buffer     equ RAM_USER+$100         ; 1 KB
+bit_buffer      equ RAM_USER+$600         ; 256 bytes
+
+main
+        bsr.w   load_common_tiles
+        moveq   #0,d0
+        bsr.w   load_rainbow
+        ; Plane B: checkerboard, a static backdrop
+        lea     checker_row(pc),a0
+        vdp_cmd VRAM_WRITE,VRAM_PLANE_B,d0
+        moveq   #0,d1
+        bsr.w   fill_plane
+        move.w  #$2000,sr
+
+.round
+        bsr.w   kernel_alu
+        bsr.w   kernel_muldiv
+        bsr.w   kernel_copy
+        bsr.w   kernel_dispatch
+        bsr.w   kernel_bits
+        addq.l  #1,rounds
+        bra.s   .round
+
+vint
+        movem.l d0-d2/a1,-(sp)
+        bsr.w   show_frame_count
+        move.l  rounds,d0
+        vdp_cmd VRAM_WRITE,VRAM_PLANE_A+2*(2*PLANE_WIDTH+1),d1
+        bsr.w   show_hex
+        movem.l (sp)+,d0-d2/a1
+hint
+        rte
+
+checker_row
+        rept    PLANE_WIDTH/2
+        dc.w    TILE_CHECKER, TILE_CHECKER|$0800
+        endr
+
+; Register arithmetic, logic and shifts
+kernel_alu
+        move.l  checksum,d0
+        move.l  #$9E3779B9,d1
+        moveq   #0,d2
+        move.w  #512-1,d7
+.loop
+        add.l   d1,d0
+        move.l  d0,d3
+        lsl.l   #4,d3
+        eor.l   d3,d0
+        move.l  d0,d3
+        lsr.l   #7,d3
+        sub.l   d3,d0
+        rol.l   #3,d0
+        not.w   d0
+        and.b   d1,d2
+        or.w    d0,d2
+        neg.l   d2
+        dbf     d7,.loop
+        move.l  d0,checksum
+        rts
+
+; 16x16 multiplies and 32/16 divides
+kernel_muldiv
+        move.l  checksum,d0
+        moveq   #1,d4
+        move.w  #128-1,d7
+.loop
+        move.w  d0,d1
+        mulu    #40503,d1
+        move.w  d7,d2
+        muls    d1,d2
+        move.l  d1,d3
+        ori.w   #1,d4
+        divu    d4,d3
+        move.l  d2,d5
+        andi.l  #$7FFFFFFF,d5
+        move.w  d3,d4
+        ori.w   #$100,d4
+        divs    d4,d5
+        add.l   d5,d0
+        swap    d0
+        eor.w   d3,d0
+        addq.w  #7,d4
+        dbf     d7,.loop
+        move.l  d0,checksum
+        rts
+
+; ROM to RAM and RAM to RAM block copies, long moves and movem
+kernel_copy
+        lea     copy_source(pc),a0
+        lea     copy_buffer,a1
+        move.w  #1024/4-1,d7
+.longs
+        move.l  (a0)+,(a1)+
+        dbf     d7,.longs
+        lea     copy_buffer,a0
+        lea     copy_buffer+512,a1
+        moveq   #512/48-1,d7
+.movem
+        movem.l (a0)+,d0-d5/a2-a5/a6
+        movem.l d0-d5/a2-a5/a6,(a1)
+        lea     44(a1),a1
+        dbf     d7,.movem
+        lea     copy_buffer,a0
+        move.w  #512-1,d7
+        moveq   #0,d0
+.bytes
+        add.b   (a0)+,d0
+        dbf     d7,.bytes
+        add.b   d0,checksum+3
+        rts
+
+; Jump table dispatch with subroutine calls, as an interpreter loop would
+kernel_dispatch
+        move.l  checksum,d6
+        move.w  #256-1,d7
+.loop
+        move.w  d6,d0
+        andi.w  #7,d0
+        add.w   d0,d0
+        move.w  dispatch_table(pc,d0.w),d0
+        jsr     dispatch_table(pc,d0.w)
+        ror.l   #5,d6
+        dbf     d7,.loop
+        move.l  d6,checksum
+        rts
+
+dispatch_table
+        dc.w    op_add-dispatch_table, op_sub-dispatch_table
+        dc.w    op_xor-dispatch_table, op_swap-dispatch_table
+        dc.w    op_inc-dispatch_table, op_call-dispatch_table
+        dc.w    op_test-dispatch_table, op_add-dispatch_table
+
+op_add
+        addi.l  #$01234567,d6
+        rts
+op_sub
+        subi.l  #$00FEDCBA,d6
+        rts
+op_xor
+        eori.l  #$5A5A5A5A,d6
+        rts
+op_swap
+        swap    d6
+        rts
+op_inc
+        addq.l  #1,d6
+        rts
+op_call
+        bsr.s   op_add
+        bra.s   op_xor
+op_test
+        tst.b   d6
+        bmi.s   .negative
+        not.l   d6
+        rts
+.negative
+        lsl.l   #1,d6
+        rts
+
+; Bit and byte operations on RAM
+kernel_bits
+        lea     bit_buffer,a0
+        move.l  checksum,d0
+        move.w  #256-1,d7
+.loop
+        move.w  d7,d1
+        andi.w  #255,d1
+        move.b  d0,(a0,d1.w)
+        btst    d1,d0
+        beq.s   .clear
+        bset    #3,(a0,d1.w)
+        bra.s   .next
+.clear
+        bchg    #5,(a0,d1.w)
+.next
+        ror.l   #1,d0
+        tst.b   (a0,d1.w)
+        spl     d2
+        add.b   d2,d0
+        dbf     d7,.loop
+        move.l  d0,checksum
+        rts
+
+copy_source
+        rept    256
+        dc.l    ((*-copy_source)&$FF)*$01010101
+        endr
+
+rom_end
@@ -0,0 +1,177 @@
+; Heavy DMA: every frame 8 KB of tiles from ROM to VRAM (two alternating
+; sources), a 4 KB VRAM fill, a 4 KB VRAM to VRAM copy, the whole CRAM and
+; VSRAM from RAM. About 16 KB per frame, more than fits in the V blank, so
+; the transfers run on into the active display like a busy game's.
+
+rom_name macro
+        dc.b    "BENCH DMA"
+        endm
+        include "common.inc"
+
+STREAM_TILE     equ 256             ; 256 tiles from ROM at $2000
+STREAM_BYTES    equ 8192
+FILL_VRAM       equ $8000           ; 128 filled tiles
+COPY_VRAM       equ $9000           ; 128 tiles copied from the stream
+BLOCK_BYTES     equ 4096
+
+phase           equ RAM_USER
+cram_buffer     equ RAM_USER+$100   ; 64 colors
+vsram_buffer    equ RAM_USER+$200   ; 40 words
+
+main
+        bsr.w   load_common_tiles
+        bsr.w   build_planes
+        move.w  #$2000,sr
+.frame
+        bsr.w   wait_vblank
+        bsr.w   transfer
+        addq.w  #1,phase
+        bsr.w   next_colors
+        bra.s   .frame
+
+vint
+        movem.l d0-d2/a1,-(sp)
+        bsr.w   show_frame_count
+        movem.l (sp)+,d0-d2/a1
+hint
+        rte
+
+; All transfers of a frame
+transfer
+        ; Stream tiles from ROM, a different source every other frame
+        lea     stream_a,a0
+        btst    #0,phase+1
+        beq.s   .source
+        lea     stream_b,a0
+.source
+        move.w  #STREAM_BYTES/2,d1
+        vdp_cmd VRAM_WRITE|DMA_FLAG,STREAM_TILE*32,d0
+        bsr.w   dma_68k
+
+        lea     VDP_CTRL,a1
+        move.w  #$8F01,(a1)         ; Fill and copy step one byte
+
+        ; Fill: length in bytes, then the value through the data port
+        move.w  #$9300|(BLOCK_BYTES&$FF),(a1)
+        move.w  #$9400|(BLOCK_BYTES>>8),(a1)
+        move.w  #$9780,(a1)
+        vdp_cmd VRAM_WRITE|DMA_FLAG,FILL_VRAM,d0
+        move.l  d0,(a1)
+        move.w  phase,d0
+        move.b  d0,d1
+        lsl.w   #8,d0
+        move.b  d1,d0
+        move.w  d0,VDP_DATA
+
+        ; Copy part of the stream (source offset moves each frame)
+        move.w  #$9300|(BLOCK_BYTES&$FF),(a1)
+        move.w  #$9400|(BLOCK_BYTES>>8),(a1)
+        move.w  phase,d0
+        andi.w  #$7F,d0
+        lsl.w   #5,d0
+        addi.w  #STREAM_TILE*32,d0
+        move.w  #$9500,d1
+        move.b  d0,d1
+        move.w  d1,(a1)
+        lsr.w   #8,d0
+        ori.w   #$9600,d0
+        move.w  d0,(a1)
+        move.w  #$97C0,(a1)
+        move.l  #$000000C0|((COPY_VRAM&$3FFF)<<16)|(COPY_VRAM>>14),(a1)
+        move.w  #$8F02,(a1)
+
+        lea     cram_buffer,a0
+        moveq   #64,d1
+        vdp_cmd CRAM_WRITE|DMA_FLAG,0,d0
+        bsr.w   dma_68k
+        lea     vsram_buffer,a0
+        moveq   #40,d1
+        vdp_cmd VSRAM_WRITE|DMA_FLAG,0,d0
+        bra.w   dma_68k
+
+; Rotate the four palette lines and move the vertical scroll for next frame
+next_colors
+        lea     rainbow(pc),a0
+        lea     cram_buffer,a1
+        move.w  phase,d2
+        moveq   #0,d1               ; Color index
+.color
+        move.w  d1,d0
+        add.w   d2,d0
+        andi.w  #15,d0
+        add.w   d0,d0
+        move.w  (a0,d0.w),(a1)+
+        addq.w  #1,d1
+        cmpi.w  #64,d1
+        bne.s   .color
+        clr.w   cram_buffer         ; Black backdrop
+        move.w  #$0EEE,cram_buffer+30
+
+        lea     vsram_buffer,a1
+        moveq   #40/2-1,d1
+.column
+        clr.w   (a1)+
+        move.w  d2,(a1)+
+        dbf     d1,.column
+        rts
+
+; Plane B shows the stream tiles, plane A the filled and copied ones
+build_planes
+        vdp_addr VRAM_WRITE,VRAM_PLANE_B
+        lea     VDP_DATA,a1
+        moveq   #0,d2               ; Row
+.row_b
+        moveq   #0,d3               ; Column
+.cell_b
+        move.w  d2,d0
+        lsl.w   #6,d0
+        add.w   d3,d0
+        andi.w  #255,d0
+        addi.w  #STREAM_TILE|$2000,d0
+        move.w  d0,(a1)
+        addq.w  #1,d3
+        cmpi.w  #PLANE_WIDTH,d3
+        bne.s   .cell_b
+        addq.w  #1,d2
+        cmpi.w  #32,d2
+        bne.s   .row_b
+
+        vdp_addr VRAM_WRITE,VRAM_PLANE_A
+        moveq   #0,d2
+.row_a
+        moveq   #0,d3
+.cell_a
+        moveq   #0,d0
+        move.w  d2,d1
+        eor.w   d3,d1
+        btst    #2,d1
+        beq.s   .put_a
+        move.w  d2,d0
+        lsl.w   #6,d0
+        add.w   d3,d0
+        andi.w  #255,d0
+        addi.w  #FILL_VRAM/32|$4000,d0
+.put_a
+        move.w  d0,(a1)
+        addq.w  #1,d3
+        cmpi.w  #PLANE_WIDTH,d3
+        bne.s   .cell_a
+        addq.w  #1,d2
+        cmpi.w  #32,d2
+        bne.s   .row_a
+        rts
+
+; Two 8 KB tile streams
+        align   1
+stream_a
+        rept    STREAM_BYTES/4
+.i      = (*-stream_a)/4
+        dc.l    ((.i&7)*$11111111)^((.i>>3)*$01230123)&$FFFFFFFF
+        endr
+stream_b
+        rept    STREAM_BYTES/4
+.i      = (*-stream_b)/4
+        dc.l    (((.i>>3)&15)*$10101010)|((.i&7)*$01010101)
+        endr
+
+rom_end
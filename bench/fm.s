@@ -0,0 +1,282 @@
+; FM and PSG: the 68K drives the YM2612 directly with the Z80 off the bus.
+; All six channels play, one per algorithm 0-5, with the LFO, feedback and
+; one SSG-EG channel. Every frame each channel gets a new note and two of
+; them are keyed off and on again. The three PSG tones sweep and the noise
+; channel changes rate, so both chips render something every sample.
+
+rom_name macro
+        dc.b    "BENCH FM PSG"
+        endm
+        include "common.inc"
+
+CHANNELS        equ 6
+NOTES           equ 32
+
+phase           equ RAM_USER
+
+main
+        bsr.w   load_common_tiles
+        moveq   #0,d0
+        bsr.w   load_rainbow
+        lea     stripe_row(pc),a0
+        vdp_cmd VRAM_WRITE,VRAM_PLANE_B,d0
+        moveq   #0,d1
+        bsr.w   fill_plane
+
+        ; Take the bus from the Z80 for good, the 68K writes the YM2612
+        move.w  #$0100,Z80_RESET
+        move.w  #$0100,Z80_BUSREQ
+.bus
+        btst    #0,Z80_BUSREQ
+        bne.s   .bus
+
+        bsr.w   init_ym
+        move.w  #$2000,sr
+.frame
+        bsr.w   wait_vblank
+        addq.w  #1,phase
+        bsr.w   play_fm
+        bsr.w   play_psg
+        bra.s   .frame
+
+vint
+        movem.l d0-d2/a1,-(sp)
+        bsr.w   show_frame_count
+        movem.l (sp)+,d0-d2/a1
+hint
+        rte
+
+stripe_row
+        rept    PLANE_WIDTH/4
+        dc.w    TILE_GRADIENT, TILE_GRADIENT|$0800, TILE_DIAGONAL, TILE_CHECKER
+        endr
+
+; Write d1 to register d0 of the YM2612 port at a0
+ym_write
+.busy
+        btst    #7,YM_ADDR0
+        bne.s   .busy
+        move.b  d0,(a0)
+        move.b  d1,1(a0)
+        rts
+
+; Port of channel d6 in a0, its register offset in d5
+channel_port
+        lea     YM_ADDR0,a0
+        move.w  d6,d5
+        cmpi.w  #3,d5
+        blt.s   .port
+        lea     YM_ADDR1,a0
+        subq.w  #3,d5
+.port
+        rts
+
+; Key on/off code of channel d6 in d1
+key_code
+        move.w  d6,d1
+        cmpi.w  #3,d1
+        blt.s   .code
+        addq.w  #1,d1
+.code
+        rts
+
+; Global registers, all keys off, then a patch per channel
+init_ym
+        lea     YM_ADDR0,a0
+        moveq   #$22,d0
+        moveq   #$0B,d1             ; LFO on, fastest
+        bsr.s   ym_write
+        moveq   #$27,d0
+        moveq   #0,d1               ; Timers off, normal channel 3
+        bsr.s   ym_write
+        moveq   #$2B,d0             ; DAC off
+        bsr.s   ym_write
+        moveq   #0,d6
+.key_off
+        bsr.s   key_code
+        moveq   #$28,d0
+        bsr.s   ym_write
+        addq.w  #1,d6
+        cmpi.w  #CHANNELS,d6
+        bne.s   .key_off
+
+        lea     patches(pc),a2
+        moveq   #0,d6               ; Channel
+.channel
+        bsr.s   channel_port
+        move.w  #$30,d3             ; Register group $30-$90
+.group
+        moveq   #0,d4               ; Operator slot
+.slot
+        move.w  d4,d0
+        lsl.w   #2,d0
+        add.w   d3,d0
+        add.w   d5,d0
+        move.b  (a2)+,d1
+        bsr.s   ym_write
+        addq.w  #1,d4
+        cmpi.w  #4,d4
+        bne.s   .slot
+        addi.w  #$10,d3
+        cmpi.w  #$A0,d3
+        bne.s   .group
+        move.w  #$B0,d0             ; Feedback, algorithm
+        add.w   d5,d0
+        move.b  (a2)+,d1
+        bsr.w   ym_write
+        move.w  #$B4,d0             ; Both speakers, LFO sensitivity
+        add.w   d5,d0
+        move.b  (a2)+,d1
+        bsr.w   ym_write
+        addq.w  #1,d6
+        cmpi.w  #CHANNELS,d6
+        bne.s   .channel
+        rts
+
+; A new note on every channel, the ones with (phase + channel) & 3 == 0 retrigger
+play_fm
+        lea     notes(pc),a2
+        moveq   #0,d6
+.channel
+        bsr.w   channel_port
+        move.w  d6,d2
+        mulu    #5,d2
+        add.w   phase,d2
+        andi.w  #NOTES-1,d2
+        add.w   d2,d2
+        move.w  (a2,d2.w),d2
+        move.w  #$A4,d0             ; Block and frequency high bits first
+        add.w   d5,d0
+        move.w  d2,d1
+        lsr.w   #8,d1
+        bsr.w   ym_write
+        move.w  #$A0,d0
+        add.w   d5,d0
+        move.b  d2,d1
+        bsr.w   ym_write
+
+        move.w  phase,d2
+        add.w   d6,d2
+        andi.w  #3,d2
+        bne.s   .next
+        lea     YM_ADDR0,a0
+        bsr.w   key_code
+        moveq   #$28,d0
+        bsr.w   ym_write
+        ori.b   #$F0,d1
+        bsr.w   ym_write
+.next
+        addq.w  #1,d6
+        cmpi.w  #CHANNELS,d6
+        bne.s   .channel
+        rts
+
+; Sweep the three tone periods and volumes, step the noise rate
+play_psg
+        lea     PSG,a0
+        move.w  phase,d2
+        moveq   #0,d6
+.tone
+        move.w  d6,d1
+        lsl.w   #5,d1               ; Channel field
+        move.w  d6,d0
+        lsl.w   #7,d0
+        add.w   d2,d0
+        add.w   d2,d0
+        andi.w  #$1FF,d0
+        addi.w  #$40,d0             ; Period $40-$23F
+        move.b  d0,d3
+        andi.b  #$0F,d3
+        or.b    d1,d3
+        ori.b   #$80,d3
+        move.b  d3,(a0)
+        lsr.w   #4,d0
+        move.b  d0,(a0)
+        move.w  d2,d3
+        add.w   d6,d3
+        andi.b  #7,d3               ; Attenuation 0-7
+        or.b    d1,d3
+        ori.b   #$90,d3
+        move.b  d3,(a0)
+        addq.w  #1,d6
+        cmpi.w  #3,d6
+        bne.s   .tone
+
+        move.w  d2,d3
+        lsr.w   #3,d3
+        andi.b  #3,d3
+        ori.b   #$E4,d3             ; White noise
+        move.b  d3,(a0)
+        move.w  d2,d3
+        andi.b  #$07,d3
+        ori.b   #$F0,d3
+        move.b  d3,(a0)
+        rts
+
+; Per channel: 7 register groups $30-$90 for operator slots 1, 3, 2, 4,
+; then $B0 (feedback, algorithm) and $B4 (pan, AMS, FMS). Carriers of the
+; channel's algorithm get a low total level.
+patches
+        ; Algorithm 0: one carrier (slot 4)
+        dc.b    $71, $0D, $33, $01
+        dc.b    $23, $2D, $26, $00
+        dc.b    $5F, $99, $5F, $94
+        dc.b    $05, $05, $05, $07
+        dc.b    $02, $02, $02, $02
+        dc.b    $11, $11, $11, $A6
+        dc.b    $00, $00, $00, $00
+        dc.b    $3A, $C0
+        ; Algorithm 1, AM on the carrier
+        dc.b    $01, $02, $04, $01
+        dc.b    $20, $28, $24, $06
+        dc.b    $1F, $1F, $1F, $1F
+        dc.b    $08, $08, $08, $88
+        dc.b    $03, $03, $03, $03
+        dc.b    $27, $27, $27, $27
+        dc.b    $00, $00, $00, $00
+        dc.b    $29, $F3
+        ; Algorithm 2, SSG-EG on every operator
+        dc.b    $02, $01, $03, $01
+        dc.b    $1E, $24, $22, $04
+        dc.b    $1F, $1F, $1F, $1F
+        dc.b    $0A, $0A, $0A, $0A
+        dc.b    $04, $04, $04, $04
+        dc.b    $36, $36, $36, $36
+        dc.b    $08, $0A, $0C, $0E
+        dc.b    $12, $C0
+        ; Algorithm 3, vibrato
+        dc.b    $04, $01, $02, $01
+        dc.b    $22, $1A, $26, $08
+        dc.b    $1F, $1F, $1F, $1F
+        dc.b    $06, $06, $06, $06
+        dc.b    $01, $01, $01, $01
+        dc.b    $17, $17, $17, $17
+        dc.b    $00, $00, $00, $00
+        dc.b    $23, $C7
+        ; Algorithm 4: carriers in slots 2 and 4
+        dc.b    $01, $01, $02, $02
+        dc.b    $24, $24, $08, $08
+        dc.b    $1F, $1F, $1F, $1F
+        dc.b    $05, $05, $05, $05
+        dc.b    $02, $02, $02, $02
+        dc.b    $25, $25, $25, $25
+        dc.b    $00, $00, $00, $00
+        dc.b    $2C, $80
+        ; Algorithm 5: carriers in slots 3, 2 and 4
+        dc.b    $01, $02, $03, $01
+        dc.b    $22, $0A, $0A, $0A
+        dc.b    $1F, $1F, $1F, $1F
+        dc.b    $07, $07, $07, $07
+        dc.b    $02, $02, $02, $02
+        dc.b    $26, $26, $26, $26
+        dc.b    $00, $00, $00, $00
+        dc.b    $3D, $40
+
+; Block and frequency number of a pentatonic scale, blocks 1 to 7
+notes
+        dc.w    $0A84, $0AD3, $0B2B, $0BC5, $0C3B, $1284, $12D3, $132B
+        dc.w    $13C5, $143B, $1A84, $1AD3, $1B2B, $1BC5, $1C3B, $2284
+        dc.w    $22D3, $232B, $23C5, $243B, $2A84, $2AD3, $2B2B, $2BC5
+        dc.w    $2C3B, $3284, $32D3, $332B, $33C5, $343B, $3A84, $3AD3
+
+rom_end
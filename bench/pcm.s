@@ -0,0 +1,142 @@
+; Z80 PCM streaming: a Z80 driver mixes two 8-bit sample streams that
+; live in different 32 KB banks of the 68K space. For every 64 samples it
+; switches the bank window to each stream in turn (9 writes to the bank
+; register), copies a block into Z80 RAM with ldir, then writes the mixed
+; samples to the YM2612 DAC at about 13 kHz. The 68K only waits for V
+; blanks, so the time goes to the Z80 core, its banked ROM reads and the
+; DAC.
+
+rom_name macro
+        dc.b    "BENCH Z80 PCM"
+        endm
+        include "common.inc"
+
+STREAM_BYTES    equ $8000
+BLOCK           equ 64
+DELAY           equ 10              ; Z80 delay loop turns per sample
+
+; Z80 addresses
+Z_OFFSET        equ $1000           ; Stream offset of the next block
+Z_BUF_A         equ $1100
+Z_BUF_B         equ $1100+BLOCK
+
+main
+        bsr.w   load_common_tiles
+        moveq   #0,d0
+        bsr.w   load_rainbow
+        lea     checker_row(pc),a0
+        vdp_cmd VRAM_WRITE,VRAM_PLANE_B,d0
+        moveq   #0,d1
+        bsr.w   fill_plane
+
+        ; Load the driver with the Z80 stopped, then let it run
+        move.w  #$0100,Z80_BUSREQ
+        move.w  #$0100,Z80_RESET
+.bus
+        btst    #0,Z80_BUSREQ
+        bne.s   .bus
+        lea     z80_driver(pc),a0
+        lea     Z80_RAM,a1
+        move.w  #z80_driver_end-z80_driver-1,d0
+.copy
+        move.b  (a0)+,(a1)+
+        dbf     d0,.copy
+        move.w  #$0000,Z80_RESET
+        moveq   #16,d0
+.hold
+        dbf     d0,.hold
+        move.w  #$0000,Z80_BUSREQ
+        move.w  #$0100,Z80_RESET
+
+        move.w  #$2000,sr
+.frame
+        bsr.w   wait_vblank
+        bra.s   .frame
+
+vint
+        movem.l d0-d2/a1,-(sp)
+        bsr.w   show_frame_count
+        movem.l (sp)+,d0-d2/a1
+hint
+        rte
+
+checker_row
+        rept    PLANE_WIDTH/2
+        dc.w    TILE_CHECKER, TILE_CHECKER|$0800
+        endr
+
+; Z80 driver, hand assembled. Addresses are Z80 addresses: label minus
+; z80_driver.
+z80_driver
+        dc.b    $F3                 ; di
+        dc.b    $31, $F0, $1F       ; ld sp,$1FF0
+        dc.b    $3E, $2B            ; ld a,$2B
+        dc.b    $32, $00, $40       ; ld ($4000),a
+        dc.b    $3E, $80            ; ld a,$80          DAC on
+        dc.b    $32, $01, $40       ; ld ($4001),a
+        dc.b    $3E, $2A            ; ld a,$2A          DAC data stays latched
+        dc.b    $32, $00, $40       ; ld ($4000),a
+        dc.b    $21, $00, $00       ; ld hl,0
+        dc.b    $22, Z_OFFSET&$FF, Z_OFFSET>>8 ; ld (offset),hl
+.block
+        dc.b    $3E, stream_a>>15   ; ld a,bank of stream A
+        dc.b    $CD, (.set_bank-z80_driver)&$FF, (.set_bank-z80_driver)>>8 ; call set_bank
+        dc.b    $2A, Z_OFFSET&$FF, Z_OFFSET>>8 ; ld hl,(offset)
+        dc.b    $CB, $FC            ; set 7,h           bank window at $8000
+        dc.b    $11, Z_BUF_A&$FF, Z_BUF_A>>8 ; ld de,buf_a
+        dc.b    $01, BLOCK, 0       ; ld bc,BLOCK
+        dc.b    $ED, $B0            ; ldir
+        dc.b    $3E, stream_b>>15   ; ld a,bank of stream B
+        dc.b    $CD, (.set_bank-z80_driver)&$FF, (.set_bank-z80_driver)>>8 ; call set_bank
+        dc.b    $2A, Z_OFFSET&$FF, Z_OFFSET>>8 ; ld hl,(offset)
+        dc.b    $CB, $FC            ; set 7,h
+        dc.b    $11, Z_BUF_B&$FF, Z_BUF_B>>8 ; ld de,buf_b
+        dc.b    $01, BLOCK, 0       ; ld bc,BLOCK
+        dc.b    $ED, $B0            ; ldir
+        dc.b    $2A, Z_OFFSET&$FF, Z_OFFSET>>8 ; ld hl,(offset)
+        dc.b    $01, BLOCK, 0       ; ld bc,BLOCK
+        dc.b    $09                 ; add hl,bc
+        dc.b    $CB, $BC            ; res 7,h           wrap at 32 KB
+        dc.b    $22, Z_OFFSET&$FF, Z_OFFSET>>8 ; ld (offset),hl
+        dc.b    $21, Z_BUF_A&$FF, Z_BUF_A>>8 ; ld hl,buf_a
+        dc.b    $11, Z_BUF_B&$FF, Z_BUF_B>>8 ; ld de,buf_b
+        dc.b    $06, BLOCK          ; ld b,BLOCK
+.sample
+        dc.b    $1A                 ; ld a,(de)
+        dc.b    $86                 ; add a,(hl)
+        dc.b    $1F                 ; rra               average with the carry
+        dc.b    $32, $01, $40       ; ld ($4001),a
+        dc.b    $23                 ; inc hl
+        dc.b    $13                 ; inc de
+        dc.b    $0E, DELAY          ; ld c,DELAY
+.delay
+        dc.b    $0D                 ; dec c
+        dc.b    $20, (.delay-(*+2))&$FF ; jr nz,.delay
+        dc.b    $10, (.sample-(*+2))&$FF ; djnz .sample
+        dc.b    $18, (.block-(*+2))&$FF ; jr .block
+; Bank register: a holds bits 15-22 of the 68K address, bit 23 is 0
+.set_bank
+        dc.b    $21, $00, $60       ; ld hl,$6000
+        rept    8
+        dc.b    $77, $0F            ; ld (hl),a / rrca
+        endr
+        dc.b    $75                 ; ld (hl),l
+        dc.b    $C9                 ; ret
+z80_driver_end
+        even
+
+; Sample streams, unsigned 8-bit, each filling a bank: a 32-sample
+; sawtooth and a 48-sample square wave
+        org     $10000
+stream_a
+        rept    STREAM_BYTES/4
+.i      = *-stream_a
+        dc.b    (.i*8)&255, (.i*8+8)&255, (.i*8+16)&255, (.i*8+24)&255
+        endr
+stream_b
+        rept    STREAM_BYTES/4
+.i      = *-stream_b
+        dc.b    80+96*((.i/24)&1), 80+96*(((.i+1)/24)&1), 80+96*(((.i+2)/24)&1), 80+96*(((.i+3)/24)&1)
+        endr
+
+rom_end
@@ -0,0 +1,133 @@
+; Plane scroll stress: per-line horizontal scroll of both planes and
+; vertical scroll per 2-cell column, both driven by sine tables that change
+; every frame, with a window over the top 3 rows. The scroll tables are
+; computed in RAM during the frame and sent by DMA in the V blank.
+
+rom_name macro
+        dc.b    "BENCH PLANE SCROLL"
+        endm
+        include "common.inc"
+
+LINES           equ 224
+COLUMNS         equ 20              ; 2-cell columns of H40
+WINDOW_ROWS     equ 3
+
+phase           equ RAM_USER
+hscroll_buffer  equ RAM_USER+$100   ; LINES * (A, B) words
+vscroll_buffer  equ RAM_USER+$500   ; COLUMNS * (A, B) words
+
+main
+        bsr.w   load_common_tiles
+        moveq   #3,d7
+.palettes
+        move.w  d7,d0
+        bsr.w   load_rainbow
+        dbf     d7,.palettes
+
+        move.w  #$8B07,VDP_CTRL     ; Line horizontal scroll, 2-cell vertical scroll
+        move.w  #$9200|WINDOW_ROWS,VDP_CTRL
+
+        ; Plane B: a new palette line every row, plane A: a sparse grid
+        lea     gradient_row(pc),a0
+        vdp_cmd VRAM_WRITE,VRAM_PLANE_B,d0
+        move.w  #$2000,d1
+        bsr.w   fill_plane
+        lea     grid_row(pc),a0
+        vdp_cmd VRAM_WRITE,VRAM_PLANE_A,d0
+        moveq   #0,d1
+        bsr.w   fill_plane
+        lea     window_row(pc),a0
+        vdp_cmd VRAM_WRITE,VRAM_WINDOW,d0
+        moveq   #0,d1
+        bsr.w   fill_plane
+
+        bsr.w   compute_scroll
+        move.w  #$2000,sr
+.frame
+        bsr.w   wait_vblank
+        addq.w  #1,phase
+        bsr.w   compute_scroll
+        bra.s   .frame
+
+vint
+        movem.l d0-d3/a0-a1,-(sp)
+        lea     hscroll_buffer,a0
+        move.w  #LINES*2,d1
+        vdp_cmd VRAM_WRITE|DMA_FLAG,VRAM_HSCROLL,d0
+        bsr.w   dma_68k
+        lea     vscroll_buffer,a0
+        move.w  #COLUMNS*2,d1
+        vdp_cmd VSRAM_WRITE|DMA_FLAG,0,d0
+        bsr.w   dma_68k
+        move.l  frame_count,d0
+        vdp_cmd VRAM_WRITE,VRAM_WINDOW+2*(PLANE_WIDTH+1),d1
+        bsr.w   show_hex
+        movem.l (sp)+,d0-d3/a0-a1
+hint
+        rte
+
+gradient_row
+        rept    PLANE_WIDTH/8
+        dc.w    TILE_GRADIENT, TILE_GRADIENT, TILE_CHECKER, TILE_GRADIENT
+        dc.w    TILE_GRADIENT|$1000, TILE_GRADIENT|$1000, TILE_CHECKER|$0800, TILE_DIAGONAL
+        endr
+grid_row
+        rept    PLANE_WIDTH/4
+        dc.w    TILE_FRAME|$8000, 0, TILE_BALL|$4000, 0
+        endr
+window_row
+        rept    PLANE_WIDTH
+        dc.w    12|$6000
+        endr
+
+; Scroll tables of the frame after phase
+compute_scroll
+        lea     sine(pc),a0
+        lea     hscroll_buffer,a1
+        move.w  phase,d5
+        move.w  #LINES-1,d7
+        moveq   #0,d6               ; Line
+.line
+        ; Plane A: fast ripple, plane B: slow wave plus a constant drift
+        move.w  d6,d0
+        add.w   d0,d0
+        add.w   d5,d0
+        add.w   d5,d0
+        andi.w  #255,d0
+        add.w   d0,d0
+        move.w  (a0,d0.w),d1
+        asr.w   #2,d1
+        move.w  d1,(a1)+
+        move.w  d6,d0
+        add.w   d5,d0
+        andi.w  #255,d0
+        add.w   d0,d0
+        move.w  (a0,d0.w),d1
+        asr.w   #3,d1
+        sub.w   d5,d1
+        move.w  d1,(a1)+
+        addq.w  #1,d6
+        dbf     d7,.line
+
+        lea     vscroll_buffer,a1
+        moveq   #COLUMNS-1,d7
+        moveq   #0,d6               ; Column
+.column
+        move.w  d6,d0
+        lsl.w   #4,d0
+        add.w   d5,d0
+        add.w   d5,d0
+        add.w   d5,d0
+        andi.w  #255,d0
+        add.w   d0,d0
+        move.w  (a0,d0.w),d1
+        asr.w   #3,d1
+        move.w  d1,(a1)+
+        move.w  d5,d1
+        asr.w   #1,d1
+        move.w  d1,(a1)+
+        addq.w  #1,d6
+        dbf     d7,.column
+        rts
+
+rom_end
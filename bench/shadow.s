@@ -0,0 +1,135 @@
+; Shadow/highlight: the mode is on and plane A mixes high and low priority
+; tiles over a low priority plane B, so lines mix normal and shadowed
+; pixels. 20 highlight and 20 shadow operator sprites (palette line 3
+; colors 14 and 15) and 24 normal sprites sweep over the screen.
+
+rom_name macro
+        dc.b    "BENCH SHADOW HIGHLIGHT"
+        endm
+        include "common.inc"
+
+SPRITES         equ 64
+HIGHLIGHTS      equ 20
+SHADOWS         equ 20
+HIGHLIGHT_TILE  equ 96              ; 16 tiles of color 14
+SHADOW_TILE     equ 112             ; 16 tiles of color 15
+
+phase           equ RAM_USER
+sat_buffer      equ RAM_USER+$100   ; SPRITES * 8 bytes
+
+main
+        bsr.w   load_common_tiles
+        moveq   #3,d7
+.palettes
+        move.w  d7,d0
+        bsr.w   load_rainbow
+        dbf     d7,.palettes
+
+        ; Operator sprite tiles
+        vdp_addr VRAM_WRITE,HIGHLIGHT_TILE*32
+        lea     VDP_DATA,a0
+        move.w  #16*8-1,d0
+.highlight
+        move.l  #$EEEEEEEE,(a0)
+        dbf     d0,.highlight
+        move.w  #16*8-1,d0
+.shadow
+        move.l  #$FFFFFFFF,(a0)
+        dbf     d0,.shadow
+
+        move.w  #$8C89,VDP_CTRL     ; 320 pixels, shadow/highlight
+
+        lea     gradient_row(pc),a0
+        vdp_cmd VRAM_WRITE,VRAM_PLANE_B,d0
+        move.w  #$2000,d1
+        bsr.w   fill_plane
+        lea     priority_row(pc),a0
+        vdp_cmd VRAM_WRITE,VRAM_PLANE_A,d0
+        moveq   #0,d1
+        bsr.w   fill_plane
+
+        bsr.w   build_sprites
+        move.w  #$2000,sr
+.frame
+        bsr.w   wait_vblank
+        addq.w  #1,phase
+        bsr.w   build_sprites
+        bra.s   .frame
+
+vint
+        movem.l d0-d3/a0-a1,-(sp)
+        lea     sat_buffer,a0
+        move.w  #SPRITES*8/2,d1
+        vdp_cmd VRAM_WRITE|DMA_FLAG,VRAM_SPRITES,d0
+        bsr.w   dma_68k
+        bsr.w   show_frame_count
+        movem.l (sp)+,d0-d3/a0-a1
+hint
+        rte
+
+gradient_row
+        rept    PLANE_WIDTH/4
+        dc.w    TILE_GRADIENT, TILE_GRADIENT|$0800, TILE_CHECKER, TILE_BALL
+        endr
+priority_row
+        rept    PLANE_WIDTH/8
+        dc.w    TILE_DIAGONAL|$8000, TILE_DIAGONAL|$8000, 0, TILE_FRAME|$2000
+        dc.w    TILE_FRAME|$A000, 0, 0, TILE_CHECKER|$4000
+        endr
+
+; Sprite table for the frame after phase: sprites on Lissajous curves
+build_sprites
+        lea     sine(pc),a0
+        lea     sat_buffer,a1
+        move.w  phase,d5
+        moveq   #0,d6
+.sprite
+        move.w  d6,d0
+        lsl.w   #3,d0
+        add.w   d5,d0
+        andi.w  #255,d0
+        add.w   d0,d0
+        move.w  (a0,d0.w),d3
+        asr.w   #1,d3
+        addi.w  #128+144,d3         ; x
+        move.w  d6,d0
+        mulu    #20,d0
+        add.w   d5,d0
+        add.w   d5,d0
+        add.w   d5,d0
+        addi.w  #64,d0
+        andi.w  #255,d0
+        add.w   d0,d0
+        move.w  (a0,d0.w),d2
+        asr.w   #2,d2
+        addi.w  #128+96,d2          ; y
+        move.w  d2,(a1)+
+
+        move.w  d6,d1
+        addq.w  #1,d1
+        cmpi.w  #SPRITES,d1
+        bne.s   .link
+        moveq   #0,d1
+.link
+        cmpi.w  #HIGHLIGHTS+SHADOWS,d6
+        bge.s   .normal
+        ori.w   #$0F00,d1           ; Operators: 4x4 cells
+        move.w  d1,(a1)+
+        move.w  #HIGHLIGHT_TILE|$6000,d1
+        cmpi.w  #HIGHLIGHTS,d6
+        blt.s   .attributes
+        move.w  #SHADOW_TILE|$6000,d1
+        bra.s   .attributes
+.normal
+        ori.w   #$0500,d1           ; 2x2 cells: ball, diagonal, frame, gradient
+        move.w  d1,(a1)+
+        move.w  #TILE_BALL|$2000,d1
+.attributes
+        move.w  d1,(a1)+
+        move.w  d3,(a1)+
+        addq.w  #1,d6
+        cmpi.w  #SPRITES,d6
+        bne.s   .sprite
+        rts
+
+rom_end
@@ -0,0 +1,234 @@
+; Sprite stress: all 80 sprites of H40 mode, 32x32 each, over two
+; scrolled planes. 24 of them share a band of lines, past the limits of
+; 20 sprites and 320 sprite pixels per line; the others bounce across the
+; screen. The sprite table is built in RAM and sent by DMA every V blank.
+
+rom_name macro
+        dc.b    "BENCH SPRITES"
+        endm
+        include "common.inc"
+
+SPRITES         equ 80
+BAND_SPRITES    equ 24
+BAND_TOP        equ 96
+BAND_BOTTOM     equ 112
+SPRITE_SIZE     equ 32
+SPRITE_TILE     equ 64              ; 16 tiles of the ball, column-major
+
+sat_buffer      equ RAM_USER        ; SPRITES * 8 bytes
+motion          equ RAM_USER+$400   ; SPRITES * (x, y, dx, dy) words
+scroll          equ RAM_USER+$800
+
+main
+        bsr.w   load_common_tiles
+        moveq   #3,d7
+.palettes
+        move.w  d7,d0
+        bsr.w   load_rainbow
+        dbf     d7,.palettes
+        bsr.w   make_ball
+
+        lea     checker_row(pc),a0
+        vdp_cmd VRAM_WRITE,VRAM_PLANE_B,d0
+        moveq   #0,d1
+        bsr.w   fill_plane
+        lea     frame_row(pc),a0
+        vdp_cmd VRAM_WRITE,VRAM_PLANE_A,d0
+        moveq   #0,d1
+        bsr.w   fill_plane
+
+        bsr.w   init_sprites
+        move.w  #$2000,sr
+.frame
+        bsr.w   wait_vblank
+        bsr.w   move_sprites
+        bra.s   .frame
+
+vint
+        movem.l d0-d3/a0-a1,-(sp)
+        lea     sat_buffer,a0
+        move.w  #SPRITES*8/2,d1
+        vdp_cmd VRAM_WRITE|DMA_FLAG,VRAM_SPRITES,d0
+        bsr.w   dma_68k
+        ; Plane B drifts left, plane A right
+        vdp_addr VRAM_WRITE,VRAM_HSCROLL
+        move.w  scroll,d0
+        addq.w  #1,d0
+        move.w  d0,scroll
+        move.w  d0,VDP_DATA
+        neg.w   d0
+        move.w  d0,VDP_DATA
+        bsr.w   show_frame_count
+        movem.l (sp)+,d0-d3/a0-a1
+hint
+        rte
+
+checker_row
+        rept    PLANE_WIDTH/2
+        dc.w    TILE_CHECKER|$2000, TILE_CHECKER|$2800
+        endr
+frame_row
+        rept    PLANE_WIDTH/4
+        dc.w    TILE_FRAME|$4000, 0, TILE_DIAGONAL|$6000, 0
+        endr
+
+; Draw a 32x32 shaded ball into tiles SPRITE_TILE.. in sprite order
+; (down each tile column first)
+make_ball
+        vdp_addr VRAM_WRITE,SPRITE_TILE*32
+        lea     VDP_DATA,a0
+        moveq   #0,d6               ; Tile column
+.column
+        moveq   #0,d5               ; Tile row
+.tile
+        moveq   #0,d4               ; Pixel row in the tile
+.row
+        move.w  d5,d3
+        lsl.w   #3,d3
+        add.w   d4,d3
+        subi.w  #SPRITE_SIZE/2,d3
+        muls    d3,d3               ; dy^2
+        moveq   #0,d2               ; 8 pixels
+        moveq   #0,d7
+.pixel
+        move.w  d6,d0
+        lsl.w   #3,d0
+        add.w   d7,d0
+        subi.w  #SPRITE_SIZE/2,d0
+        muls    d0,d0
+        add.l   d3,d0               ; Distance^2 from the center
+        lsl.l   #4,d2
+        cmpi.l  #240,d0
+        bge.s   .outside
+        lsr.w   #4,d0
+        moveq   #15,d1
+        sub.w   d0,d1               ; Bright center, darker edge
+        or.b    d1,d2
+.outside
+        addq.w  #1,d7
+        cmpi.w  #8,d7
+        bne.s   .pixel
+        move.l  d2,(a0)
+        addq.w  #1,d4
+        cmpi.w  #8,d4
+        bne.s   .row
+        addq.w  #1,d5
+        cmpi.w  #4,d5
+        bne.s   .tile
+        addq.w  #1,d6
+        cmpi.w  #4,d6
+        bne.s   .column
+        rts
+
+; Random start positions and speeds, the band sprites spread over its width
+init_sprites
+        lea     motion,a2
+        moveq   #0,d6
+.sprite
+        bsr.w   random
+        move.l  d0,d5
+        cmpi.w  #BAND_SPRITES,d6
+        bge.s   .free
+        move.w  d6,d1
+        mulu    #(320-SPRITE_SIZE)/BAND_SPRITES,d1
+        move.w  d1,(a2)+            ; x
+        move.w  d5,d1
+        andi.w  #BAND_BOTTOM-BAND_TOP-1,d1
+        addi.w  #BAND_TOP,d1
+        move.w  d1,(a2)+            ; y
+        clr.w   (a2)+               ; dx
+        bra.s   .dy
+.free
+        moveq   #0,d1
+        move.w  d5,d1
+        divu    #320-SPRITE_SIZE,d1
+        swap    d1
+        move.w  d1,(a2)+            ; x
+        swap    d5
+        moveq   #0,d1
+        move.w  d5,d1
+        divu    #224-SPRITE_SIZE,d1
+        swap    d1
+        move.w  d1,(a2)+            ; y
+        move.w  d5,d1
+        andi.w  #3,d1
+        addq.w  #1,d1
+        btst    #8,d5
+        beq.s   .dx
+        neg.w   d1
+.dx
+        move.w  d1,(a2)+
+.dy
+        move.w  d5,d1
+        lsr.w   #4,d1
+        andi.w  #1,d1
+        addq.w  #1,d1
+        btst    #9,d5
+        beq.s   .dy_sign
+        neg.w   d1
+.dy_sign
+        move.w  d1,(a2)+
+        addq.w  #1,d6
+        cmpi.w  #SPRITES,d6
+        bne.s   .sprite
+        rts
+
+; Bounce every sprite and write its table entry
+move_sprites
+        lea     motion,a2
+        lea     sat_buffer,a3
+        moveq   #0,d6
+.sprite
+        movem.w (a2),d0-d3          ; x, y, dx, dy
+        add.w   d2,d0
+        bmi.s   .flip_x
+        cmpi.w  #320-SPRITE_SIZE,d0
+        ble.s   .x_done
+.flip_x
+        neg.w   d2
+        add.w   d2,d0
+        add.w   d2,d0
+.x_done
+        add.w   d3,d1
+        move.w  #BAND_TOP,d4
+        move.w  #BAND_BOTTOM,d5
+        cmpi.w  #BAND_SPRITES,d6
+        blt.s   .limits
+        moveq   #0,d4
+        move.w  #224-SPRITE_SIZE,d5
+.limits
+        cmp.w   d4,d1
+        blt.s   .flip_y
+        cmp.w   d5,d1
+        ble.s   .y_done
+.flip_y
+        neg.w   d3
+        add.w   d3,d1
+        add.w   d3,d1
+.y_done
+        movem.w d0-d3,(a2)
+        addq.l  #8,a2
+
+        addi.w  #128,d1
+        move.w  d1,(a3)+            ; y
+        move.w  d6,d1
+        addq.w  #1,d1
+        cmpi.w  #SPRITES,d1
+        bne.s   .link
+        moveq   #0,d1
+.link
+        ori.w   #$0F00,d1           ; 4x4 cells
+        move.w  d1,(a3)+
+        move.w  d6,d1
+        andi.w  #3,d1
+        ror.w   #3,d1               ; Palette line from the sprite number
+        ori.w   #SPRITE_TILE,d1
+        move.w  d1,(a3)+
+        addi.w  #128,d0
+        move.w  d0,(a3)+            ; x
+        addq.w  #1,d6
+        cmpi.w  #SPRITES,d6
+        bne.s   .sprite
+        rts
+
+rom_end
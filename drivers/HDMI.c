@@ -97,8 +97,14 @@ int get_video_mode() {
     return 0;
 }
 
+static void (*vsync_callback)(void) = NULL;
+
+void graphics_set_vsync_callback(void (*callback)(void)) {
+    vsync_callback = callback;
+}
+
 void vsync_handler() {
-    // Optional: Add vsync callback if needed
+    if (vsync_callback) vsync_callback();
 }
 
 // --- New HDMI Driver Code ---
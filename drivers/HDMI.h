@@ -67,6 +67,9 @@ void set_palette(uint8_t n); // переключение палитр
 struct video_mode_t graphics_get_video_mode(int mode);
 void graphics_set_bgcolor(uint32_t color888);
 
+// Called from the video DMA interrupt at the start of every frame
+void graphics_set_vsync_callback(void (*callback)(void));
+
 // Runtime CRT scanline effect control
 void graphics_set_crt_effect(bool enabled, uint8_t dim_percent);
 bool graphics_get_crt_enabled(void);
@@ -398,6 +398,27 @@ bool audio_is_initialized(void) {
     return audio_initialized;
 }
 
+void audio_get_fill(uint32_t *queued, uint32_t *capacity) {
+    *capacity = DMA_BUFFER_COUNT * dma_transfer_count;
+    *queued = 0;
+    if (!audio_initialized) return;
+
+    // A buffer is queued from its claim until its channel finished it: the
+    // playing one counts what is left, the one chained after it counts whole
+    uint32_t irq_state = save_and_disable_interrupts();
+    uint32_t free_mask = dma_buffers_free_mask;
+    const int channels[DMA_BUFFER_COUNT] = {dma_channel_a, dma_channel_b};
+    for (int i = 0; i < DMA_BUFFER_COUNT; i++) {
+        if (free_mask & (1u << i)) continue;
+        if (audio_running && channels[i] >= 0 && dma_channel_is_busy(channels[i])) {
+            *queued += dma_channel_hw_addr(channels[i])->transfer_count & 0x0FFFFFFFu;
+        } else {
+            *queued += dma_transfer_count;
+        }
+    }
+    restore_interrupts(irq_state);
+}
+
 // Target samples per frame for consistent DMA timing
 #define TARGET_SAMPLES_NTSC 888
 #define FADE_SAMPLES 32  // Samples to crossfade at frame boundary (increased for smoother transition)
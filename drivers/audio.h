@@ -66,6 +66,10 @@ void audio_shutdown(void);
 // Check if audio is initialized
 bool audio_is_initialized(void);
 
+// Stereo frames queued for output (claimed DMA buffers not played yet)
+// and the capacity of the two buffers
+void audio_get_fill(uint32_t *queued, uint32_t *capacity);
+
 // Submit mixed audio buffer to I2S (call once per frame)
 // This mixes YM2612 and SN76489 outputs and sends to I2S
 void audio_submit(void);
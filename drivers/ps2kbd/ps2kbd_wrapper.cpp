@@ -57,6 +57,8 @@ static bool queue_pop(uint8_t* pressed, uint8_t* key) {
 #define GENESIS_KEY_MODE   0x0C
 #define GENESIS_KEY_SELECT 0x0D
 #define GENESIS_KEY_ESC    0x0E
+#define GENESIS_KEY_SAVE   0x0F
+#define GENESIS_KEY_LOAD   0x10
 
 // HID to Genesis key mapping
 // Key mapping:
@@ -67,6 +69,7 @@ static bool queue_pop(uint8_t* pressed, uint8_t* key) {
 //   Space      -> Select
 //   Alt        -> Mode (6-button)
 //   ESC        -> Settings menu
+//   F5, F8     -> Quick save, quick load
 // Returns 0 if no mapping
 static unsigned char hid_to_genesis(uint8_t code) {
     switch (code) {
@@ -100,6 +103,10 @@ static unsigned char hid_to_genesis(uint8_t code) {
         // ESC = Settings menu / Back
         case 0x29: return GENESIS_KEY_ESC;    // Escape
         
+        // Quick-save slots
+        case 0x3E: return GENESIS_KEY_SAVE;   // F5
+        case 0x41: return GENESIS_KEY_LOAD;   // F8
+        
         default: return 0;
     }
 }
@@ -160,6 +167,8 @@ static uint16_t key_to_state_bit(uint8_t key) {
         case GENESIS_KEY_MODE:   return KBD_STATE_MODE;
         case GENESIS_KEY_SELECT: return KBD_STATE_SELECT;
         case GENESIS_KEY_ESC:    return KBD_STATE_ESC;
+        case GENESIS_KEY_SAVE:   return KBD_STATE_SAVE;
+        case GENESIS_KEY_LOAD:   return KBD_STATE_LOAD;
         default: return 0;
     }
 }
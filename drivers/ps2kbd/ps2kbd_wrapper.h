@@ -20,6 +20,8 @@ extern "C" {
 #define GENESIS_KEY_MODE   0x0C
 #define GENESIS_KEY_SELECT 0x0D
 #define GENESIS_KEY_ESC    0x0E
+#define GENESIS_KEY_SAVE   0x0F
+#define GENESIS_KEY_LOAD   0x10
 
 // Keyboard state bits for ps2kbd_get_state()
 #define KBD_STATE_UP     (1 << 0)
@@ -36,6 +38,8 @@ extern "C" {
 #define KBD_STATE_MODE   (1 << 11)
 #define KBD_STATE_SELECT (1 << 12)
 #define KBD_STATE_ESC    (1 << 13)
+#define KBD_STATE_SAVE   (1 << 14)
+#define KBD_STATE_LOAD   (1 << 15)
 
 void ps2kbd_init(void);
 void ps2kbd_tick(void);
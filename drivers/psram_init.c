@@ -10,20 +10,8 @@
 #define PSRAM_MAX_FREQ_MHZ 133
 #endif
 
-// Internal function that does the actual PSRAM initialization with a specified max frequency
-static void __no_inline_not_in_flash_func(psram_init_internal)(uint cs_pin, int max_psram_freq) {
-    const int clock_hz = clock_get_hz(clk_sys); 
-
-    gpio_set_function(cs_pin, GPIO_FUNC_XIP_CS1);
-
-    qmi_hw->direct_csr = 10 << QMI_DIRECT_CSR_CLKDIV_LSB | 
-                        QMI_DIRECT_CSR_EN_BITS | 
-                        QMI_DIRECT_CSR_AUTO_CS1N_BITS;
-    while (qmi_hw->direct_csr & QMI_DIRECT_CSR_BUSY_BITS);
-
-    const uint CMD_QPI_EN = 0x35; 
-    qmi_hw->direct_tx = QMI_DIRECT_TX_NOPUSH_BITS | CMD_QPI_EN;
-    while (qmi_hw->direct_csr & QMI_DIRECT_CSR_BUSY_BITS);
+void __no_inline_not_in_flash_func(psram_timing_for_freq)(uint32_t max_psram_freq, psram_timing_t *timing) {
+    const int clock_hz = clock_get_hz(clk_sys);
 
     int divisor = (clock_hz + max_psram_freq - 1) / max_psram_freq;
     if (divisor == 1 && clock_hz > 100000000) {
@@ -35,19 +23,53 @@ static void __no_inline_not_in_flash_func(psram_init_internal)(uint cs_pin, int
         rxdelay += 1; 
     }
 
+    timing->clkdiv = divisor;
+    timing->rxdelay = rxdelay;
+    timing->cooldown = 1;
+}
+
+void __no_inline_not_in_flash_func(psram_set_timing)(const psram_timing_t *timing) {
+    const int clock_hz = clock_get_hz(clk_sys); 
     const int clock_period_fs = 1000000000000000ll / clock_hz;
     
+    // 8 us maximum CS low time (units of 64 clocks), 18 ns minimum CS high
     const int max_select_val = (125 * 1000000) / clock_period_fs;
 
-    const int min_deselect = (18 * 1000000 + (clock_period_fs - 1)) / clock_period_fs - (divisor + 1) / 2;
+    const int min_deselect = (18 * 1000000 + (clock_period_fs - 1)) / clock_period_fs - (timing->clkdiv + 1) / 2;
 
     qmi_hw->m[1].timing = 
-        1 << QMI_M1_TIMING_COOLDOWN_LSB | 
+        timing->cooldown << QMI_M1_TIMING_COOLDOWN_LSB | 
         QMI_M1_TIMING_PAGEBREAK_VALUE_1024 << QMI_M1_TIMING_PAGEBREAK_LSB | 
         max_select_val << QMI_M1_TIMING_MAX_SELECT_LSB | 
         min_deselect << QMI_M1_TIMING_MIN_DESELECT_LSB | 
-        rxdelay << QMI_M1_TIMING_RXDELAY_LSB | 
-        divisor << QMI_M1_TIMING_CLKDIV_LSB;
+        timing->rxdelay << QMI_M1_TIMING_RXDELAY_LSB | 
+        timing->clkdiv << QMI_M1_TIMING_CLKDIV_LSB;
+}
+
+void __no_inline_not_in_flash_func(psram_get_timing)(psram_timing_t *timing) {
+    const uint32_t t = qmi_hw->m[1].timing;
+    timing->clkdiv = (t & QMI_M1_TIMING_CLKDIV_BITS) >> QMI_M1_TIMING_CLKDIV_LSB;
+    timing->rxdelay = (t & QMI_M1_TIMING_RXDELAY_BITS) >> QMI_M1_TIMING_RXDELAY_LSB;
+    timing->cooldown = (t & QMI_M1_TIMING_COOLDOWN_BITS) >> QMI_M1_TIMING_COOLDOWN_LSB;
+}
+
+// Internal function that does the actual PSRAM initialization with a specified max frequency
+static void __no_inline_not_in_flash_func(psram_init_internal)(uint cs_pin, int max_psram_freq) {
+
+    gpio_set_function(cs_pin, GPIO_FUNC_XIP_CS1);
+
+    qmi_hw->direct_csr = 10 << QMI_DIRECT_CSR_CLKDIV_LSB | 
+                        QMI_DIRECT_CSR_EN_BITS | 
+                        QMI_DIRECT_CSR_AUTO_CS1N_BITS;
+    while (qmi_hw->direct_csr & QMI_DIRECT_CSR_BUSY_BITS);
+
+    const uint CMD_QPI_EN = 0x35; 
+    qmi_hw->direct_tx = QMI_DIRECT_TX_NOPUSH_BITS | CMD_QPI_EN;
+    while (qmi_hw->direct_csr & QMI_DIRECT_CSR_BUSY_BITS);
+
+    psram_timing_t timing;
+    psram_timing_for_freq(max_psram_freq, &timing);
+    psram_set_timing(&timing);
 
     qmi_hw->m[1].rfmt =
         QMI_M0_RFMT_PREFIX_WIDTH_VALUE_Q << QMI_M0_RFMT_PREFIX_WIDTH_LSB | 
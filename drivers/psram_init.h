@@ -9,4 +9,20 @@ void psram_init(uint cs_pin);
 // Initialize PSRAM with runtime-specified frequency (in MHz)
 void psram_init_with_freq(uint cs_pin, uint16_t max_freq_mhz);
 
+// QMI M1 timing fields that vary with the chip and the system clock
+typedef struct {
+    uint8_t clkdiv;     // SCK = clk_sys / clkdiv
+    uint8_t rxdelay;    // Read sample delay, half clk_sys cycles (0-7)
+    uint8_t cooldown;   // CS held after a transfer for a sequential one, 64 clk_sys units (0-3)
+} psram_timing_t;
+
+// Timing the init functions derive for a maximum SCK at the current clock
+void psram_timing_for_freq(uint32_t max_freq_hz, psram_timing_t *timing);
+
+// Program the M1 timing (max_select, min_deselect follow from clk_sys)
+void psram_set_timing(const psram_timing_t *timing);
+
+// Current M1 timing
+void psram_get_timing(psram_timing_t *timing);
+
 #endif
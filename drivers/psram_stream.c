@@ -0,0 +1,95 @@
+#include "psram_stream.h"
+#include "pico/stdlib.h"
+#include "hardware/dma.h"
+#include "hardware/sync.h"
+#include <string.h>
+
+// XIP cache maintenance: a byte write to XIP_MAINTENANCE_BASE + offset + op
+// acts on the line holding XIP_BASE + offset
+#define XIP_MAINTENANCE_OFFSET 0x08000000u   // XIP_MAINTENANCE_BASE - XIP_BASE
+#define XIP_CACHE_LINE         8u
+#define XIP_OP_INVALIDATE      2u            // By address
+#define XIP_OP_CLEAN           3u            // By address, line stays valid
+
+// Below this a CPU copy is cheaper than setting up the DMA
+#define DMA_MIN_BYTES 64
+
+static psram_stream_stats_t stats;
+static int dma_channels[NUM_CORES] = { -1, -1 };   // One per core, claimed once
+
+static inline bool is_psram(const void *p) {
+    return (uintptr_t)p - PSRAM_CACHED_BASE < PSRAM_WINDOW_SIZE;
+}
+
+static void __not_in_flash_func(cache_maintain)(const void *p, size_t len, uint32_t op) {
+    uintptr_t line = (uintptr_t)p & ~(uintptr_t)(XIP_CACHE_LINE - 1);
+    uintptr_t end = (uintptr_t)p + len;
+    for (; line < end; line += XIP_CACHE_LINE) {
+        *(volatile uint8_t *)(line + XIP_MAINTENANCE_OFFSET + op) = 0;
+    }
+    __dsb();
+}
+
+void __not_in_flash_func(psram_cache_clean)(const void *p, size_t len) {
+    if (len && is_psram(p)) cache_maintain(p, len, XIP_OP_CLEAN);
+}
+
+void psram_stream_init(void) {
+    for (int core = 0; core < NUM_CORES; core++) {
+        if (dma_channels[core] < 0) dma_channels[core] = dma_claim_unused_channel(false);
+    }
+}
+
+// src_clean: the source may have dirty lines (anything but ROM data)
+static inline void __not_in_flash_func(stream_copy)(void *dst, const void *src, size_t len, bool src_clean) {
+    if (len == 0) return;
+    stats.copies++;
+    stats.bytes += len;
+
+#if PSRAM_STREAM
+    const bool src_psram = is_psram(src);
+    const bool dst_psram = is_psram(dst);
+    if (!src_psram && !dst_psram) {
+        memcpy(dst, src, len);
+        return;
+    }
+
+    // Uncached reads must not miss dirty lines, and a dirty line of the
+    // destination must not be written back over the copy later
+    if (src_psram && src_clean) cache_maintain(src, len, XIP_OP_CLEAN);
+    if (dst_psram) cache_maintain(dst, len, XIP_OP_CLEAN);
+
+    void *to = psram_nocache(dst);
+    const void *from = psram_nocache(src);
+    int channel = dma_channels[get_core_num()];
+    if (channel >= 0 && len >= DMA_MIN_BYTES && (((uintptr_t)dst | (uintptr_t)src | len) & 3) == 0) {
+        dma_channel_config c = dma_channel_get_default_config(channel);
+        channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+        channel_config_set_read_increment(&c, true);
+        channel_config_set_write_increment(&c, true);
+        dma_channel_configure(channel, &c, to, from, len / 4, true);
+        dma_channel_wait_for_finish_blocking(channel);
+        stats.dma++;
+    } else {
+        memcpy(to, from, len);
+    }
+
+    if (dst_psram) cache_maintain(dst, len, XIP_OP_INVALIDATE);
+#else
+    (void)src_clean;
+    memcpy(dst, src, len);
+#endif
+}
+
+void __not_in_flash_func(psram_stream_copy)(void *dst, const void *src, size_t len) {
+    stream_copy(dst, src, len, true);
+}
+
+void __not_in_flash_func(psram_stream_copy_rom)(void *dst, const void *src, size_t len) {
+    stream_copy(dst, src, len, false);
+}
+
+void psram_stream_get_stats(psram_stream_stats_t *out) {
+    *out = stats;
+    memset(&stats, 0, sizeof(stats));
+}
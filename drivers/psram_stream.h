@@ -0,0 +1,60 @@
+#ifndef PSRAM_STREAM_H
+#define PSRAM_STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Bulk copies to and from PSRAM that bypass the XIP cache.
+//
+// The cached PSRAM window (0x11000000) shares the 16 KB XIP cache with the
+// flash-resident code: streaming a ROM page or a savestate through it evicts
+// both. psram_stream_copy() reads and writes PSRAM through the non-caching,
+// non-allocating alias instead, by DMA when both sides are word aligned.
+// Either side may be SRAM or PSRAM, PSRAM given by its usual cached address.
+//
+// The cache is write-back: lines of the source are cleaned before the copy,
+// lines of the destination cleaned before and invalidated after, so cached
+// and uncached views agree again on return. Neither range may be written
+// through the cache by the other core while the copy runs.
+//
+// Build with PSRAM_STREAM=0 to copy through the cached window as before and
+// compare the XIP cache counters of the profiler report.
+
+#ifndef PSRAM_STREAM
+#define PSRAM_STREAM 1
+#endif
+
+#define PSRAM_CACHED_BASE    0x11000000u
+#define PSRAM_WINDOW_SIZE    0x01000000u   // XIP M1 window
+#define PSRAM_NOCACHE_OFFSET 0x04000000u   // XIP_NOCACHE_NOALLOC_BASE - XIP_BASE
+
+typedef struct {
+    uint32_t copies;    // psram_stream_copy() calls
+    uint32_t dma;       // ... of which ran by DMA
+    uint32_t bytes;
+} psram_stream_stats_t;
+
+// Address of the same PSRAM byte in the non-caching alias (other addresses unchanged)
+static inline void *psram_nocache(const void *p) {
+    uintptr_t a = (uintptr_t)p;
+    if (a - PSRAM_CACHED_BASE < PSRAM_WINDOW_SIZE) a += PSRAM_NOCACHE_OFFSET;
+    return (void *)a;
+}
+
+// Claim the DMA channels of both cores (copies fall back to the CPU without)
+void psram_stream_init(void);
+
+// Copy len bytes without allocating XIP cache lines (memcpy semantics, no overlap)
+void psram_stream_copy(void *dst, const void *src, size_t len);
+
+// Same for a source never written through the cache (ROM data, see
+// gwenesis_sram.c), whose lines are not cleaned first
+void psram_stream_copy_rom(void *dst, const void *src, size_t len);
+
+// Write back dirty XIP cache lines of a PSRAM range (no-op for other addresses)
+void psram_cache_clean(const void *p, size_t len);
+
+// Counters since the last call, then reset
+void psram_stream_get_stats(psram_stream_stats_t *out);
+
+#endif
@@ -474,6 +474,10 @@ static uint16_t hid_to_kbd_state_bit(uint8_t keycode) {
         // ESC -> Settings menu
         case 0x29: return 0x2000; // Escape -> KBD_STATE_ESC
         
+        // F5, F8 -> Quick save, quick load
+        case 0x3E: return 0x4000; // F5 -> KBD_STATE_SAVE
+        case 0x41: return 0x8000; // F8 -> KBD_STATE_LOAD
+        
         default: return 0;
     }
 }
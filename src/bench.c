@@ -0,0 +1,70 @@
+/*
+ * Fixed-frame benchmark runs Implementation
+ *
+ * The phase times of each frame are summed up to frame BENCH_FRAMES, then
+ * the averages and the two CRC32s are printed once. The CRCs are computed
+ * after the last timed frame, so they do not count in the times. Later
+ * frames keep running untimed.
+ */
+#include "bench.h"
+
+#if BENCH_FRAMES
+
+#include "gwenesis_bus.h"
+#include <stdio.h>
+#include <string.h>
+
+extern unsigned char M68K_RAM[];
+
+static char rom_name[64];
+static uint32_t frames;
+static uint64_t work_us;
+static uint64_t m68k_us;
+static uint64_t z80_us;
+static uint64_t sound_us;
+static uint64_t vdp_us;
+static uint64_t wait_us;
+
+static uint32_t crc32(const uint8_t *data, uint32_t size) {
+    uint32_t crc = 0xFFFFFFFFu;
+    for (uint32_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+void bench_init(const char *rom_path) {
+    const char *name = strrchr(rom_path, '/');
+    snprintf(rom_name, sizeof(rom_name), "%s", name ? name + 1 : rom_path);
+    frames = 0;
+    work_us = m68k_us = z80_us = sound_us = vdp_us = wait_us = 0;
+    printf("Benchmark run: %s, %d frames\n", rom_name, BENCH_FRAMES);
+}
+
+void bench_frame(const perf_osd_frame_t *frame, const uint8_t *screen, uint32_t screen_size) {
+    if (frames >= BENCH_FRAMES) return;
+
+    work_us += frame->frame_us - frame->audio_wait_us;
+    m68k_us += frame->m68k_us;
+    z80_us += frame->z80_us;
+    sound_us += frame->sound_us;
+    vdp_us += frame->vdp_us;
+    wait_us += frame->audio_wait_us;
+    if (++frames < BENCH_FRAMES) return;
+
+    printf("BENCH %s frames=%d us=%lu m68k=%lu z80=%lu sound=%lu vdp=%lu wait=%lu screen=%08lx ram=%08lx\n",
+        rom_name, BENCH_FRAMES,
+        (unsigned long)(work_us / frames),
+        (unsigned long)(m68k_us / frames),
+        (unsigned long)(z80_us / frames),
+        (unsigned long)(sound_us / frames),
+        (unsigned long)(vdp_us / frames),
+        (unsigned long)(wait_us / frames),
+        (unsigned long)crc32(screen, screen_size),
+        (unsigned long)crc32(M68K_RAM, MAX_RAM_SIZE));
+}
+
+#endif // BENCH_FRAMES
@@ -0,0 +1,47 @@
+/*
+ * Fixed-frame benchmark runs
+ *
+ * Build with BENCH_FRAMES=N to time the first N frames of a ROM (the
+ * benchmark ROMs of bench/ or any game) under identical conditions: every
+ * frame rendered, no run-ahead and all buttons released. After frame N one
+ * line is printed over UART:
+ *   BENCH <rom> frames=N us=.. m68k=.. z80=.. sound=.. vdp=.. wait=..
+ *         screen=<crc32> ram=<crc32>
+ * Times are core 0 microseconds per frame; us is the whole frame without
+ * the audio wait, so it measures the emulator rather than the pacing.
+ * screen and ram are CRC32s of the screen buffer and the 68K RAM at frame
+ * N: equal values on two builds mean they emulated the same thing.
+ * `tools/bench_roms.py report` tabulates the lines of several logs.
+ */
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "perf_osd.h"
+
+#ifndef BENCH_FRAMES
+#define BENCH_FRAMES 0
+#endif
+
+#if BENCH_FRAMES
+
+/**
+ * Start a run for the ROM at `rom_path` (its file name is printed)
+ */
+void bench_init(const char *rom_path);
+
+/**
+ * Account a finished frame (core 0, once per frame). Prints the result
+ * after frame BENCH_FRAMES, `screen` is the frame buffer at that point.
+ */
+void bench_frame(const perf_osd_frame_t *frame, const uint8_t *screen, uint32_t screen_size);
+
+#else
+
+#define bench_init(rom_path)
+#define bench_frame(frame, screen, screen_size)
+
+#endif // BENCH_FRAMES
+
+#endif // BENCH_H
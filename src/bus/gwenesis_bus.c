@@ -30,7 +30,10 @@ __license__ = "GPLv3"
 #include "gwenesis_io.h"
 #include "gwenesis_vdp.h"
 #include "gwenesis_sn76489.h"
+#include "gwenesis_sram.h"
 #include "gwenesis_savestate.h"
+#include "psram_stream.h"
+#include "z80_core1.h"
 
 /* Always optimize bus functions for speed - critical path */
 #pragma GCC optimize("Ofast")
@@ -72,68 +75,173 @@ unsigned char M68K_RAM[MAX_RAM_SIZE];    // 68K RAM
  * M68K ROM Page Cache - caches hot ROM pages in fast SRAM
  * Uses 60KB (15 x 4KB pages) with direct-mapped addressing
  ******************************************************************************/
-#define ROM_CACHE_PAGE_SIZE     4096    /* 4KB per page */
+#define ROM_CACHE_PAGE_SIZE     M68K_FETCH_WINDOW_SIZE  /* 4KB per page */
 #define ROM_CACHE_PAGE_SHIFT    12      /* log2(4096) */
 #define ROM_CACHE_NUM_PAGES     15      /* 15 pages = 60KB total */
-#define ROM_CACHE_PAGE_MASK     (ROM_CACHE_NUM_PAGES - 1)
 
 static uint8_t __attribute__((aligned(4))) rom_page_cache[ROM_CACHE_NUM_PAGES][ROM_CACHE_PAGE_SIZE];
 static uint32_t rom_cache_tags[ROM_CACHE_NUM_PAGES];  /* Upper address bits for validation */
 static uint8_t rom_cache_valid[ROM_CACHE_NUM_PAGES];  /* Valid flags */
 
+/* M68K instruction fetch window, points into one of the cache pages */
+m68k_fetch_window_t m68k_fetch_window = { 0, M68K_FETCH_WINDOW_NONE };
+static m68k_fetch_stats_t fetch_stats;
+static rom_cache_totals_t rom_cache_totals;
+
+/* ROM bank map (see gwenesis_bus.h), identity unless the mapper moved a slot */
+uintptr_t m68k_rom_map[ROM_BANK_SLOTS];
+static uint8_t rom_banks[ROM_MAPPER_SLOTS];
+static int rom_mapper_enabled;
+
+/* ROM_DATA offset of a cartridge address */
+static inline uint32_t rom_phys(uint32_t address) {
+    return (uint32_t)(m68k_rom_map[(address >> ROM_BANK_SHIFT) & (ROM_BANK_SLOTS - 1)] +
+                      address - (uintptr_t)ROM_DATA);
+}
+
+/* Slot of a page (15 is not a power of two, a mask would leave 7 slots unused) */
+static inline uint32_t rom_cache_slot(uint32_t page_num) {
+    return page_num % ROM_CACHE_NUM_PAGES;
+}
+
+/* Close the fetch window if it shows the given slot */
+static inline void fetch_window_drop(uint32_t cache_slot) {
+    if (m68k_fetch_window.start != M68K_FETCH_WINDOW_NONE &&
+        rom_cache_slot(rom_phys(m68k_fetch_window.start) >> ROM_CACHE_PAGE_SHIFT) == cache_slot) {
+        m68k_fetch_window.start = M68K_FETCH_WINDOW_NONE;
+    }
+}
+
 /* Initialize ROM cache (call on game load) */
 void rom_cache_init(void) {
     for (int i = 0; i < ROM_CACHE_NUM_PAGES; i++) {
         rom_cache_valid[i] = 0;
     }
+    m68k_fetch_window.start = M68K_FETCH_WINDOW_NONE;
 }
 
-/* Get cached ROM byte - returns from cache or fills cache line */
-static inline uint8_t rom_cache_read_8(uint32_t address) {
+/* Invalidate the page holding address (cartridge save memory shadow writes) */
+void rom_cache_invalidate(unsigned int address) {
     uint32_t page_num = address >> ROM_CACHE_PAGE_SHIFT;
-    uint32_t cache_slot = page_num & ROM_CACHE_PAGE_MASK;
-    uint32_t page_offset = address & (ROM_CACHE_PAGE_SIZE - 1);
+    uint32_t cache_slot = rom_cache_slot(page_num);
+    if (rom_cache_tags[cache_slot] == page_num) {
+        rom_cache_valid[cache_slot] = 0;
+        fetch_window_drop(cache_slot);
+    }
+}
+
+/* Cached copy of the page holding address, filled from PSRAM on a miss */
+static inline const uint8_t *rom_cache_page(uint32_t address) {
+    uint32_t page_num = rom_phys(address) >> ROM_CACHE_PAGE_SHIFT;
+    uint32_t cache_slot = rom_cache_slot(page_num);
+    rom_cache_totals.lookups++;
     
     /* Check cache hit */
     if (rom_cache_valid[cache_slot] && rom_cache_tags[cache_slot] == page_num) {
-        return rom_page_cache[cache_slot][page_offset ^ 1];  /* Byte swap for big-endian */
+        return rom_page_cache[cache_slot];
     }
     
-    /* Cache miss - fill the page */
+    /* Cache miss - fill the page, past the XIP cache */
+    fetch_window_drop(cache_slot);
     uint32_t page_base = page_num << ROM_CACHE_PAGE_SHIFT;
-    const uint32_t *src = (const uint32_t *)(ROM_DATA + page_base);
-    uint32_t *dst = (uint32_t *)rom_page_cache[cache_slot];
-    for (int i = 0; i < ROM_CACHE_PAGE_SIZE / 4; i++) {
-        dst[i] = src[i];
-    }
+    psram_stream_copy_rom(rom_page_cache[cache_slot], ROM_DATA + page_base, ROM_CACHE_PAGE_SIZE);
     rom_cache_tags[cache_slot] = page_num;
     rom_cache_valid[cache_slot] = 1;
+    fetch_stats.fills++;
+    rom_cache_totals.misses++;
     
-    return rom_page_cache[cache_slot][page_offset ^ 1];
+    return rom_page_cache[cache_slot];
+}
+
+/* Get cached ROM byte - returns from cache or fills cache line */
+static inline uint8_t rom_cache_read_8(uint32_t address) {
+    return rom_cache_page(address)[(address & (ROM_CACHE_PAGE_SIZE - 1)) ^ 1];  /* Byte swap for big-endian */
 }
 
 /* Get cached ROM word (16-bit) */
 static inline uint16_t rom_cache_read_16(uint32_t address) {
-    uint32_t page_num = address >> ROM_CACHE_PAGE_SHIFT;
-    uint32_t cache_slot = page_num & ROM_CACHE_PAGE_MASK;
-    uint32_t page_offset = address & (ROM_CACHE_PAGE_SIZE - 1);
-    
-    /* Check cache hit */
-    if (rom_cache_valid[cache_slot] && rom_cache_tags[cache_slot] == page_num) {
-        return *(uint16_t *)&rom_page_cache[cache_slot][page_offset];
+    return *(const uint16_t *)&rom_cache_page(address)[address & (ROM_CACHE_PAGE_SIZE - 1)];
+}
+
+/* Move the fetch window to the ROM page holding pc (pc < 0x800000) */
+void m68k_fetch_window_refill(unsigned int pc) {
+    uint32_t page_base = pc & ~(ROM_CACHE_PAGE_SIZE - 1);
+    const uint8_t *page = rom_cache_page(pc);
+    m68k_fetch_window.base = (uintptr_t)page - page_base;
+    m68k_fetch_window.start = page_base;
+    fetch_stats.switches++;
+}
+
+/* Point a slot at a 512 KB bank of ROM_DATA */
+static void rom_map_slot(unsigned int slot, unsigned int bank) {
+    m68k_rom_map[slot] = (uintptr_t)ROM_DATA + ((uintptr_t)bank << ROM_BANK_SHIFT) -
+                         ((uintptr_t)slot << ROM_BANK_SHIFT);
+}
+
+/* The fetch window and the Z80 bank cache hold logical addresses, the ROM
+ * cache (tagged by ROM_DATA offset) stays valid */
+static void rom_map_changed(void) {
+    m68k_fetch_window.start = M68K_FETCH_WINDOW_NONE;
+#if Z80_CORE1
+    if (z80_core1_post(m68k_cycles_master(), Z80_EV_BANKMAP, 0, 0))
+        return;
+#endif
+    z80_bank_cache_invalidate();
+}
+
+void rom_mapper_init(size_t rom_size) {
+    rom_mapper_enabled = rom_size > (ROM_MAPPER_SLOTS << ROM_BANK_SHIFT);
+    if (rom_mapper_enabled) {
+        printf("Cartridge mapper: %u KB ROM in 512 KB banks\n", (unsigned)(rom_size >> 10));
     }
-    
-    /* Cache miss - fill the page */
-    uint32_t page_base = page_num << ROM_CACHE_PAGE_SHIFT;
-    const uint32_t *src = (const uint32_t *)(ROM_DATA + page_base);
-    uint32_t *dst = (uint32_t *)rom_page_cache[cache_slot];
-    for (int i = 0; i < ROM_CACHE_PAGE_SIZE / 4; i++) {
-        dst[i] = src[i];
+    rom_mapper_reset();
+}
+
+void rom_mapper_reset(void) {
+    for (unsigned int slot = 0; slot < ROM_BANK_SLOTS; slot++) {
+        if (slot < ROM_MAPPER_SLOTS) rom_banks[slot] = slot;
+        rom_map_slot(slot, slot);
     }
-    rom_cache_tags[cache_slot] = page_num;
-    rom_cache_valid[cache_slot] = 1;
-    
-    return *(uint16_t *)&rom_page_cache[cache_slot][page_offset];
+    rom_map_changed();
+}
+
+/* 0xA130F3 (slot 1) to 0xA130FF (slot 7), bank number in the low bits */
+void rom_mapper_write(unsigned int address, unsigned int value) {
+    if (!rom_mapper_enabled || !(address & 1) || (address & 0xF0) != 0xF0)
+        return;
+
+    unsigned int slot = (address & 0xF) >> 1;
+    unsigned int bank = value & ((MAX_ROM_SIZE >> ROM_BANK_SHIFT) - 1);
+    if (slot == 0 || rom_banks[slot] == bank)
+        return;
+
+    rom_banks[slot] = bank;
+    rom_map_slot(slot, bank);
+    rom_map_changed();
+}
+
+void m68k_fetch_get_stats(m68k_fetch_stats_t *out) {
+    fetch_stats.fetches = m68k_fetch_window.fetches;
+    fetch_stats.outside = m68k_fetch_window.outside;
+    *out = fetch_stats;
+    memset(&fetch_stats, 0, sizeof(fetch_stats));
+    m68k_fetch_window.fetches = 0;
+    m68k_fetch_window.outside = 0;
+}
+
+/* ROM is read through the cache, the pointer is valid until the next fill */
+uint16_t *m68k_block_ptr(unsigned int address, int write, unsigned int *avail) {
+    unsigned int range = (address >> 16) & 0xFF;
+    if (range == 0xFF) {
+        *avail = 0x10000 - (address & 0xFFFF);
+        return (uint16_t *)&M68K_RAM[address & 0xFFFF];
+    }
+    if (range < 0x80 && !write) {
+        uint32_t offset = address & (ROM_CACHE_PAGE_SIZE - 1);
+        *avail = ROM_CACHE_PAGE_SIZE - offset;
+        return (uint16_t *)&rom_cache_page(address)[offset];
+    }
+    return NULL;
 }
 
 // Setup Z80 Memory
@@ -145,6 +253,50 @@ extern unsigned short gwenesis_vdp_status;
 int tmss_state = 0;
 int tmss_count = 0;
 
+/* 68K side of Z80 RAM and the sound chips. With Z80_CORE1 the Z80 runs on
+ * core 1: writes are queued at their time, reads wait for it to get there. */
+static inline unsigned int zram_read(unsigned int address) {
+#if Z80_CORE1
+  if (z80_core1_active)
+    z80_core1_sync(m68k_cycles_master());
+#endif
+  return ZRAM[address & 0x1FFF];
+}
+
+static inline void zram_write(unsigned int address, unsigned int value) {
+#if Z80_CORE1
+  if (z80_core1_post(m68k_cycles_master(), Z80_EV_RAM, address & 0x1FFF, value))
+    return;
+#endif
+  ZRAM[address & 0x1FFF] = value;
+}
+
+static inline unsigned int ym_read(void) {
+#if Z80_CORE1
+  if (z80_core1_active) {
+    z80_core1_sync(m68k_cycles_master());
+    return YM2612Status();
+  }
+#endif
+  return YM2612Read(m68k_cycles_master());
+}
+
+static inline void ym_write(unsigned int address, unsigned int value) {
+#if Z80_CORE1
+  if (z80_core1_post(m68k_cycles_master(), Z80_EV_YM, address & 0x3, value))
+    return;
+#endif
+  YM2612Write(address & 0x3, value, m68k_cycles_master());
+}
+
+static inline void psg_write(unsigned int value) {
+#if Z80_CORE1
+  if (z80_core1_post(m68k_cycles_master(), Z80_EV_PSG, 0, value))
+    return;
+#endif
+  gwenesis_SN76489_Write(value, m68k_cycles_master());
+}
+
 /******************************************************************************
  *
  *   Load a Sega Genesis Cartridge into CPU Memory
@@ -167,6 +319,7 @@ void load_cartridge()
     
     // Initialize ROM cache
     rom_cache_init();
+    rom_mapper_init(0);
 
     set_region();
 
@@ -189,6 +342,7 @@ void load_cartridge(unsigned char *buffer, size_t size)
 
     // Copy file contents to CPU ROM memory
     memcpy(ROM_DATA, buffer, size);
+    rom_mapper_init(size);
 
     #ifdef ROM_SWAP
     bus_log(__FUNCTION__,"--ROM swap mode--");
@@ -250,6 +404,8 @@ void reset_emulation() {
   z80_pulse_reset();
   // Send a reset pulse to Z80 M68K
   m68k_pulse_reset();
+  // Cartridge mapper back to the power-on banks
+  rom_mapper_reset();
   // Send a reset pulse to YM2612 chip
   YM2612ResetChip();
   // Send a reset pulse to SEGA 315-5313 chip
@@ -399,6 +555,10 @@ static inline unsigned int gwenesis_bus_map_z80_address(unsigned int address) {
  ******************************************************************************/
 static inline unsigned int gwenesis_bus_map_io_address(unsigned int address)
 {
+  // Cartridge mapper registers 0xA130F1-0xA130FF
+  if ((address & 0xFF00) == 0x3000)
+    return CART_CTRL;
+
   unsigned int range = (address & 0x1000) ;
   switch (range) {
   case 0:      return IO_CTRL;
@@ -480,12 +640,15 @@ static inline __attribute__((always_inline)) unsigned int gwenesis_bus_read_memo
   case Z80_CTRL:
     return z80_read_ctrl(address & 0xFFFF);
 
+  case CART_CTRL:
+    return 0xFF;
+
   case Z80_RAM_ADDR:
   case Z80_RAM_ADDR1K:
-    return ZRAM[address & 0x1FFF];
+    return zram_read(address);
 
   case Z80_YM2612_ADDR:
-    return YM2612Read(m68k_cycles_master());
+    return ym_read();
 
   case Z80_SN76489_ADDR:
     return 0xff;
@@ -542,11 +705,14 @@ static inline __attribute__((always_inline)) unsigned int gwenesis_bus_read_memo
 
   case Z80_RAM_ADDR:
   case Z80_RAM_ADDR1K:
-    return ZRAM[address & 0X1FFF] | (ZRAM[address & 0X1FFF] << 8);
+    {
+      unsigned int rv = zram_read(address);
+      return rv | rv << 8;
+    }
 
   case Z80_YM2612_ADDR:
     {
-      unsigned int rv = YM2612Read(m68k_cycles_master());
+      unsigned int rv = ym_read();
       return rv | rv << 8;
     }
 
@@ -600,14 +766,26 @@ static inline __attribute__((always_inline)) void gwenesis_bus_write_memory_8(un
     z80_write_ctrl(address & 0x1FFF, value);
     return;
 
+  case CART_CTRL:
+    if ((address & 0xFF) == 0xF1)
+      gwenesis_sram_write_ctrl(address, value);
+    else
+      rom_mapper_write(address, value);
+    return;
+
+  case ROM_ADDR:
+    // Cartridge SRAM / EEPROM (nothing else is writable below 0x800000)
+    gwenesis_sram_write_8(address, value);
+    return;
+
   case Z80_RAM_ADDR:
   case Z80_RAM_ADDR1K:
-    ZRAM[address & 0x1FFF] = value;
+    zram_write(address, value);
     return;
 
   case Z80_YM2612_ADDR:
     bus_log(__FUNCTION__,"CPUZ80PSG8 ,m68kclk= %d", m68k_cycles_master());
-    YM2612Write(address & 0x3, value & 0Xff,m68k_cycles_master());
+    ym_write(address, value & 0Xff);
     static uint32_t ym_bus_writes = 0;
     if ((++ym_bus_writes % 1000) == 0) {
         printf("YM2612 bus writes (8-bit): %lu\n", (unsigned long)ym_bus_writes);
@@ -616,7 +794,7 @@ static inline __attribute__((always_inline)) void gwenesis_bus_write_memory_8(un
 
   case Z80_SN76489_ADDR:
     bus_log(__FUNCTION__,"CPUZ80FM8  ,m68kclk= %d", m68k_cycles_master());
-    gwenesis_SN76489_Write( value & 0Xff, m68k_cycles_master());
+    psg_write(value & 0Xff);
     static uint32_t sn_bus_writes_8 = 0;
     if ((++sn_bus_writes_8 % 1000) == 0) {
         printf("SN76489 bus writes (8-bit): %lu\n", (unsigned long)sn_bus_writes_8);
@@ -675,7 +853,7 @@ static inline __attribute__((always_inline)) void gwenesis_bus_write_memory_16(u
 
   case Z80_RAM_ADDR:
   case Z80_RAM_ADDR1K:
-    ZRAM[address & 0X1FFF]= value >> 8;
+    zram_write(address, value >> 8);
     return;
 
   case IO_CTRL:
@@ -688,7 +866,7 @@ static inline __attribute__((always_inline)) void gwenesis_bus_write_memory_16(u
 
   case Z80_YM2612_ADDR:
     bus_log(__FUNCTION__,"CZYM16 ,mclk=%d",  m68k_cycles_master());
-    YM2612Write(address & 0x3, value >> 8,m68k_cycles_master() );
+    ym_write(address, value >> 8);
     static uint32_t ym_bus_writes_16 = 0;
     if ((++ym_bus_writes_16 % 1000) == 0) {
         printf("YM2612 bus writes (16-bit): %lu\n", (unsigned long)ym_bus_writes_16);
@@ -697,7 +875,7 @@ static inline __attribute__((always_inline)) void gwenesis_bus_write_memory_16(u
 
   case Z80_SN76489_ADDR:
     bus_log(__FUNCTION__,"CZSN16 ,mclk=%d", m68k_cycles_master());
-    gwenesis_SN76489_Write(value >> 8,m68k_cycles_master() );
+    psg_write(value >> 8);
     static uint32_t sn_bus_writes = 0;
     if ((++sn_bus_writes % 1000) == 0) {
         printf("SN76489 bus writes: %lu\n", (unsigned long)sn_bus_writes);
@@ -814,6 +992,7 @@ void gwenesis_bus_save_state() {
   saveGwenesisStateSetBuffer(state, "TMSS", TMSS, sizeof(TMSS));
   saveGwenesisStateSet(state, "tmss_state", tmss_state);
   saveGwenesisStateSet(state, "tmss_count", tmss_count);
+  saveGwenesisStateSetBuffer(state, "rom_banks", rom_banks, sizeof(rom_banks));
 }
 
 void gwenesis_bus_load_state() {
@@ -823,4 +1002,11 @@ void gwenesis_bus_load_state() {
     saveGwenesisStateGetBuffer(state, "TMSS", TMSS, sizeof(TMSS));
     tmss_state = saveGwenesisStateGet(state, "tmss_state");
     tmss_count = saveGwenesisStateGet(state, "tmss_count");
+    rom_mapper_reset();
+    uint8_t banks[ROM_MAPPER_SLOTS];
+    if (saveGwenesisStateGetBuffer(state, "rom_banks", banks, sizeof(banks))) {
+        for (unsigned int slot = 1; slot < ROM_MAPPER_SLOTS; slot++) {
+            rom_mapper_write(0xA130F1 + (slot << 1), banks[slot]);
+        }
+    }
 }
\ No newline at end of file
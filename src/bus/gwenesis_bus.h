@@ -22,6 +22,7 @@ __license__ = "GPLv3"
 #pragma once
 
 #include <stdio.h>
+#include <stdint.h>
 #include <string.h>
 
 #define MAX_ROM_SIZE 0x800000
@@ -74,7 +75,8 @@ enum mapped_address
     Z80_CTRL,
     TMSS_CTRL,
     VDP_ADDR,
-    RAM_ADDR
+    RAM_ADDR,
+    CART_CTRL
 };
 
 enum gwenesis_bus_pad_button
@@ -99,6 +101,71 @@ void power_on();
 void reset_emulation();
 void set_region();
 
+/* Drop the cached copy of the ROM page holding a ROM_DATA offset (ROM_DATA changed) */
+void rom_cache_invalidate(unsigned int address);
+void rom_cache_init(void);
+
+/* Sega mapper (Super Street Fighter II, carts over 4 MB): the registers at
+ * 0xA130F3-0xA130FF pick the 512 KB ROM bank seen in slots 1-7 of
+ * 0x000000-0x3FFFFF. Every ROM read goes through m68k_rom_map, the host
+ * address of 68K address 0 per slot (host = map[slot] + address), and the
+ * ROM cache is tagged by ROM_DATA offset, so a bank switch rewrites one
+ * entry and closes the fetch window; nothing is copied. */
+#define ROM_BANK_SHIFT 19
+#define ROM_BANK_SLOTS 16           /* 0x000000-0x7FFFFF */
+#define ROM_MAPPER_SLOTS 8          /* 0x000000-0x3FFFFF */
+
+extern uintptr_t m68k_rom_map[ROM_BANK_SLOTS];
+
+/* Enable the mapper for this cartridge and map the power-on banks */
+void rom_mapper_init(size_t rom_size);
+void rom_mapper_reset(void);
+void rom_mapper_write(unsigned int address, unsigned int value);
+
+/* M68K instruction fetch window: the SRAM ROM cache page holding the PC.
+ * Immediate reads are served from it while the PC stays in the page, the
+ * window moves (and the page is filled from PSRAM if needed) when it leaves. */
+#define M68K_FETCH_WINDOW_SIZE  4096
+#define M68K_FETCH_WINDOW_NONE  0xF0000000u  /* No PC is within a page of it */
+
+/* Count every fetch for the profiler (one increment per fetch, off by default) */
+#ifndef M68K_FETCH_STATS
+#define M68K_FETCH_STATS 0
+#endif
+
+typedef struct {
+  uintptr_t base;           /* Host address of 68K address 0 in the window */
+  unsigned int start;       /* 68K address of the page, or M68K_FETCH_WINDOW_NONE */
+  unsigned int fetches;     /* Immediate fetches (M68K_FETCH_STATS) */
+  unsigned int outside;     /* Fetches outside the window (M68K_FETCH_STATS) */
+} m68k_fetch_window_t;
+
+typedef struct {
+  unsigned int fetches;     /* Immediate fetches since the last call */
+  unsigned int outside;     /* Not served by the window (page switch or RAM code) */
+  unsigned int switches;    /* Window moved to another ROM page */
+  unsigned int fills;       /* ROM pages copied from PSRAM into the cache */
+} m68k_fetch_stats_t;
+
+extern m68k_fetch_window_t m68k_fetch_window;
+
+void m68k_fetch_window_refill(unsigned int pc);
+void m68k_fetch_get_stats(m68k_fetch_stats_t *out);
+
+/* ROM page cache totals since boot (never reset, take differences). Reads
+ * served by the fetch window do not look the cache up. */
+typedef struct {
+  unsigned int lookups;     /* Page lookups */
+  unsigned int misses;      /* Pages filled from PSRAM */
+} rom_cache_totals_t;
+
+void rom_cache_get_totals(rom_cache_totals_t *out);
+
+/* Native-order words of work RAM, or of ROM when !write, at an even address
+ * for the M68K block moves; *avail is the byte count before the RAM wraps or
+ * the cache page ends. NULL for any other region. */
+uint16_t *m68k_block_ptr(unsigned int address, int write, unsigned int *avail);
+
 void gwenesis_bus_save_state();
 void gwenesis_bus_load_state();
 
@@ -0,0 +1,378 @@
+/*
+ * Cartridge backup memory: battery SRAM and serial (I2C) EEPROM
+ *
+ * Battery SRAM is described by the ROM header ("RA" at 0x1B0, type byte,
+ * start/end addresses). Most boards wire an 8-bit chip to the odd (or
+ * even) bytes only, so storage holds one byte per used address. When the
+ * ROM itself covers the window (> 2 MB games) the SRAM is only visible
+ * while enabled through 0xA130F1; the ROM bytes it hides are kept aside.
+ *
+ * Serial EEPROM boards (header type 0x40) use the Sega wiring: SDA on bit 0
+ * and SCL on bit 1 of the byte at the header start address, driving an
+ * X24C01 (128 bytes, 7-bit word address sent LSB first with the R/W bit).
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gwenesis_bus.h"
+#include "gwenesis_sram.h"
+#include "gwenesis_savestate.h"
+#include "psram_stream.h"
+
+extern unsigned char *ROM_DATA;
+
+enum sram_lanes {
+  LANES_WORD = 0,
+  LANES_EVEN,
+  LANES_ODD
+};
+
+enum eeprom_state {
+  EEPROM_STANDBY = 0,
+  EEPROM_ADDRESS,
+  EEPROM_WRITE,
+  EEPROM_READ
+};
+
+#define EEPROM_SDA_BIT 0
+#define EEPROM_SCL_BIT 1
+#define EEPROM_X24C01_SIZE 128
+#define EEPROM_PAGE_MASK 3
+
+#define SRAM_PAGE_ROUND(size) (((size) + 255) & ~255u)
+
+static struct {
+  int type;
+  int lanes;
+  unsigned int start;           /* 68K window, inclusive */
+  unsigned int end;
+  unsigned char *data;          /* Master copy */
+  uint32_t size;
+  unsigned char *rom_backup;    /* ROM bytes under the window, NULL if none */
+  unsigned int ctrl;            /* Last value written to 0xA130F1 */
+  bool mapped;                  /* Shadow holds the save memory */
+  uint32_t dirty_start;         /* Empty when dirty_start >= dirty_end */
+  uint32_t dirty_end;
+  volatile uint32_t writes;
+} sram;
+
+static struct {
+  unsigned int scl;             /* Lines as last driven by the 68K */
+  unsigned int sda;
+  unsigned int sda_out;         /* EEPROM side (1 = released) */
+  int state;
+  int cycles;                   /* SCL rising edges in the current byte frame */
+  unsigned int buffer;
+  unsigned int address;
+} eeprom;
+
+static inline uint32_t read_be32(const unsigned char *p) {
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static inline unsigned int sram_address(uint32_t index) {
+  return sram.lanes == LANES_WORD ? sram.start + index : sram.start + (index << 1);
+}
+
+static inline int sram_index(unsigned int address) {
+  if (address < sram.start || address > sram.end)
+    return -1;
+  unsigned int offset = address - sram.start;
+  if (sram.lanes == LANES_WORD)
+    return (int)offset;
+  return (offset & 1) ? -1 : (int)(offset >> 1);
+}
+
+/* ROM page and Z80 bank fills read ROM_DATA past the XIP cache without
+ * cleaning it (psram_stream_copy_rom), so shadow writes go to PSRAM at once */
+static inline void shadow_write(unsigned int address, unsigned char value) {
+  ROM_DATA[address ^ 1] = value;
+  psram_cache_clean(&ROM_DATA[address ^ 1], 1);
+  rom_cache_invalidate(address);
+}
+
+static void shadow_clean(void) {
+  unsigned int start = sram.start & ~1u;
+  psram_cache_clean(ROM_DATA + start, (sram.end | 1) + 1 - start);
+}
+
+void gwenesis_sram_mark_dirty(uint32_t start, uint32_t end) {
+  if (sram.dirty_start >= sram.dirty_end) {
+    sram.dirty_start = start;
+    sram.dirty_end = end;
+  } else {
+    if (start < sram.dirty_start) sram.dirty_start = start;
+    if (end > sram.dirty_end) sram.dirty_end = end;
+  }
+  sram.writes++;
+}
+
+uint32_t gwenesis_sram_init(const unsigned char *rom_header, size_t rom_size) {
+  free(sram.data);
+  free(sram.rom_backup);
+  memset(&sram, 0, sizeof(sram));
+
+  if (rom_header[0x1B0] != 'R' || rom_header[0x1B1] != 'A')
+    return 0;
+
+  unsigned int kind = rom_header[0x1B3];
+  unsigned int start = read_be32(rom_header + 0x1B4);
+  unsigned int end = read_be32(rom_header + 0x1B8);
+
+  if (start >= MAX_ROM_SIZE || end < start) {
+    printf("Cartridge save memory: bad header range %06x-%06x\n", start, end);
+    return 0;
+  }
+
+  if (kind == 0x40) {
+    if (rom_size > (start & ~1u)) {
+      printf("Cartridge EEPROM at %06x overlaps ROM: not supported\n", start);
+      return 0;
+    }
+    sram.type = SRAM_EEPROM;
+    sram.lanes = (start & 1) ? LANES_ODD : LANES_EVEN;
+    sram.start = sram.end = start;
+    sram.size = EEPROM_X24C01_SIZE;
+  } else if (kind == 0x20) {
+    unsigned int lanes = rom_header[0x1B2] & 0x18;
+    sram.type = SRAM_BATTERY;
+    sram.lanes = lanes == 0x18 ? LANES_ODD : lanes == 0x10 ? LANES_EVEN : LANES_WORD;
+    if (sram.lanes == LANES_ODD) start |= 1;
+    if (sram.lanes == LANES_EVEN) start &= ~1u;
+    if (end >= MAX_ROM_SIZE) end = MAX_ROM_SIZE - 1;
+
+    sram.start = start;
+    sram.size = sram.lanes == LANES_WORD ? end - start + 1 : ((end - start) >> 1) + 1;
+    if (sram.size > GWENESIS_SRAM_MAX_SIZE) sram.size = GWENESIS_SRAM_MAX_SIZE;
+    sram.end = sram_address(sram.size - 1);
+  } else {
+    return 0;
+  }
+
+  /* Erased SRAM/EEPROM reads back as 0xFF until the save file is loaded */
+  sram.data = malloc(SRAM_PAGE_ROUND(sram.size));
+  if (sram.data != NULL && rom_size > (sram.start & ~1u))
+    sram.rom_backup = malloc(sram.size);
+  if (sram.data == NULL || (rom_size > (sram.start & ~1u) && sram.rom_backup == NULL)) {
+    printf("Cartridge save memory: out of memory (%lu bytes)\n", (unsigned long)sram.size);
+    free(sram.data);
+    memset(&sram, 0, sizeof(sram));
+    return 0;
+  }
+  memset(sram.data, 0xFF, SRAM_PAGE_ROUND(sram.size));
+
+  printf("Cartridge %s: %lu bytes at %06x-%06x%s\n",
+         sram.type == SRAM_EEPROM ? "EEPROM" : "SRAM", (unsigned long)sram.size,
+         sram.start, sram.end, sram.rom_backup ? " (switched with ROM)" : "");
+  return (sram.end | 1) + 1;
+}
+
+/* Swap the shadow between save memory and the ROM bytes it hides */
+static void sram_set_mapped(bool on) {
+  if (on == sram.mapped)
+    return;
+
+  for (uint32_t i = 0; i < sram.size; i++) {
+    unsigned int address = sram_address(i);
+    if (on) {
+      if (sram.rom_backup)
+        sram.rom_backup[i] = ROM_DATA[address ^ 1];
+      ROM_DATA[address ^ 1] = sram.data[i];
+    } else {
+      ROM_DATA[address ^ 1] = sram.rom_backup ? sram.rom_backup[i] : 0xFF;
+    }
+  }
+  sram.mapped = on;
+  shadow_clean();
+  rom_cache_init();
+}
+
+static void eeprom_update_shadow(void) {
+  shadow_write(sram.start, (unsigned char)((eeprom.sda_out & eeprom.sda) << EEPROM_SDA_BIT));
+}
+
+void gwenesis_sram_reset(void) {
+  if (sram.type == SRAM_BATTERY) {
+    /* Without ROM underneath the SRAM is always visible */
+    sram.ctrl = sram.rom_backup ? 0 : GWENESIS_SRAM_CTRL_ENABLE;
+    sram_set_mapped(sram.rom_backup == NULL);
+  } else if (sram.type == SRAM_EEPROM) {
+    memset(&eeprom, 0, sizeof(eeprom));
+    eeprom.scl = eeprom.sda = eeprom.sda_out = 1;
+    sram.mapped = true;
+    eeprom_update_shadow();
+  }
+}
+
+int gwenesis_sram_type(void) {
+  return sram.type;
+}
+
+unsigned char *gwenesis_sram_data(void) {
+  return sram.data;
+}
+
+uint32_t gwenesis_sram_size(void) {
+  return sram.size;
+}
+
+/* Falling SCL edge: end of a data bit or of the acknowledge clock */
+static void eeprom_clock_fall(void) {
+  if (eeprom.cycles == 8) {
+    switch (eeprom.state) {
+    case EEPROM_ADDRESS:
+      eeprom.address = eeprom.buffer & (EEPROM_X24C01_SIZE - 1);
+      eeprom.state = (eeprom.buffer & 0x80) ? EEPROM_READ : EEPROM_WRITE;
+      eeprom.sda_out = 0;
+      break;
+    case EEPROM_WRITE:
+      if (sram.data[eeprom.address] != eeprom.buffer) {
+        sram.data[eeprom.address] = (unsigned char)eeprom.buffer;
+        gwenesis_sram_mark_dirty(eeprom.address, eeprom.address + 1);
+      }
+      /* Page write: the low address bits wrap within the page */
+      eeprom.address = (eeprom.address & ~EEPROM_PAGE_MASK) |
+                       ((eeprom.address + 1) & EEPROM_PAGE_MASK);
+      eeprom.sda_out = 0;
+      break;
+    case EEPROM_READ:
+      eeprom.address = (eeprom.address + 1) & (EEPROM_X24C01_SIZE - 1);
+      eeprom.sda_out = 1;
+      break;
+    }
+  } else if (eeprom.cycles == 9) {
+    eeprom.cycles = 0;
+    eeprom.buffer = 0;
+    eeprom.sda_out = eeprom.state == EEPROM_READ ? sram.data[eeprom.address] & 1 : 1;
+  } else if (eeprom.state == EEPROM_READ) {
+    eeprom.sda_out = (sram.data[eeprom.address] >> eeprom.cycles) & 1;
+  }
+}
+
+static void eeprom_write(unsigned int value) {
+  unsigned int sda = (value >> EEPROM_SDA_BIT) & 1;
+  unsigned int scl = (value >> EEPROM_SCL_BIT) & 1;
+
+  if (eeprom.scl && scl) {
+    if (eeprom.sda && !sda) {
+      /* Start condition */
+      eeprom.state = EEPROM_ADDRESS;
+      eeprom.cycles = 0;
+      eeprom.buffer = 0;
+      eeprom.sda_out = 1;
+    } else if (!eeprom.sda && sda) {
+      /* Stop condition */
+      eeprom.state = EEPROM_STANDBY;
+      eeprom.sda_out = 1;
+    }
+  } else if (!eeprom.scl && scl) {
+    if (eeprom.state != EEPROM_STANDBY) {
+      if (eeprom.cycles < 8 && eeprom.state != EEPROM_READ)
+        eeprom.buffer |= sda << eeprom.cycles;  /* X24C01 shifts LSB first */
+      eeprom.cycles++;
+    }
+  } else if (eeprom.scl && !scl) {
+    if (eeprom.state != EEPROM_STANDBY)
+      eeprom_clock_fall();
+  }
+
+  eeprom.scl = scl;
+  eeprom.sda = sda;
+  eeprom_update_shadow();
+}
+
+void gwenesis_sram_write_8(unsigned int address, unsigned int value) {
+  if (sram.type == SRAM_EEPROM) {
+    if (address == sram.start)
+      eeprom_write(value);
+    return;
+  }
+
+  if (!sram.mapped || (sram.ctrl & GWENESIS_SRAM_CTRL_PROTECT))
+    return;
+
+  int index = sram_index(address);
+  if (index < 0 || sram.data[index] == (unsigned char)value)
+    return;
+
+  sram.data[index] = (unsigned char)value;
+  shadow_write(address, (unsigned char)value);
+  gwenesis_sram_mark_dirty((uint32_t)index, (uint32_t)index + 1);
+}
+
+void gwenesis_sram_write_ctrl(unsigned int address, unsigned int value) {
+  if ((address & 0xFF) != 0xF1 || sram.type != SRAM_BATTERY)
+    return;
+
+  sram.ctrl = value & (GWENESIS_SRAM_CTRL_ENABLE | GWENESIS_SRAM_CTRL_PROTECT);
+  if (sram.rom_backup)
+    sram_set_mapped(sram.ctrl & GWENESIS_SRAM_CTRL_ENABLE);
+}
+
+uint32_t gwenesis_sram_write_count(void) {
+  return sram.writes;
+}
+
+bool gwenesis_sram_take_dirty(uint32_t *start, uint32_t *end) {
+  if (sram.dirty_start >= sram.dirty_end)
+    return false;
+  *start = sram.dirty_start;
+  *end = sram.dirty_end;
+  sram.dirty_start = sram.dirty_end = 0;
+  return true;
+}
+
+void gwenesis_sram_resync(void) {
+  if (sram.type == SRAM_NONE)
+    return;
+
+  if (sram.type == SRAM_BATTERY && sram.mapped) {
+    for (uint32_t i = 0; i < sram.size; i++)
+      ROM_DATA[sram_address(i) ^ 1] = sram.data[i];
+    shadow_clean();
+    rom_cache_init();
+  }
+  gwenesis_sram_mark_dirty(0, sram.size);
+}
+
+void gwenesis_sram_save_state() {
+  SaveState* state;
+  state = saveGwenesisStateOpenForWrite("sram");
+  saveGwenesisStateSet(state, "ctrl", sram.ctrl);
+  if (sram.data)
+    saveGwenesisStateSetBuffer(state, "data", sram.data, sram.size);
+  if (sram.type == SRAM_EEPROM) {
+    saveGwenesisStateSet(state, "ee_lines", eeprom.scl | (eeprom.sda << 1) | (eeprom.sda_out << 2));
+    saveGwenesisStateSet(state, "ee_state", eeprom.state);
+    saveGwenesisStateSet(state, "ee_cycles", eeprom.cycles);
+    saveGwenesisStateSet(state, "ee_buffer", eeprom.buffer);
+    saveGwenesisStateSet(state, "ee_address", eeprom.address);
+  }
+}
+
+void gwenesis_sram_load_state() {
+  SaveState* state = saveGwenesisStateOpenForRead("sram");
+  bool loaded = sram.data && saveGwenesisStateGetBuffer(state, "data", sram.data, sram.size);
+
+  if (sram.type == SRAM_BATTERY) {
+    sram.ctrl = saveGwenesisStateGet(state, "ctrl");
+    if (sram.rom_backup)
+      sram_set_mapped(sram.ctrl & GWENESIS_SRAM_CTRL_ENABLE);
+  } else if (sram.type == SRAM_EEPROM) {
+    int lines = saveGwenesisStateGet(state, "ee_lines");
+    eeprom.scl = lines & 1;
+    eeprom.sda = (lines >> 1) & 1;
+    eeprom.sda_out = (lines >> 2) & 1;
+    eeprom.state = saveGwenesisStateGet(state, "ee_state");
+    eeprom.cycles = saveGwenesisStateGet(state, "ee_cycles");
+    eeprom.buffer = saveGwenesisStateGet(state, "ee_buffer");
+    eeprom.address = saveGwenesisStateGet(state, "ee_address") & (EEPROM_X24C01_SIZE - 1);
+    eeprom_update_shadow();
+  }
+
+  /* The save file follows the loaded contents */
+  if (loaded)
+    gwenesis_sram_resync();
+}
@@ -0,0 +1,61 @@
+/*
+ * Cartridge backup memory: battery SRAM and serial (I2C) EEPROM
+ *
+ * The master copy lives in SRAM. The 68K core reads everything below
+ * 0x800000 straight from ROM_DATA, so while save memory is mapped its
+ * bytes are mirrored into ROM_DATA as well ("shadow") and only writes go
+ * through the bus.
+ */
+#ifndef _gwenesis_sram_H_
+#define _gwenesis_sram_H_
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Largest backup memory accepted from a ROM header (bytes of storage) */
+#define GWENESIS_SRAM_MAX_SIZE 0x10000
+
+/* Cartridge mapper registers 0xA130F1-0xA130FF */
+#define GWENESIS_SRAM_CTRL_ENABLE 0x01
+#define GWENESIS_SRAM_CTRL_PROTECT 0x02
+
+enum gwenesis_sram_type {
+  SRAM_NONE = 0,
+  SRAM_BATTERY,
+  SRAM_EEPROM
+};
+
+/* Parse the (big-endian, unswapped) ROM header and allocate the backup
+ * memory. Returns the ROM_DATA size needed to hold the shadow window,
+ * 0 when the cartridge has no save memory. Call before the ROM is loaded. */
+uint32_t gwenesis_sram_init(const unsigned char *rom_header, size_t rom_size);
+
+/* Map the save memory in its power-on state and fill the shadow
+ * (after the ROM and the backup contents are loaded) */
+void gwenesis_sram_reset(void);
+
+int gwenesis_sram_type(void);
+/* Storage is allocated in whole 256-byte pages beyond gwenesis_sram_size() */
+unsigned char *gwenesis_sram_data(void);
+uint32_t gwenesis_sram_size(void);
+
+/* Bus handlers: 0x000000-0x7FFFFF writes and the 0xA130xx registers */
+void gwenesis_sram_write_8(unsigned int address, unsigned int value);
+void gwenesis_sram_write_ctrl(unsigned int address, unsigned int value);
+
+/* Write-behind support: bumped on every store, and the byte range
+ * [*start, *end) written since the last take (false when clean) */
+uint32_t gwenesis_sram_write_count(void);
+bool gwenesis_sram_take_dirty(uint32_t *start, uint32_t *end);
+void gwenesis_sram_mark_dirty(uint32_t start, uint32_t end);
+
+/* Contents were replaced behind the bus' back (savestate, run-ahead) */
+void gwenesis_sram_resync(void);
+
+void gwenesis_sram_save_state(void);
+void gwenesis_sram_load_state(void);
+
+#endif
@@ -0,0 +1,202 @@
+/*
+ * Cartridge saves Implementation
+ *
+ * The emulated save memory lives in SRAM and the bus records the byte
+ * range written since the last hand-off. Games usually write a save slot
+ * in one burst, so core 0 waits until no write happened for
+ * CARTSAVE_SETTLE_FRAMES, then copies the dirty range (rounded to whole
+ * sectors) into a PSRAM staging buffer and publishes it as a job. Core 1
+ * writes the job CARTSAVE_FLUSH_CHUNK bytes per frame; core 0 never
+ * touches the card during gameplay and never publishes while a job is
+ * pending, so the staging buffer needs no further locking.
+ */
+#include "cartsave.h"
+#include "quicksave.h"
+#include "gwenesis_sram.h"
+#include "psram_allocator.h"
+#include "ff.h"
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include <string.h>
+#include <stdio.h>
+
+// Simple logging (conditional on ENABLE_LOGGING)
+#if ENABLE_LOGGING
+#define LOG(fmt, ...) printf(fmt, ##__VA_ARGS__)
+#else
+#define LOG(fmt, ...) do {} while(0)
+#endif
+
+#define SECTOR_SIZE 512
+#define MAX_CARTSAVE_PATH 144
+
+static char srm_path[MAX_CARTSAVE_PATH];
+static unsigned char *staging = NULL;   // Same layout as the save memory (PSRAM)
+static bool srm_complete = false;       // File holds the whole save memory (core 0)
+
+// Job handed from core 0 to core 1
+static volatile uint32_t job_offset;
+static volatile uint32_t job_size;
+static volatile uint32_t job_generation = 0;
+static volatile uint32_t flushed_generation = 0;
+static volatile bool job_failed = false;
+
+// Settle detection (core 0)
+static uint32_t last_writes;
+static int quiet_frames;
+
+// Flush state (whoever holds the SD lock)
+static FIL flush_file;
+static bool flush_open = false;
+static uint32_t flush_done;
+
+void cartsave_init(const char *rom_path) {
+    uint32_t size = gwenesis_sram_size();
+    if (gwenesis_sram_type() == SRAM_NONE) return;
+
+    // /genesis/game.md -> /genesis/game.srm
+    snprintf(srm_path, sizeof(srm_path), "%s", rom_path);
+    char *slash = strrchr(srm_path, '/');
+    char *dot = strrchr(srm_path, '.');
+    if (dot == NULL || (slash != NULL && dot < slash)) {
+        dot = srm_path + strlen(srm_path);
+    }
+    snprintf(dot, sizeof(srm_path) - (size_t)(dot - srm_path), ".srm");
+
+    FIL file;
+    UINT br = 0;
+    quicksave_sd_lock();
+    if (f_open(&file, srm_path, FA_READ) == FR_OK) {
+        // Saves from other emulators are often padded: use the first size bytes
+        if (f_size(&file) >= size &&
+            f_read(&file, gwenesis_sram_data(), size, &br) == FR_OK && br == size) {
+            srm_complete = true;
+        }
+        f_close(&file);
+    }
+    quicksave_sd_unlock();
+    LOG("Cartridge save: %s %s\n", srm_path, srm_complete ? "loaded" : "not found");
+
+    gwenesis_sram_reset();
+
+    staging = (unsigned char *)psram_malloc(size);
+    if (staging == NULL) {
+        LOG("Cartridge save: no staging buffer, saves will not persist\n");
+    }
+    last_writes = gwenesis_sram_write_count();
+    quiet_frames = 0;
+}
+
+// Copy the dirty sectors to the staging buffer and publish them (core 0)
+static void cartsave_publish(void) {
+    if (job_generation != flushed_generation) return;  // Core 1 still writing
+
+    if (job_failed) {
+        // The file may be partial now: the next job rewrites all of it
+        job_failed = false;
+        srm_complete = false;
+    }
+
+    uint32_t size = gwenesis_sram_size();
+    uint32_t start, end;
+    if (!gwenesis_sram_take_dirty(&start, &end)) return;
+    if (!srm_complete) {
+        start = 0;
+        end = size;
+        srm_complete = true;
+    }
+    start &= ~(uint32_t)(SECTOR_SIZE - 1);
+    end = (end + SECTOR_SIZE - 1) & ~(uint32_t)(SECTOR_SIZE - 1);
+    if (end > size) end = size;
+
+    memcpy(staging + start, gwenesis_sram_data() + start, end - start);
+    job_offset = start;
+    job_size = end - start;
+    // Publish the job to core 1 only once the copy is complete
+    __dmb();
+    job_generation++;
+}
+
+void cartsave_frame(void) {
+    if (staging == NULL) return;
+
+    uint32_t writes = gwenesis_sram_write_count();
+    if (writes != last_writes) {
+        last_writes = writes;
+        quiet_frames = 0;
+        return;
+    }
+    if (quiet_frames < CARTSAVE_SETTLE_FRAMES) {
+        quiet_frames++;
+        return;
+    }
+    cartsave_publish();
+}
+
+// Write one chunk of the pending job (SD lock held)
+static void cartsave_write_chunk(void) {
+    if (job_generation == flushed_generation) return;
+    __dmb();
+
+    if (!flush_open) {
+        if (f_open(&flush_file, srm_path, FA_WRITE | FA_OPEN_ALWAYS) != FR_OK) {
+            // Card not writable: drop the job instead of retrying every frame
+            LOG("Cartridge save: cannot open %s\n", srm_path);
+            job_failed = true;
+            flushed_generation = job_generation;
+            return;
+        }
+        flush_open = true;
+        flush_done = 0;
+    }
+
+    uint32_t chunk = job_size - flush_done;
+    if (chunk > CARTSAVE_FLUSH_CHUNK) chunk = CARTSAVE_FLUSH_CHUNK;
+
+    UINT bw = 0;
+    uint32_t offset = job_offset + flush_done;
+    FRESULT res = f_lseek(&flush_file, offset);
+    if (res == FR_OK) {
+        res = f_write(&flush_file, staging + offset, chunk, &bw);
+    }
+    flush_done += bw;
+
+    if (res != FR_OK || bw != chunk || flush_done >= job_size) {
+        // Cut a padded file down to the save size, it loads as is next time
+        uint32_t size = gwenesis_sram_size();
+        if (res == FR_OK && f_size(&flush_file) > size &&
+            f_lseek(&flush_file, size) == FR_OK) {
+            res = f_truncate(&flush_file);
+        }
+        f_close(&flush_file);
+        flush_open = false;
+        if (res != FR_OK || bw != chunk) {
+            LOG("Cartridge save: SD write failed (%d)\n", res);
+            job_failed = true;
+        }
+        flushed_generation = job_generation;
+    }
+}
+
+void cartsave_flush_step(void) {
+    if (staging == NULL || job_generation == flushed_generation) return;
+
+    // Never wait for the card: core 0 may be using it
+    if (!quicksave_sd_try_lock()) return;
+    cartsave_write_chunk();
+    quicksave_sd_unlock();
+}
+
+void cartsave_sync(void) {
+    if (staging == NULL) return;
+
+    quicksave_sd_lock();
+    while (job_generation != flushed_generation) {
+        cartsave_write_chunk();
+    }
+    cartsave_publish();
+    while (job_generation != flushed_generation) {
+        cartsave_write_chunk();
+    }
+    quicksave_sd_unlock();
+}
@@ -0,0 +1,44 @@
+/*
+ * Cartridge saves - battery SRAM / EEPROM persistence
+ * The save memory is loaded from genesis/<rom name>.srm at startup. Once
+ * the game stops writing to it, the changed sectors are handed to core 1,
+ * which writes them to the SD card a few sectors per frame.
+ */
+#ifndef CARTSAVE_H
+#define CARTSAVE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Frames without a write before the dirty range is flushed (~0.5 s)
+#ifndef CARTSAVE_SETTLE_FRAMES
+#define CARTSAVE_SETTLE_FRAMES 30
+#endif
+
+// Bytes written to the SD card per core 1 idle step (4 sectors)
+#ifndef CARTSAVE_FLUSH_CHUNK
+#define CARTSAVE_FLUSH_CHUNK 2048
+#endif
+
+/**
+ * Load the save file for the ROM (/genesis/game.md -> /genesis/game.srm)
+ * and map the save memory. Call after the ROM is loaded.
+ */
+void cartsave_init(const char *rom_path);
+
+/**
+ * Hand settled writes over to core 1 (core 0, once per frame)
+ */
+void cartsave_frame(void);
+
+/**
+ * Write the next chunk of pending save data (core 1 idle time)
+ */
+void cartsave_flush_step(void);
+
+/**
+ * Write everything still pending, blocking (before a restart)
+ */
+void cartsave_sync(void);
+
+#endif // CARTSAVE_H
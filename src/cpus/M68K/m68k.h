@@ -171,7 +171,12 @@ extern void m68k_write_ram8_fast(uint32_t address, uint32_t value);
 	extern unsigned char M68K_RAM[];
 #endif
 
-#define FETCH8ROM(A) ((ROM_DATA[((A) ^ 1)]))
+/* Host address of a cartridge address through the ROM bank map
+ * (512 KB slots, see ROM_BANK_SHIFT in gwenesis_bus.h) */
+extern uintptr_t m68k_rom_map[];
+#define M68K_ROM_HOST(A) (m68k_rom_map[((A) >> 19) & 15] + (A))
+
+#define FETCH8ROM(A) (*(unsigned char *)M68K_ROM_HOST((A) ^ 1))
 #define FETCH16ROM(A) m68k_read_rom16_fast(A)
 #define FETCH32ROM(A) m68k_read_rom32_fast(A)
 
@@ -359,6 +364,8 @@ typedef struct
 
   uint address_space;   /* Current FC code */
 
+  uint int_check;       /* IRQ level changed, m68k_run() checks on entry */
+
 #ifdef M68K_OVERCLOCK_SHIFT
   int cycle_ratio;
 #endif
@@ -480,6 +487,17 @@ extern void m68k_set_reg(m68k_register_t reg, unsigned int value);
 extern void gwenesis_m68k_save_state();
 extern void gwenesis_m68k_load_state();
 
+/* dbf copy/fill loops run as block moves (M68K_BLOCK_MOVES), counts since
+ * the previous call */
+typedef struct {
+  unsigned int loops;       /* Block moves (a loop split by a slice end counts per part) */
+  unsigned int iterations;  /* Loop iterations they replaced */
+  unsigned int bytes;       /* Bytes copied, filled or cleared, VDP included */
+  unsigned int vdp_words;   /* Words sent to the VDP data port */
+} m68k_block_stats_t;
+
+extern void m68k_block_get_stats(m68k_block_stats_t *out);
+
 /* Opcode profiling - to identify hot instructions for optimization */
 #ifdef M68K_OPCODE_PROFILING
 extern void m68k_print_opcode_profile(void);
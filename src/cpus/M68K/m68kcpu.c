@@ -11,7 +11,17 @@ extern int vdp_68k_irq_ack(int int_level);
 /* ================================ INCLUDES ============================== */
 /* ======================================================================== */
 
-#ifndef BUILD_TABLES
+/* Dispatch through the two-level SRAM tables generated at build time from
+ * the flat tables (see m68ki_dispatch_gen.py) instead of the 256 KB jump
+ * table and 64 KB cycle table read through the XIP cache. The assembly
+ * loop (m68k_core_opt.S) needs the flat tables. */
+#ifndef M68K_COMPACT_DISPATCH
+#define M68K_COMPACT_DISPATCH 0
+#endif
+
+#if M68K_COMPACT_DISPATCH
+  #include "m68ki_dispatch.h"
+#elif !defined(BUILD_TABLES)
   #ifndef TABLES_FULL
     #include "m68ki_cycles.h"
   #else
@@ -23,6 +33,41 @@ extern int vdp_68k_irq_ack(int int_level);
 #include "m68kcpu.h"
 #include "m68kops.h"
 #include "gwenesis_savestate.h"
+#include "cycprof.h"
+#include "gwenesis_vdp.h"
+
+#if CYCLE_PROFILING && !M68K_COMPACT_DISPATCH
+#error "CYCLE_PROFILING needs M68K_COMPACT_DISPATCH (handler indices)"
+#endif
+
+/* Superinstructions (flag setter + Bcc, one-instruction dbf loops) need the
+ * handler ordering of the compact tables */
+#ifndef M68K_FUSION
+#define M68K_FUSION M68K_COMPACT_DISPATCH
+#endif
+
+#if M68K_FUSION && (!M68K_COMPACT_DISPATCH || M68K_EMULATE_PREFETCH || M68K_EMULATE_TRACE)
+#error "M68K_FUSION needs M68K_COMPACT_DISPATCH without prefetch or trace emulation"
+#endif
+
+/* Fused dbf copy/fill loops over RAM, ROM and the VDP data port run as one
+ * block move per scanline slice */
+#ifndef M68K_BLOCK_MOVES
+#define M68K_BLOCK_MOVES M68K_FUSION
+#endif
+
+#if M68K_BLOCK_MOVES && !M68K_FUSION
+#error "M68K_BLOCK_MOVES needs M68K_FUSION"
+#endif
+
+/* Slice loop for compact dispatch without the per-instruction trace,
+ * function code, address error and hook steps (all off in this build) */
+#if M68K_COMPACT_DISPATCH && !M68K_EMULATE_TRACE && !M68K_EMULATE_FC && \
+    !M68K_EMULATE_ADDRESS_ERROR && !defined(HOOK_CPU)
+#define M68K_SLICE_LOOP 1
+#else
+#define M68K_SLICE_LOOP 0
+#endif
 
 /* Enable assembly-optimized instruction handlers */
 /* Disabled: 256KB jump table doesn't fit in RAM */
@@ -178,9 +223,11 @@ void m68k_check_profile_report(void) {
 /* ====================== EXPORTS FOR ASSEMBLY CORE ====================== */
 /* ======================================================================== */
 
+#if !M68K_COMPACT_DISPATCH
 /* Export pointers to static tables for assembly-optimized core */
 const unsigned char *m68k_cycles_table = m68ki_cycles;
 void (**m68k_instruction_table)(void) = (void (**)(void))m68ki_instruction_jump_table;
+#endif
 
 /* Helper function for assembly core - fetches next instruction word */
 uint16_t m68k_fetch_opcode(void) {
@@ -454,6 +501,7 @@ void m68k_update_irq(unsigned int mask)
 {
   /* Update IRQ level */
   CPU_INT_LEVEL |= (mask << 8);
+  m68ki_cpu.int_check = 1;
   
 #ifdef LOGERROR
   error("[%d(%d)][%d(%d)] m68k IRQ Level = %d(0x%02x) (%x)\n", v_counter, m68k.cycles/3420, m68k.cycles, m68k.cycles%3420,CPU_INT_LEVEL>>8,FLAG_INT_MASK,m68k_get_reg(M68K_REG_PC));
@@ -464,6 +512,7 @@ void m68k_set_irq(unsigned int int_level)
 {
   /* Set IRQ level */
   CPU_INT_LEVEL = int_level << 8;
+  m68ki_cpu.int_check = 1;
   
 #ifdef LOGERROR
   error("[%d(%d)][%d(%d)] m68k IRQ Level = %d(0x%02x) (%x)\n", v_counter, m68k.cycles/3420, m68k.cycles, m68k.cycles%3420,CPU_INT_LEVEL>>8,FLAG_INT_MASK,m68k_get_reg(M68K_REG_PC));
@@ -482,14 +531,14 @@ void m68k_set_irq_delay(unsigned int int_level)
     if ((REG_IR & 0xF000) != 0x2000)
     {
       /* Finish executing current instruction */
-      USE_CYCLES(CYC_INSTRUCTION[REG_IR]);
+      USE_CYCLES(CYC_INSTRUCTION(REG_IR));
 
       /* One instruction delay before interrupt */
       irq_latency = 1;
       m68ki_trace_t1() /* auto-disable (see m68kcpu.h) */
       m68ki_use_data_space() /* auto-disable (see m68kcpu.h) */
       REG_IR = m68ki_read_imm_16();
-      m68ki_instruction_jump_table[REG_IR]();
+      m68ki_instruction_handler(REG_IR)();
       m68ki_exception_if_trace() /* auto-disable (see m68kcpu.h) */
       irq_latency = 0;
     }
@@ -506,6 +555,344 @@ void m68k_set_irq_delay(unsigned int int_level)
   m68ki_check_interrupts(); /* Level triggered (IRQ) */
 }
 
+#if M68K_FUSION
+/* ======================================================================== */
+/* =========================== SUPERINSTRUCTIONS ========================== */
+/* ======================================================================== */
+
+/* After a handler below M68KI_FUSE_HANDLERS (see m68ki_dispatch_gen.py) the
+ * next instruction is decoded here and run without another pass through
+ * the dispatcher. Only ROM code is fused and only while the slice has
+ * cycles left, so cycle counts, flags and interrupt points are exactly
+ * those of the plain loop. */
+
+/* Fetch window range, cartridge ROM */
+#define M68KI_FUSE_ROM_END 0x800000
+
+static int m68ki_cond_true(uint cond)
+{
+  switch (cond)
+  {
+    case 0x0: return 1;
+    case 0x2: return COND_HI();
+    case 0x3: return COND_LS();
+    case 0x4: return COND_CC();
+    case 0x5: return COND_CS();
+    case 0x6: return COND_NE();
+    case 0x7: return COND_EQ();
+    case 0x8: return COND_VC();
+    case 0x9: return COND_VS();
+    case 0xa: return COND_PL();
+    case 0xb: return COND_MI();
+    case 0xc: return COND_GE();
+    case 0xd: return COND_LT();
+    case 0xe: return COND_GT();
+    default:  return COND_LE();
+  }
+}
+
+/* tst/cmp/btst/subq followed by Bcc.b or Bcc.w (BRA too, not BSR) */
+static void m68ki_fuse_bcc(void)
+{
+  uint pc = REG_PC;
+  uint op;
+
+  if (pc >= M68KI_FUSE_ROM_END || m68ki_cpu.cycles >= m68ki_cpu.cycle_end)
+    return;
+  op = m68ki_peek_rom_16(pc);
+  if ((op & 0xf000) != 0x6000 || (op & 0x0f00) == 0x0100 || (op & 0xff) == 0xff)
+    return;
+
+  REG_IR = op;
+  REG_PC = pc + 2;
+  if (m68ki_cond_true((op >> 8) & 0xf))
+  {
+    if (op & 0xff)
+      m68ki_branch_8(MASK_OUT_ABOVE_8(op));
+    else
+    {
+      uint offset = OPER_I_16();
+      REG_PC -= 2;
+      m68ki_branch_16(offset);
+    }
+  }
+  else if (op & 0xff)
+    USE_CYCLES(CYC_BCC_NOTAKE_B);
+  else
+  {
+    REG_PC += 2;
+    USE_CYCLES(CYC_BCC_NOTAKE_W);
+  }
+  USE_CYCLES(CYC_INSTRUCTION(op));
+}
+
+/* Loop bodies run without the dispatcher: move.b/w/l and clr.b/w/l
+ * between data registers, (An), (An)+ and -(An) */
+static int m68ki_fuse_body(uint op)
+{
+  uint mode = (op >> 3) & 7;
+  uint size = op >> 12;
+
+  if (size >= 1 && size <= 3)
+  {
+    uint dst_mode = (op >> 6) & 7;
+    return dst_mode != 1 && dst_mode <= 4 && mode <= 4 && !(size == 1 && mode == 1);
+  }
+  if ((op & 0xff00) == 0x4200)
+    return ((op >> 6) & 3) != 3 && mode != 1 && mode <= 4;
+  return 0;
+}
+
+#if M68K_BLOCK_MOVES
+static m68k_block_stats_t m68ki_block_stats;
+
+void m68k_block_get_stats(m68k_block_stats_t *out)
+{
+  *out = m68ki_block_stats;
+  memset(&m68ki_block_stats, 0, sizeof(m68ki_block_stats));
+}
+
+/* Cycles of one taken loop iteration, charged exactly as the plain loop does */
+static uint m68ki_block_iter_cycles(uint body_cycles, uint dbf_cycles)
+{
+  uint start = m68ki_cpu.cycles;
+  uint iter;
+
+  USE_CYCLES(body_cycles);
+  USE_CYCLES(CYC_DBCC_F_NOEXP);
+  USE_CYCLES(dbf_cycles);
+  iter = m68ki_cpu.cycles - start;
+  m68ki_cpu.cycles = start;
+  return iter;
+}
+
+/* Up to n iterations of a dbf loop body as one block move, returns how many
+ * ran (0 when the body or its ranges do not qualify, the caller then steps
+ * the loop). Bodies: move.w/.l (Ay)+ or Dn, and clr.w/.l, to (Ax)+ in work
+ * RAM or to (Ax) at the VDP data port; sources stream from RAM or ROM.
+ * A copy whose destination overlaps ahead of its source is left to the
+ * plain loop, memmove would not repeat the pattern the 68K leaves. */
+static uint m68ki_block_move(uint op, uint n)
+{
+  uint src_reg = op & 7;
+  uint dst_reg, dst_mode, size, src_addr = 0, dst_addr, value = 0, last = 0;
+  uint done = 0, zero = 0, stream = 0, vdp, avail, chunk, words, bytes;
+  uint16_t fill[2];
+
+  if ((op & 0xff00) == 0x4200)
+  {
+    /* clr.<size> (Ay)+ / (Ay) */
+    size = ((op >> 6) & 3) << 1;
+    dst_mode = (op >> 3) & 7;
+    dst_reg = src_reg;
+    zero = 1;
+  }
+  else
+  {
+    size = (op >> 12) == 3 ? 2 : (op >> 12) == 2 ? 4 : 0;
+    dst_mode = (op >> 6) & 7;
+    dst_reg = (op >> 9) & 7;
+    switch ((op >> 3) & 7)
+    {
+      case 0: value = size == 2 ? MASK_OUT_ABOVE_16(REG_D[src_reg]) : REG_D[src_reg]; break;
+      case 3: stream = 1; break;
+      default: return 0;
+    }
+  }
+  if (size == 0)
+    return 0;
+
+  dst_addr = ADDRESS_68K(REG_A[dst_reg]);
+  vdp = dst_mode == 2 && dst_addr >= 0xc00000 && dst_addr + size <= 0xc00004;
+  if ((!vdp && dst_mode != 3) || (dst_addr & 1))
+    return 0;
+  if (stream)
+  {
+    src_addr = ADDRESS_68K(REG_A[src_reg]);
+    if (src_reg == dst_reg || (src_addr & 1))
+      return 0;
+  }
+  fill[0] = size == 2 ? value : value >> 16;
+  fill[1] = value;
+  words = size >> 1;
+
+  while (done < n)
+  {
+    const uint16_t *src = fill;
+    uint16_t *dst = NULL;
+
+    chunk = n - done;
+    if (stream)
+    {
+      src = m68k_block_ptr(src_addr, 0, &avail);
+      if (src == NULL || avail / size < chunk)
+        chunk = src == NULL ? 0 : avail / size;
+    }
+    if (!vdp)
+    {
+      dst = m68k_block_ptr(dst_addr, 1, &avail);
+      if (dst == NULL || avail / size < chunk)
+        chunk = dst == NULL ? 0 : avail / size;
+    }
+    if (chunk == 0)
+      break;
+    bytes = chunk * size;
+
+    if (stream)
+    {
+      last = size == 2 ? src[chunk - 1] : (src[2 * chunk - 2] << 16) | src[2 * chunk - 1];
+      if (vdp)
+        gwenesis_vdp_write_data_port_block(src, chunk * words, ~0u);
+      else if (dst > src && (const uint8_t *)dst < (const uint8_t *)src + bytes)
+        break;
+      else
+        memmove(dst, src, bytes);
+      src_addr += bytes;
+    }
+    else if (vdp)
+      gwenesis_vdp_write_data_port_block(fill, chunk * words, words - 1);
+    else if (zero)
+      memset(dst, 0, bytes);
+    else
+    {
+      for (uint i = 0; i < chunk * words; i++)
+        dst[i] = fill[i & (words - 1)];
+    }
+    if (!vdp)
+      dst_addr += bytes;
+    done += chunk;
+  }
+  if (done == 0)
+    return 0;
+
+  if (stream)
+    REG_A[src_reg] += done * size;
+  if (!vdp)
+    REG_A[dst_reg] += done * size;
+  if (!stream)
+    last = value;
+  FLAG_N = size == 2 ? NFLAG_16(last) : NFLAG_32(last);
+  FLAG_Z = last;
+  FLAG_V = VFLAG_CLEAR;
+  FLAG_C = CFLAG_CLEAR;
+
+  m68ki_block_stats.loops++;
+  m68ki_block_stats.iterations += done;
+  m68ki_block_stats.bytes += done * size;
+  if (vdp)
+    m68ki_block_stats.vdp_words += done * words;
+  return done;
+}
+#endif /* M68K_BLOCK_MOVES */
+
+/* dbf Dn,*-2 that just branched back to a one-word body: copy and fill loops */
+static void m68ki_fuse_dbf(uint ir)
+{
+  uint body_pc = REG_PC;
+  uint dbf_pc = body_pc + 2;
+  uint *counter = &REG_D[ir & 7];
+  uint op, entry, body_cycles, dbf_cycles, res;
+  void (*body)(void);
+
+  if (dbf_pc + 2 >= M68KI_FUSE_ROM_END)
+    return;
+  if (m68ki_peek_rom_16(dbf_pc) != ir || m68ki_peek_rom_16(dbf_pc + 2) != 0xfffc)
+    return;
+  op = m68ki_peek_rom_16(body_pc);
+  if (!m68ki_fuse_body(op))
+    return;
+
+  entry = m68ki_dispatch_entry(op);
+  body = m68ki_dispatch_handlers[entry >> M68KI_DISPATCH_CYC_BITS];
+  body_cycles = M68KI_DISPATCH_CYCLES(entry);
+  dbf_cycles = CYC_INSTRUCTION(ir);
+
+#if M68K_BLOCK_MOVES
+  /* Taken iterations that end before the slice does at once, the loop
+   * below steps the rest (the final one, or one the slice splits) */
+  if (m68ki_cpu.cycles < m68ki_cpu.cycle_end)
+  {
+    uint iter = m68ki_block_iter_cycles(body_cycles, dbf_cycles);
+    uint n = MASK_OUT_ABOVE_16(*counter);
+    uint fit = (m68ki_cpu.cycle_end - m68ki_cpu.cycles - 1) / iter;
+
+    n = m68ki_block_move(op, n < fit ? n : fit);
+    if (n)
+    {
+      *counter = MASK_OUT_BELOW_16(*counter) | (MASK_OUT_ABOVE_16(*counter) - n);
+      m68ki_cpu.cycles += n * iter;
+      m68ki_cpu.poll.detected = 0;
+    }
+  }
+#endif
+
+  while (m68ki_cpu.cycles < m68ki_cpu.cycle_end)
+  {
+    REG_IR = op;
+    REG_PC = dbf_pc;
+    body();
+
+    /* m68k_set_irq_delay() ran the dbf too, continue in the plain loop */
+    if (REG_IR != op)
+    {
+      USE_CYCLES(CYC_INSTRUCTION(REG_IR));
+      return;
+    }
+    USE_CYCLES(body_cycles);
+    if (REG_PC != dbf_pc || m68ki_cpu.cycles >= m68ki_cpu.cycle_end)
+      return;
+
+    REG_IR = ir;
+    res = MASK_OUT_ABOVE_16(*counter - 1);
+    *counter = MASK_OUT_BELOW_16(*counter) | res;
+    if (res == 0xffff)
+    {
+      REG_PC = dbf_pc + 4;
+      USE_CYCLES(CYC_DBCC_F_EXP);
+      USE_CYCLES(dbf_cycles);
+      return;
+    }
+    REG_PC = body_pc;
+    USE_CYCLES(CYC_DBCC_F_NOEXP);
+    USE_CYCLES(dbf_cycles);
+    m68ki_cpu.poll.detected = 0;
+  }
+}
+#endif /* M68K_FUSION */
+
+#if M68K_COMPACT_DISPATCH
+/* Execute the instruction in REG_IR through the compact tables, charge its
+ * cycles and fuse it with the next one when it is a fusion candidate */
+INLINE void m68ki_dispatch_ir(void)
+{
+  uint ir = REG_IR;
+  uint entry = m68ki_dispatch_entry(ir);
+  uint handler = entry >> M68KI_DISPATCH_CYC_BITS;
+
+  CYCPROF_BEGIN();
+  m68ki_dispatch_handlers[handler]();
+  CYCPROF_END(CYCPROF_M68K, handler);
+
+  if (REG_IR != ir)
+  {
+    /* m68k_set_irq_delay() ran the next instruction too */
+    USE_CYCLES(M68KI_DISPATCH_CYCLES(m68ki_dispatch_entry(REG_IR)));
+    return;
+  }
+  USE_CYCLES(M68KI_DISPATCH_CYCLES(entry));
+
+#if M68K_FUSION
+  if (handler < M68KI_FUSE_HANDLERS)
+  {
+    if (handler == M68KI_HANDLER_DBF)
+      m68ki_fuse_dbf(ir);
+    else
+      m68ki_fuse_bcc();
+  }
+#endif
+}
+#endif /* M68K_COMPACT_DISPATCH */
+
 void m68k_run(unsigned int cycles) 
 {
     //  printf("m68K_run current_cycles=%d add=%d STOP=%x\n",m68k.cycles,cycles,CPU_STOPPED);
@@ -516,8 +903,13 @@ void m68k_run(unsigned int cycles)
     return;
   }
 
-  /* Check interrupt mask to process IRQ if needed */
-  m68ki_check_interrupts();
+  /* Check interrupt mask to process IRQ if needed. SR writes check at once,
+   * so only a new IRQ level (m68k_set_irq/m68k_update_irq) is left to here */
+  if (m68k.int_check)
+  {
+    m68k.int_check = 0;
+    m68ki_check_interrupts();
+  }
 
   /* Make sure we're not stopped */
   if (CPU_STOPPED)
@@ -529,6 +921,17 @@ void m68k_run(unsigned int cycles)
   /* Save end cycles count for when CPU is stopped */
   m68k.cycle_end = cycles;
 
+#if M68K_SLICE_LOOP
+  /* Trace, function codes, address errors and the hook are off, so only
+   * the fetch and the dispatch are left per instruction. The cycle count
+   * stays in m68k.cycles: handlers and the bus charge it themselves
+   * (taken branches, exceptions, STOP, DMA) and timestamp I/O with it. */
+  while (m68k.cycles < cycles)
+  {
+    REG_IR = m68ki_read_imm_16();
+    m68ki_dispatch_ir();
+  }
+#else
   /* Return point for when we have an address error (TODO: use goto) */
   m68ki_set_address_error_trap() /* auto-disable (see m68kcpu.h) */
 
@@ -553,20 +956,32 @@ void m68k_run(unsigned int cycles)
     /* Decode next instruction */
     REG_IR = m68ki_read_imm_16();
 
-//    printf("PC=%x IR=%x CYCLES=%d \n",m68k.pc,REG_IR,CYC_INSTRUCTION[REG_IR]);
+//    printf("PC=%x IR=%x CYCLES=%d \n",m68k.pc,REG_IR,CYC_INSTRUCTION(REG_IR));
 
     /* Execute instruction */
+#if M68K_COMPACT_DISPATCH
+    m68ki_dispatch_ir();
+#else
     m68ki_instruction_jump_table[REG_IR]();
-    USE_CYCLES(CYC_INSTRUCTION[REG_IR]);
+    USE_CYCLES(CYC_INSTRUCTION(REG_IR));
+#endif
 
     /* Trace m68k_exception, if necessary */
     m68ki_exception_if_trace(); /* auto-disable (see m68kcpu.h) */
   }
+#endif /* M68K_SLICE_LOOP */
 }
 
+#if CYCLE_PROFILING
+const char *m68k_handler_name(unsigned int index)
+{
+  return index < M68KI_DISPATCH_HANDLERS ? m68ki_dispatch_names[index] : NULL;
+}
+#endif
+
 int m68k_cycles(void)
 {
-  return CYC_INSTRUCTION[REG_IR];
+  return CYC_INSTRUCTION(REG_IR);
 }
 
 int m68k_cycles_run(void)
@@ -626,6 +1041,7 @@ void m68k_pulse_reset(void)
   /* Interrupt mask to level 7 */
   FLAG_INT_MASK = 0x0700;
   CPU_INT_LEVEL = 0;
+  m68ki_cpu.int_check = 1;
   irq_latency = 0;
 
   /* Go to supervisor mode */
@@ -695,6 +1111,7 @@ void gwenesis_m68k_load_state() {
   m68k.cycles = saveGwenesisStateGet(state, "m68k_cycles");
   m68k.int_level = saveGwenesisStateGet(state, "m68k_int_level");
   m68k.stopped = saveGwenesisStateGet(state, "m68k_stopped");
+  m68k.int_check = 1;
 
 }
 
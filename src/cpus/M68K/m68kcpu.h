@@ -14,6 +14,7 @@
 #endif /* M68K_EMULATE_ADDRESS_ERROR */
 
 #include "m68k.h"
+#include "gwenesis_bus.h"
 
 /* ======================================================================== */
 /* ============================ GENERAL DEFINES =========================== */
@@ -213,7 +214,20 @@
 #define CPU_RUN_MODE     m68ki_cpu.run_mode
 #endif
 
-#define CYC_INSTRUCTION   m68ki_cycles
+#if M68K_COMPACT_DISPATCH
+/* Packed entry of the generated dispatch tables (m68ki_dispatch.h) */
+#define m68ki_dispatch_entry(ir) \
+  m68ki_dispatch_rows[((uint)m68ki_dispatch_top[(ir) >> M68KI_DISPATCH_SHIFT] << M68KI_DISPATCH_SHIFT) | \
+                      ((ir) & ((1 << M68KI_DISPATCH_SHIFT) - 1))]
+#define M68KI_DISPATCH_CYCLES(entry) \
+  (((entry) & ((1 << M68KI_DISPATCH_CYC_BITS) - 1)) * 2 * MUL)
+#define m68ki_instruction_handler(ir) \
+  m68ki_dispatch_handlers[m68ki_dispatch_entry(ir) >> M68KI_DISPATCH_CYC_BITS]
+#define CYC_INSTRUCTION(ir)  M68KI_DISPATCH_CYCLES(m68ki_dispatch_entry(ir))
+#else
+#define m68ki_instruction_handler(ir) m68ki_instruction_jump_table[ir]
+#define CYC_INSTRUCTION(ir)  m68ki_cycles[ir]
+#endif
 #define CYC_EXCEPTION     m68ki_exception_cycle_table
 #define CYC_BCC_NOTAKE_B  ( -2 * MUL)
 #define CYC_BCC_NOTAKE_W  (  2 * MUL)
@@ -784,8 +798,44 @@ INLINE void m68ki_check_interrupts(void);            /* ASG: check for interrupt
 
 /* ---------------------------- Read Immediate ---------------------------- */
 
+/* Fetch outside the SRAM window: move it to the new ROM page, or read RAM */
+static uint m68ki_read_imm_16_slow(uint pc)
+{
+#if M68K_FETCH_STATS
+  m68k_fetch_window.outside++;
+#endif
+  if (pc >= 0x800000)
+    return m68k_read_immediate_16(pc);
+  m68k_fetch_window_refill(pc);
+  return *(const uint16 *)(m68k_fetch_window.base + pc);
+}
+
+static uint m68ki_read_imm_32_slow(uint pc)
+{
+  /* Straddles two ROM pages */
+  if (pc < 0x800000 && (pc & (M68K_FETCH_WINDOW_SIZE - 1)) >= M68K_FETCH_WINDOW_SIZE - 2)
+    return (m68ki_read_imm_16_slow(pc) << 16) | m68ki_read_imm_16_slow(pc + 2);
+#if M68K_FETCH_STATS
+  m68k_fetch_window.outside++;
+#endif
+  if (pc >= 0x800000)
+    return m68k_read_immediate_32(pc);
+  m68k_fetch_window_refill(pc);
+  const uint16 *p = (const uint16 *)(m68k_fetch_window.base + pc);
+  return ((uint)p[0] << 16) | p[1];
+}
+
+/* ROM word at pc without fetching it (decode-time lookahead, pc < 0x800000) */
+INLINE uint m68ki_peek_rom_16(uint pc)
+{
+  if (pc - m68k_fetch_window.start >= M68K_FETCH_WINDOW_SIZE)
+    m68k_fetch_window_refill(pc);
+  return *(const uint16 *)(m68k_fetch_window.base + pc);
+}
+
 /* Handles all immediate reads, does address error check, function code setting,
  * and prefetching if they are enabled in m68kconf.h
+ * Without prefetch emulation ROM code is read through the SRAM fetch window.
  */
 INLINE uint m68ki_read_imm_16(void)
 {
@@ -804,7 +854,12 @@ INLINE uint m68ki_read_imm_16(void)
 #else
   uint pc = REG_PC;
   REG_PC += 2;
-  return m68k_read_immediate_16(pc);
+#if M68K_FETCH_STATS
+  m68k_fetch_window.fetches++;
+#endif
+  if (pc - m68k_fetch_window.start < M68K_FETCH_WINDOW_SIZE)
+    return *(const uint16 *)(m68k_fetch_window.base + pc);
+  return m68ki_read_imm_16_slow(pc);
 #endif /* M68K_EMULATE_PREFETCH */
 }
 
@@ -840,7 +895,15 @@ INLINE uint m68ki_read_imm_32(void)
 #endif
   uint pc = REG_PC;
   REG_PC += 4;
-  return m68k_read_immediate_32(pc);
+#if M68K_FETCH_STATS
+  m68k_fetch_window.fetches++;
+#endif
+  if (pc - m68k_fetch_window.start < M68K_FETCH_WINDOW_SIZE - 2)
+  {
+    const uint16 *p = (const uint16 *)(m68k_fetch_window.base + pc);
+    return ((uint)p[0] << 16) | p[1];
+  }
+  return m68ki_read_imm_32_slow(pc);
 #endif /* M68K_EMULATE_PREFETCH */
 }
 
@@ -1375,7 +1438,7 @@ static void m68ki_exception_privilege_violation(void)
   m68ki_jump_vector(EXCEPTION_PRIVILEGE_VIOLATION);
 
   /* Use up some clock cycles and undo the instruction's cycles */
-  USE_CYCLES(CYC_EXCEPTION[EXCEPTION_PRIVILEGE_VIOLATION] - CYC_INSTRUCTION[REG_IR]);
+  USE_CYCLES(CYC_EXCEPTION[EXCEPTION_PRIVILEGE_VIOLATION] - CYC_INSTRUCTION(REG_IR));
 }
 
 /* Exception for A-Line instructions */
@@ -1386,7 +1449,7 @@ INLINE void m68ki_exception_1010(void)
   m68ki_jump_vector(EXCEPTION_1010);
 
   /* Use up some clock cycles and undo the instruction's cycles */
-  USE_CYCLES(CYC_EXCEPTION[EXCEPTION_1010] - CYC_INSTRUCTION[REG_IR]);
+  USE_CYCLES(CYC_EXCEPTION[EXCEPTION_1010] - CYC_INSTRUCTION(REG_IR));
 }
 
 /* Exception for F-Line instructions */
@@ -1397,7 +1460,7 @@ INLINE void m68ki_exception_1111(void)
   m68ki_jump_vector(EXCEPTION_1111);
 
   /* Use up some clock cycles and undo the instruction's cycles */
-  USE_CYCLES(CYC_EXCEPTION[EXCEPTION_1111] - CYC_INSTRUCTION[REG_IR]);
+  USE_CYCLES(CYC_EXCEPTION[EXCEPTION_1111] - CYC_INSTRUCTION(REG_IR));
 }
 
 /* Exception for illegal instructions */
@@ -1413,7 +1476,7 @@ INLINE void m68ki_exception_illegal(void)
   m68ki_jump_vector(EXCEPTION_ILLEGAL_INSTRUCTION);
 
   /* Use up some clock cycles and undo the instruction's cycles */
-  USE_CYCLES(CYC_EXCEPTION[EXCEPTION_ILLEGAL_INSTRUCTION] - CYC_INSTRUCTION[REG_IR]);
+  USE_CYCLES(CYC_EXCEPTION[EXCEPTION_ILLEGAL_INSTRUCTION] - CYC_INSTRUCTION(REG_IR));
 }
 
 
@@ -1430,7 +1493,7 @@ INLINE void m68ki_exception_address_error(void)
   if(CPU_RUN_MODE == RUN_MODE_BERR_AERR_RESET)
   {
     CPU_STOPPED = STOP_LEVEL_HALT;
-    SET_CYCLES(m68ki_cpu.cycle_end - CYC_INSTRUCTION[REG_IR]);
+    SET_CYCLES(m68ki_cpu.cycle_end - CYC_INSTRUCTION(REG_IR));
     return;
   }
   CPU_RUN_MODE = RUN_MODE_BERR_AERR_RESET;
@@ -1441,7 +1504,7 @@ INLINE void m68ki_exception_address_error(void)
   m68ki_jump_vector(EXCEPTION_ADDRESS_ERROR);
 
   /* Use up some clock cycles and undo the instruction's cycles */
-  USE_CYCLES(CYC_EXCEPTION[EXCEPTION_ADDRESS_ERROR] - CYC_INSTRUCTION[REG_IR]);
+  USE_CYCLES(CYC_EXCEPTION[EXCEPTION_ADDRESS_ERROR] - CYC_INSTRUCTION(REG_IR));
 }
 #endif
 
@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+"""
+Generate the compact M68K dispatch tables (m68ki_dispatch.h).
+
+The flat tables (m68ki_instruction_jump_table_full.h, 65536 handler
+pointers = 256 KB, and m68ki_cycles_full.h, 64 KB) stay in flash and are
+read through the 16 KB XIP cache on every instruction, competing with
+PSRAM opcode fetches. This script folds them into a two-level table small
+enough for SRAM:
+
+  top[opcode >> SHIFT]                  -> row index
+  rows[(row << SHIFT) | (opcode & MASK)] -> entry (16 bits)
+  entry = handler index << CYC_BITS | 68000 cycles / 2
+
+Identical rows are shared and handlers are deduplicated, the row size is
+chosen to minimise the total size. Cycle values are stored in 68000 clocks
+and scaled by MUL in m68kcpu.c.
+
+Handlers that can start a superinstruction come first so the run loop
+needs a single compare to find them: the flag setters that are fused with
+a following Bcc, then dbf (see m68ki_fuse_* in m68kcpu.c).
+
+Usage: m68ki_dispatch_gen.py <jump_table_full.h> <cycles_full.h> <out.h>
+"""
+import re
+import sys
+
+CYC_BITS = 5
+ENTRY_BITS = 16
+
+# Flag setters fused with a following Bcc (subq to An leaves the flags alone)
+FUSE_FLAGS = re.compile(r'm68k_op_(tst|cmp|cmpa|cmpi|cmpm|btst|subq)_(?!(16|32)_a$)')
+FUSE_DBF = 'm68k_op_dbf_16'
+
+
+def fuse_class(name):
+    if FUSE_FLAGS.match(name):
+        return 0
+    if name == FUSE_DBF:
+        return 1
+    return 2
+
+
+def table_body(path):
+    text = open(path).read()
+    return text[text.index('{') + 1:text.rindex('}')]
+
+
+def load_tables(jump_path, cycles_path):
+    handlers = re.findall(r'[A-Za-z_]\w*', table_body(jump_path))
+    cycles = [int(n) for n in re.findall(r'(\d+)\s*\*\s*\d+', table_body(cycles_path))]
+    if len(handlers) != 0x10000 or len(cycles) != 0x10000:
+        sys.exit('m68ki_dispatch_gen: expected 65536 entries, got %d handlers / %d cycles'
+                 % (len(handlers), len(cycles)))
+    return handlers, cycles
+
+
+def build(handlers, cycles):
+    names = sorted(set(handlers), key=lambda name: (fuse_class(name), name))
+    if len(names) > 1 << (ENTRY_BITS - CYC_BITS):
+        sys.exit('m68ki_dispatch_gen: %d handlers do not fit in %d bits'
+                 % (len(names), ENTRY_BITS - CYC_BITS))
+    index = {name: i for i, name in enumerate(names)}
+
+    entries = []
+    for name, cyc in zip(handlers, cycles):
+        if cyc & 1 or cyc >> 1 >= 1 << CYC_BITS:
+            sys.exit('m68ki_dispatch_gen: cycle count %d does not fit' % cyc)
+        entries.append(index[name] << CYC_BITS | cyc >> 1)
+
+    best = None
+    for shift in range(2, 10):
+        size = 1 << shift
+        rows = {}
+        top = []
+        for base in range(0, 0x10000, size):
+            row = tuple(entries[base:base + size])
+            top.append(rows.setdefault(row, len(rows)))
+        total = len(top) * 2 + len(rows) * size * 2
+        if best is None or total < best[0]:
+            best = (total, shift, top, list(rows))
+    _, shift, top, rows = best
+    return names, shift, top, rows
+
+
+def emit_array(out, decl, values, per_line):
+    out.append(decl + ' = {')
+    for i in range(0, len(values), per_line):
+        out.append('  ' + ', '.join(values[i:i + per_line]) + ',')
+    out.append('};')
+    out.append('')
+
+
+def main():
+    if len(sys.argv) != 4:
+        sys.exit(__doc__)
+    handlers, cycles = load_tables(sys.argv[1], sys.argv[2])
+    names, shift, top, rows = build(handlers, cycles)
+    row_entries = [e for row in rows for e in row]
+    ram = len(top) * 2 + len(row_entries) * 2 + len(names) * 4
+    flags = sum(1 for name in names if fuse_class(name) == 0)
+
+    out = [
+        '/* Generated by m68ki_dispatch_gen.py - do not edit */',
+        '/* %d handlers, %d rows of %d opcodes, %d bytes of SRAM */'
+        % (len(names), len(rows), 1 << shift, ram),
+        '',
+        '#include <stdint.h>',
+        '#include "pico.h"',
+        '',
+        '#define M68KI_DISPATCH_SHIFT    %d' % shift,
+        '#define M68KI_DISPATCH_CYC_BITS %d' % CYC_BITS,
+        '#define M68KI_DISPATCH_HANDLERS %d' % len(names),
+        '#define M68KI_FUSE_FLAGS        %d' % flags,
+        '#define M68KI_HANDLER_DBF       %d' % names.index(FUSE_DBF),
+        '#define M68KI_FUSE_HANDLERS     %d' % (names.index(FUSE_DBF) + 1),
+        '',
+    ]
+    out += ['static void %s(void);' % name for name in names]
+    out.append('')
+    emit_array(out, 'static void (* const __not_in_flash("m68k_dispatch") m68ki_dispatch_handlers[%d])(void)'
+               % len(names), names, 4)
+    emit_array(out, 'static const uint16_t __not_in_flash("m68k_dispatch") m68ki_dispatch_top[%d]'
+               % len(top), ['%d' % r for r in top], 16)
+    emit_array(out, 'static const uint16_t __not_in_flash("m68k_dispatch") m68ki_dispatch_rows[%d]'
+               % len(row_entries), ['0x%04x' % e for e in row_entries], 16)
+
+    # Handler names for the cycle profiler (flash, profiling builds only)
+    out.append('#if CYCLE_PROFILING')
+    emit_array(out, 'static const char * const m68ki_dispatch_names[%d]' % len(names),
+               ['"%s"' % name for name in names], 2)
+    out.append('#endif')
+    out.append('')
+
+    with open(sys.argv[3], 'w') as f:
+        f.write('\n'.join(out))
+
+
+if __name__ == '__main__':
+    main()
@@ -130,7 +130,7 @@ static void m68k_op_1010(void)
   m68ki_exception_1010();
 }
 
-#ifdef TABLES_FULL
+#if defined(TABLES_FULL) || M68K_COMPACT_DISPATCH
 
 static void m68k_op_1111(void)
 {
@@ -23670,7 +23670,9 @@ static void m68k_op_unlk_32(void)
 /* ========================= OPCODE TABLE BUILDER ========================= */
 /* ======================================================================== */
 
-#ifndef BUILD_TABLES
+#if M68K_COMPACT_DISPATCH
+  /* Tables come from m68ki_dispatch.h (included by m68kcpu.c) */
+#elif !defined(BUILD_TABLES)
 
   #ifndef TABLES_FULL
     #include "m68ki_instruction_jump_table.h"
@@ -53,6 +53,7 @@
 /* ======================================================================== */
 
 #include <setjmp.h>
+#include <stdint.h>
 #include "macros.h"
 
 /* ======================================================================== */
@@ -63,11 +64,16 @@
 extern unsigned char *ROM_DATA;
 extern unsigned char M68K_RAM[];
 
+/* Host address of a cartridge address through the ROM bank map
+ * (512 KB slots, see ROM_BANK_SHIFT in gwenesis_bus.h) */
+extern uintptr_t m68k_rom_map[];
+#define M68K_ROM_HOST(A) (m68k_rom_map[((A) >> 19) & 15] + (A))
+
 /* Fast memory access macros */
 /* ROM is byte-swapped at load time for native ldrh/strh access (little-endian pairs) */
-#define FETCH8ROM(A) ((ROM_DATA[((A) ^ 1)]))
-#define FETCH16ROM(A) (*(unsigned short *)&ROM_DATA[(A)])
-#define FETCH32ROM(A) ((*(unsigned int *)&ROM_DATA[(A)] << 16) | (*(unsigned int *)&ROM_DATA[(A)] >> 16))
+#define FETCH8ROM(A) (*(unsigned char *)M68K_ROM_HOST((A) ^ 1))
+#define FETCH16ROM(A) (*(unsigned short *)M68K_ROM_HOST(A))
+#define FETCH32ROM(A) ((*(unsigned int *)M68K_ROM_HOST(A) << 16) | (*(unsigned int *)M68K_ROM_HOST(A) >> 16))
 
 /* RAM is stored in native little-endian format (for ldrh/strh efficiency) */
 /* Use direct 16-bit access to match original M68K core format */
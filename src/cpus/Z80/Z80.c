@@ -20,6 +20,7 @@
 
 #include "Z80.h"
 #include "Tables.h"
+#include "cycprof.h"
 #include <stdio.h>
 
 /** INLINE ***************************************************/
@@ -543,6 +544,7 @@ int ExecZ80(register Z80 *R,register int RunCycles)
       R->ICount-=Cycles[I];
 
       /* Interpret opcode */
+      CYCPROF_BEGIN();
       switch(I)
       {
 #include "Codes.h"
@@ -551,6 +553,7 @@ int ExecZ80(register Z80 *R,register int RunCycles)
         case PFX_FD: CodesFD(R);break;
         case PFX_DD: CodesDD(R);break;
       }
+      CYCPROF_END(CYCPROF_Z80_C,I);
 
       /* Unless we have come here after EI, exit */
       if(!(R->IFF&IFF_EI))
@@ -0,0 +1,252 @@
+/*
+ * Cycle-accurate handler profiler Implementation
+ *
+ * One PSRAM table holds the slots of all domains. Timing and accounting
+ * code runs from SRAM; the accounting of a sample is never inside a timed
+ * window, only the reads of the cycle counter and the call are, and those
+ * are measured once at init (minimum of back-to-back runs) and subtracted.
+ */
+#include "cycprof.h"
+
+#if CYCLE_PROFILING
+
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "psram_allocator.h"
+#include <string.h>
+#include <stdio.h>
+
+#define DEMCR               (*(volatile uint32_t *)0xE000EDFCu)
+#define DEMCR_TRCENA        (1u << 24)
+#define DWT_CTRL            (*(volatile uint32_t *)0xE0001000u)
+#define DWT_CTRL_CYCCNTENA  (1u << 0)
+#define DWT_CTRL_NOCYCCNT   (1u << 25)
+
+#define CALIBRATION_RUNS 64
+#define M68K_GROUPS 160
+
+typedef struct {
+    uint64_t sum;
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+} cycprof_slot_t;
+
+static const char *domain_names[CYCPROF_DOMAINS] = { "m68k", "z80asm", "z80c", "vdp" };
+static const uint16_t domain_slots[CYCPROF_DOMAINS] = {
+    CYCPROF_M68K_SLOTS, CYCPROF_Z80_SLOTS, CYCPROF_Z80_SLOTS, CYCPROF_VDP_KERNELS
+};
+
+#define CYCPROF_VDP_NAME(fn) #fn,
+static const char *vdp_names[CYCPROF_VDP_KERNELS] = { CYCPROF_VDP_KERNEL_LIST(CYCPROF_VDP_NAME) };
+#undef CYCPROF_VDP_NAME
+
+static cycprof_slot_t *tables[CYCPROF_DOMAINS];   // PSRAM
+static cycprof_slot_t *table_base;
+static uint32_t table_bytes;
+
+static uint32_t pair_overhead;   // CYCPROF_BEGIN/END around nothing
+static uint32_t mark_overhead;   // Two back-to-back cycprof_z80_mark() calls
+static uint32_t z80_open = CYCPROF_Z80_END;
+static uint32_t z80_t0;
+
+static uint32_t frames;
+static uint64_t start_us;
+
+static inline void __not_in_flash_func(slot_add)(cycprof_slot_t *slot, uint32_t cycles) {
+    if (slot->count == 0 || cycles < slot->min) slot->min = cycles;
+    if (cycles > slot->max) slot->max = cycles;
+    slot->sum += cycles;
+    slot->count++;
+}
+
+void __not_in_flash_func(cycprof_add)(uint32_t domain, uint32_t id, uint32_t cycles) {
+    if (table_base == NULL || id >= domain_slots[domain]) return;
+    cycles = cycles > pair_overhead ? cycles - pair_overhead : 0;
+    slot_add(&tables[domain][id], cycles);
+}
+
+void __not_in_flash_func(cycprof_z80_mark)(uint32_t opcode) {
+    uint32_t now = cycprof_now();
+    if (z80_open < CYCPROF_Z80_SLOTS && table_base != NULL) {
+        uint32_t cycles = now - z80_t0;
+        cycles = cycles > mark_overhead ? cycles - mark_overhead : 0;
+        slot_add(&tables[CYCPROF_Z80_ASM][z80_open], cycles);
+    }
+    z80_open = opcode;
+    z80_t0 = cycprof_now();
+}
+
+static void tables_reset(void) {
+    memset(table_base, 0, table_bytes);
+    z80_open = CYCPROF_Z80_END;
+    frames = 0;
+    start_us = time_us_64();
+}
+
+static void calibrate(void) {
+    pair_overhead = UINT32_MAX;
+    for (int i = 0; i < CALIBRATION_RUNS; i++) {
+        CYCPROF_BEGIN();
+        uint32_t cycles = cycprof_now() - cycprof_t0_;
+        if (cycles < pair_overhead) pair_overhead = cycles;
+    }
+
+    // Slot 0 of the z80asm table sees only empty intervals here
+    mark_overhead = 0;
+    for (int i = 0; i < CALIBRATION_RUNS; i++) {
+        cycprof_z80_mark(0);
+    }
+    cycprof_z80_mark(CYCPROF_Z80_END);
+    mark_overhead = tables[CYCPROF_Z80_ASM][0].min;
+}
+
+static const char *slot_name(uint32_t domain, uint32_t id, char *buf, size_t size) {
+    const char *name = NULL;
+    switch (domain) {
+        case CYCPROF_M68K: name = m68k_handler_name(id); break;
+        case CYCPROF_VDP:  name = vdp_names[id]; break;
+        default:
+            snprintf(buf, size, "op %02lX", (unsigned long)id);
+            return buf;
+    }
+    if (name == NULL) {
+        snprintf(buf, size, "#%lu", (unsigned long)id);
+        return buf;
+    }
+    return name;
+}
+
+// Next entry after `prev` in the order of total cycles (ties by index),
+// -1 when done. The tables are small enough to rescan for a report.
+static int next_top(const cycprof_slot_t *t, uint32_t n, int prev) {
+    int best = -1;
+    for (uint32_t i = 0; i < n; i++) {
+        if (t[i].count == 0) continue;
+        if (prev >= 0 && (t[i].sum > t[prev].sum ||
+                          (t[i].sum == t[prev].sum && (int)i <= prev))) continue;
+        if (best < 0 || t[i].sum > t[best].sum) best = (int)i;
+    }
+    return best;
+}
+
+static void print_row(const char *name, uint32_t count, uint64_t sum,
+                      uint32_t min, uint32_t max, uint64_t wall) {
+    printf("  %-34s %9lu  avg %6lu  min %6lu  max %7lu  %5.2f%%\n", name,
+           (unsigned long)count, (unsigned long)(sum / count),
+           (unsigned long)min, (unsigned long)max, 100.0 * (double)sum / (double)wall);
+}
+
+static void report_domain(uint32_t domain, uint64_t wall) {
+    cycprof_slot_t *table = tables[domain];
+    uint32_t slots = domain_slots[domain];
+    uint64_t total = 0;
+    uint32_t calls = 0;
+    for (uint32_t i = 0; i < slots; i++) {
+        total += table[i].sum;
+        calls += table[i].count;
+    }
+    printf("--- %s: %lu calls, %llu cycles (%.1f%%) ---\n", domain_names[domain],
+           (unsigned long)calls, (unsigned long long)total, 100.0 * (double)total / (double)wall);
+    if (calls == 0) return;
+
+    int best = -1;
+    for (int n = 0; n < CYCPROF_REPORT_TOP; n++) {
+        best = next_top(table, slots, best);
+        if (best < 0) break;
+        char buf[16];
+        print_row(slot_name(domain, best, buf, sizeof(buf)), table[best].count,
+                  table[best].sum, table[best].min, table[best].max, wall);
+    }
+}
+
+// M68K totals per mnemonic: m68k_op_<mnemonic>_<size>_<modes>
+static void report_m68k_groups(uint64_t wall) {
+    static const char *group_name[M68K_GROUPS];
+    static uint8_t group_len[M68K_GROUPS];
+    static cycprof_slot_t group[M68K_GROUPS];
+    int groups = 0;
+
+    memset(group, 0, sizeof(group));
+    for (uint32_t i = 0; i < CYCPROF_M68K_SLOTS; i++) {
+        cycprof_slot_t *s = &tables[CYCPROF_M68K][i];
+        const char *name = m68k_handler_name(i);
+        if (s->count == 0 || name == NULL) continue;
+        if (strncmp(name, "m68k_op_", 8) == 0) name += 8;
+        size_t len = strcspn(name, "_");
+
+        int g;
+        for (g = 0; g < groups; g++) {
+            if (group_len[g] == len && strncmp(group_name[g], name, len) == 0) break;
+        }
+        if (g == groups) {
+            if (groups == M68K_GROUPS) continue;
+            group_name[g] = name;
+            group_len[g] = (uint8_t)len;
+            groups++;
+        }
+        if (group[g].count == 0 || s->min < group[g].min) group[g].min = s->min;
+        if (s->max > group[g].max) group[g].max = s->max;
+        group[g].sum += s->sum;
+        group[g].count += s->count;
+    }
+
+    printf("--- m68k by mnemonic ---\n");
+    int best = -1;
+    for (int n = 0; n < CYCPROF_REPORT_TOP; n++) {
+        best = next_top(group, groups, best);
+        if (best < 0) break;
+        char name[24];
+        snprintf(name, sizeof(name), "%.*s", group_len[best], group_name[best]);
+        print_row(name, group[best].count, group[best].sum, group[best].min, group[best].max, wall);
+    }
+}
+
+static void report(void) {
+    uint64_t wall = (time_us_64() - start_us) * (clock_get_hz(clk_sys) / 1000000);
+    if (wall == 0) return;
+    printf("=== Cycle profile: %lu frames, %llu cycles, overhead %lu/%lu cycles ===\n",
+           (unsigned long)frames, (unsigned long long)wall,
+           (unsigned long)pair_overhead, (unsigned long)mark_overhead);
+    for (uint32_t d = 0; d < CYCPROF_DOMAINS; d++) {
+        report_domain(d, wall);
+    }
+    report_m68k_groups(wall);
+}
+
+void cycprof_init(void) {
+    DEMCR |= DEMCR_TRCENA;
+    if (DWT_CTRL & DWT_CTRL_NOCYCCNT) {
+        printf("Cycle profile: no DWT cycle counter\n");
+        return;
+    }
+    DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+
+    uint32_t slots = 0;
+    for (uint32_t d = 0; d < CYCPROF_DOMAINS; d++) {
+        slots += domain_slots[d];
+    }
+    table_bytes = slots * sizeof(cycprof_slot_t);
+    table_base = (cycprof_slot_t *)psram_malloc(table_bytes);
+    if (table_base == NULL) {
+        printf("Cycle profile: no PSRAM for %lu bytes\n", (unsigned long)table_bytes);
+        return;
+    }
+    cycprof_slot_t *p = table_base;
+    for (uint32_t d = 0; d < CYCPROF_DOMAINS; d++) {
+        tables[d] = p;
+        p += domain_slots[d];
+    }
+
+    tables_reset();
+    calibrate();
+    tables_reset();
+}
+
+void cycprof_frame(void) {
+    if (table_base == NULL || ++frames < CYCPROF_REPORT_FRAMES) return;
+    report();
+    tables_reset();
+}
+
+#endif // CYCLE_PROFILING
@@ -0,0 +1,112 @@
+/*
+ * Cycle-accurate handler profiler
+ *
+ * Build with CYCLE_PROFILING=1 to time individual handlers with the
+ * Cortex-M33 DWT cycle counter:
+ *   m68k   - every dispatched M68K handler (needs M68K_COMPACT_DISPATCH)
+ *   z80asm - every opcode run by the z80_arm.S loop, from its fetch to
+ *            the next fetch
+ *   z80c   - every opcode run by ExecZ80() (the z80_arm.S fallback)
+ *   vdp    - every call of a draw_*_asm kernel
+ * Count, min, avg and max cycles per handler accumulate in PSRAM tables.
+ * The cost of the measurement itself is calibrated at init and subtracted
+ * from each sample. Every CYCPROF_REPORT_FRAMES frames the hottest
+ * handlers of each domain and the M68K totals per mnemonic are printed.
+ */
+#ifndef CYCPROF_H
+#define CYCPROF_H
+
+#include <stdint.h>
+
+#ifndef CYCLE_PROFILING
+#define CYCLE_PROFILING 0
+#endif
+
+// Frames between two reports
+#ifndef CYCPROF_REPORT_FRAMES
+#define CYCPROF_REPORT_FRAMES 600
+#endif
+
+// Handlers listed per domain
+#ifndef CYCPROF_REPORT_TOP
+#define CYCPROF_REPORT_TOP 20
+#endif
+
+// VDP kernels, in report order
+#define CYCPROF_VDP_KERNEL_LIST(X) \
+    X(draw_pattern_nofliph_planeB_asm) \
+    X(draw_pattern_fliph_planeB_asm) \
+    X(draw_pattern_nofliph_planeA_asm) \
+    X(draw_pattern_fliph_planeA_asm) \
+    X(draw_pattern_nofliph_sprite_asm) \
+    X(draw_pattern_fliph_sprite_asm) \
+    X(draw_pattern_nofliph_sprite_over_asm) \
+    X(draw_pattern_fliph_sprite_over_asm) \
+    X(draw_line_b_simple_asm) \
+    X(draw_line_a_simple_asm) \
+    X(draw_line_b_cscroll_asm) \
+    X(draw_line_a_cscroll_asm) \
+    X(draw_window_line_asm)
+
+#define CYCPROF_VDP_ID(fn) CYCPROF_VDP_##fn,
+enum { CYCPROF_VDP_KERNEL_LIST(CYCPROF_VDP_ID) CYCPROF_VDP_KERNELS };
+#undef CYCPROF_VDP_ID
+
+enum {
+    CYCPROF_M68K = 0,
+    CYCPROF_Z80_ASM,
+    CYCPROF_Z80_C,
+    CYCPROF_VDP,
+    CYCPROF_DOMAINS
+};
+
+#define CYCPROF_M68K_SLOTS 2048   // Compact dispatch handler index
+#define CYCPROF_Z80_SLOTS  256    // Opcode (first byte for prefixed ones)
+#define CYCPROF_Z80_END    0x100  // cycprof_z80_mark(): close without opening
+
+#if CYCLE_PROFILING
+
+#define CYCPROF_DWT_CYCCNT (*(volatile uint32_t *)0xE0001004u)
+
+static inline uint32_t cycprof_now(void) {
+    return CYCPROF_DWT_CYCCNT;
+}
+
+/**
+ * Enable the cycle counter, allocate the tables and calibrate
+ */
+void cycprof_init(void);
+
+/**
+ * Add one timed call of handler `id` in `domain`
+ */
+void cycprof_add(uint32_t domain, uint32_t id, uint32_t cycles);
+
+/**
+ * z80_arm.S: an opcode was fetched, closes the previous one
+ */
+void cycprof_z80_mark(uint32_t opcode);
+
+/**
+ * A frame was emulated, reports and restarts every CYCPROF_REPORT_FRAMES
+ */
+void cycprof_frame(void);
+
+/**
+ * Handler name for a compact dispatch index (M68K core)
+ */
+const char *m68k_handler_name(unsigned int index);
+
+#define CYCPROF_BEGIN() uint32_t cycprof_t0_ = cycprof_now()
+#define CYCPROF_END(domain, id) cycprof_add(domain, id, cycprof_now() - cycprof_t0_)
+
+#else
+
+#define cycprof_init()
+#define cycprof_frame()
+#define CYCPROF_BEGIN() do {} while (0)
+#define CYCPROF_END(domain, id) do {} while (0)
+
+#endif // CYCLE_PROFILING
+
+#endif // CYCPROF_H
@@ -0,0 +1,136 @@
+/*
+ * Host input service Implementation
+ *
+ * Core 1 owns the USB host stack and the PS/2 decoder while the service
+ * runs. TinyUSB's interrupt handler stays on core 0 but only queues events
+ * (the queue is protected by a spin lock), tuh_task() drains them here.
+ *
+ * The input word and the polling counters are published together through
+ * a sequence lock: core 1 makes the sequence odd, writes, makes it even
+ * again, and core 0 retries if it saw an odd or changed sequence. A read
+ * is a handful of loads and never blocks core 0.
+ */
+#include "input_poll.h"
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "ps2kbd/ps2kbd_wrapper.h"
+
+#ifdef USB_HID_ENABLED
+#include "usbhid/usbhid.h"
+#endif
+
+// Ownership hand-off: core 0 clears `running`, then waits for `busy`
+static volatile bool running = false;
+static volatile bool busy = false;
+
+// Published by core 1 under the sequence lock
+static volatile uint32_t seq = 0;
+static volatile uint32_t published_word = 0;
+static volatile uint32_t total_polls = 0;
+static volatile uint32_t total_poll_us = 0;
+static volatile uint32_t max_poll_us = 0;
+static volatile bool max_reset = false;   // Core 0 asks core 1 to restart the max
+
+static uint32_t last_poll_us;      // Core 1
+static uint32_t stats_polls;       // Core 0: totals at the last report
+static uint32_t stats_poll_us;
+
+// Service the drivers and pack their state (caller owns the drivers)
+static uint32_t poll_drivers(void) {
+    ps2kbd_tick();
+    uint32_t word = ps2kbd_get_state();
+
+#ifdef USB_HID_ENABLED
+    usbhid_task();
+    word |= usbhid_get_kbd_state();
+    if (usbhid_gamepad_connected()) {
+        usbhid_gamepad_state_t gp;
+        usbhid_get_gamepad_state(&gp);
+        word |= INPUT_WORD_GP_CONNECTED;
+        word |= (uint32_t)(gp.buttons & 0xFF) << INPUT_WORD_GP_SHIFT;
+        word |= (uint32_t)(gp.dpad & 0x0F) << INPUT_WORD_DPAD_SHIFT;
+    }
+#endif
+
+    return word;
+}
+
+void input_poll_start(void) {
+    __dmb();
+    running = true;
+}
+
+void input_poll_stop(void) {
+    running = false;
+    __dmb();
+    while (busy) {
+        tight_loop_contents();
+    }
+    __dmb();
+}
+
+void input_poll_step(void) {
+    uint32_t now = time_us_32();
+    if (!running || now - last_poll_us < INPUT_POLL_INTERVAL_US) return;
+
+    busy = true;
+    __dmb();
+    if (!running) {
+        busy = false;
+        return;
+    }
+
+    last_poll_us = now;
+    uint32_t word = poll_drivers();
+    uint32_t took = time_us_32() - now;
+
+    seq++;
+    __dmb();
+    published_word = word;
+    total_polls++;
+    total_poll_us += took;
+    if (max_reset || took > max_poll_us) {
+        max_poll_us = took;
+        max_reset = false;
+    }
+    __dmb();
+    seq++;
+
+    __dmb();
+    busy = false;
+}
+
+uint32_t input_poll_read(void) {
+    if (!running) {
+        published_word = poll_drivers();
+        return published_word;
+    }
+
+    uint32_t start, word;
+    do {
+        start = seq;
+        __dmb();
+        word = published_word;
+        __dmb();
+    } while ((start & 1) || start != seq);
+    return word;
+}
+
+void input_poll_get_stats(input_poll_stats_t *out) {
+    uint32_t start, polls, poll_us, max_us;
+    do {
+        start = seq;
+        __dmb();
+        polls = total_polls;
+        poll_us = total_poll_us;
+        max_us = max_poll_us;
+        __dmb();
+    } while ((start & 1) || start != seq);
+
+    out->polls = polls - stats_polls;
+    out->poll_us = poll_us - stats_poll_us;
+    out->max_poll_us = max_us;
+    stats_polls = polls;
+    stats_poll_us = poll_us;
+    max_reset = true;
+}
@@ -0,0 +1,61 @@
+/*
+ * Host input service - USB HID and PS/2 keyboard polling on core 1
+ * While the game runs, core 1 services TinyUSB and drains the PS/2 PIO
+ * FIFO between audio frames and publishes the result as one packed input
+ * word. Core 0 only reads that word when it latches input for a frame.
+ * Menus stop the service and poll the drivers directly again.
+ */
+#ifndef INPUT_POLL_H
+#define INPUT_POLL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Minimum time between two polls on core 1
+#ifndef INPUT_POLL_INTERVAL_US
+#define INPUT_POLL_INTERVAL_US 1000
+#endif
+
+// Packed input word layout
+#define INPUT_WORD_KBD_MASK      0x0000FFFFu  // KBD_STATE_* bits, PS/2 and USB merged
+#define INPUT_WORD_GP_SHIFT      16           // USB gamepad buttons (usbhid_gamepad_state_t.buttons)
+#define INPUT_WORD_DPAD_SHIFT    24           // USB gamepad d-pad (usbhid_gamepad_state_t.dpad)
+#define INPUT_WORD_GP_CONNECTED  (1u << 28)   // USB gamepad present
+
+#define INPUT_WORD_KBD(w)   ((uint16_t)((w) & INPUT_WORD_KBD_MASK))
+#define INPUT_WORD_GP(w)    ((uint8_t)((w) >> INPUT_WORD_GP_SHIFT))
+#define INPUT_WORD_DPAD(w)  ((uint8_t)(((w) >> INPUT_WORD_DPAD_SHIFT) & 0x0F))
+
+typedef struct {
+    uint32_t polls;       // Polls done on core 1 since the last call
+    uint32_t poll_us;     // Time spent polling on core 1
+    uint32_t max_poll_us; // Longest single poll
+} input_poll_stats_t;
+
+/**
+ * Hand the USB and PS/2 drivers to core 1 (core 0, entering gameplay)
+ */
+void input_poll_start(void);
+
+/**
+ * Take the drivers back, waits for a poll in progress (core 0, before menus)
+ */
+void input_poll_stop(void);
+
+/**
+ * Poll the drivers if the service runs and the interval elapsed (core 1)
+ */
+void input_poll_step(void);
+
+/**
+ * Latest packed input word. Polls the drivers on the caller's core
+ * while the service is stopped.
+ */
+uint32_t input_poll_read(void);
+
+/**
+ * Core 1 polling cost since the previous call (core 0)
+ */
+void input_poll_get_stats(input_poll_stats_t *out);
+
+#endif // INPUT_POLL_H
@@ -19,10 +19,14 @@ __license__ = "GPLv3"
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
+#include "m68k.h"
 #include "gwenesis_io.h"
 #include "gwenesis_savestate.h"
+#include "latency.h"
 
 unsigned char button_state[3]= {0xff,0xff,0xff};
+/* 6-button extra keys, active low : ? ? ? ? Mode X Y Z */
+unsigned char button_state_ext[3]= {0xff,0xff,0xff};
 
 /* Button mapping 
     7 6 5 4 3 2 1 0
@@ -30,6 +34,32 @@ Start A B C R L D U
 */
 static unsigned char gwenesis_io_pad_state[3] = {0x33,0x33,0x33};
 
+/* 6-button pad protocol
+ * The pad counts TH high->low transitions. After the 3rd one it answers
+ * with the ID nibble (TH low) and X Y Z Mode (TH high), after the 4th one
+ * with 1111 in the low nibble (TH low). The counter clears when TH did not
+ * move for about 1.5 ms, measured in 68K master clock cycles so the result
+ * does not depend on how fast the host runs.
+ *
+ * phase = counter * 2 + TH selects the precomputed response, so a read is
+ * a table lookup and the counter only moves on TH writes. */
+#define PAD6_TIMEOUT 80000 /* ~1.5 ms of master clock */
+#define PAD6_COUNT_MAX 5   /* counter saturates: normal 3-button answers */
+#define PAD6_PHASE_ID 6    /* first phase with a 6-button specific answer */
+#define PAD6_PHASES ((PAD6_COUNT_MAX + 1) * 2)
+
+/* Pad data port response per phase, rebuilt from button_state and
+ * button_state_ext when host input is latched (once per frame) */
+static unsigned char gwenesis_io_pad_response[3][PAD6_PHASES];
+static unsigned char gwenesis_io_pad_phase[3];
+static unsigned char gwenesis_io_th_count[3];
+/* master cycle of the last TH transition (rebased every frame) */
+static int gwenesis_io_th_edge[3] = {-PAD6_TIMEOUT - 1, -PAD6_TIMEOUT - 1, -PAD6_TIMEOUT - 1};
+/* controller plugged in each port: 6-button pads on 1 & 2 */
+static unsigned char gwenesis_io_pad6[3] = {1, 1, 0};
+/* the game read the X Y Z Mode cycle since reset */
+static unsigned char gwenesis_io_pad6_used[3];
+
 #define GWENESIS_IO_VERSION 0x81 /* oversea NTSC model version 81 */
 /*
 $A10003	:	MODE 	VMOD 	DISK 	RSV 	VER3 	VER2 	VER1 	VER0
@@ -143,34 +173,112 @@ void gwenesis_io_pad_press_button(int pad, int button)
     button_state[pad] &= ~(1 << button);
 }
 
+static void gwenesis_io_pad_th_changed(int pad)
+{
+    unsigned int th = (gwenesis_io_pad_state[pad] >> 6) & 1;
+
+    if (gwenesis_io_pad6[pad])
+    {
+        int now = m68k_cycles_master();
+
+        if (now - gwenesis_io_th_edge[pad] > PAD6_TIMEOUT)
+            gwenesis_io_th_count[pad] = 0;
+        gwenesis_io_th_edge[pad] = now;
+
+        if (th == 0 && gwenesis_io_th_count[pad] < PAD6_COUNT_MAX)
+            gwenesis_io_th_count[pad]++;
+    }
+    gwenesis_io_pad_phase[pad] = gwenesis_io_th_count[pad] * 2 + th;
+}
+
 static inline void gwenesis_io_pad_write(int pad, int value)
 {
     unsigned char mask = io_reg[pad + 4];
+    unsigned char old = gwenesis_io_pad_state[pad];
 
      gwenesis_io_pad_state[pad] &= ~mask;
     gwenesis_io_pad_state[pad] |= value & mask;
- 
+
+    if ((old ^ gwenesis_io_pad_state[pad]) & 0x40)
+        gwenesis_io_pad_th_changed(pad);
 }
 
-static inline  unsigned char gwenesis_io_pad_read(int pad)
+static void gwenesis_io_update_response(void)
 {
-    unsigned char value;
- 
-    /* get host button */
-    gwenesis_io_get_buttons();
+    for (int pad = 0; pad < 3; pad++)
+    {
+        unsigned char bs = button_state[pad];
+        /* TH = 1 : ? 1 C B R L D U */
+        unsigned char th1 = 0x40 | (bs & 0x3f);
+        /* TH = 0 : ? 0 S A 0 0 D U */
+        unsigned char th0 = (bs & 3) | ((bs >> 2) & 0x30);
 
-    value = gwenesis_io_pad_state[pad] & 0x40;
-    value |= 0x3f;
+        for (int phase = 0; phase < PAD6_PHASES; phase += 2)
+        {
+            gwenesis_io_pad_response[pad][phase] = th0;
+            gwenesis_io_pad_response[pad][phase + 1] = th1;
+        }
 
-    if (value & 0x40)
+        /* 3rd cycle, TH = 0 : ? 0 S A 0 0 0 0 (6-button ID) */
+        gwenesis_io_pad_response[pad][6] = (bs >> 2) & 0x30;
+        /* 3rd cycle, TH = 1 : ? 1 C B M X Y Z */
+        gwenesis_io_pad_response[pad][7] = 0x40 | (bs & 0x30) | (button_state_ext[pad] & 0x0f);
+        /* 4th cycle, TH = 0 : ? 0 S A 1 1 1 1 */
+        gwenesis_io_pad_response[pad][8] = ((bs >> 2) & 0x30) | 0x0f;
+    }
+}
+
+void gwenesis_io_set_pad6(int pad, int enable)
+{
+    gwenesis_io_pad6[pad] = enable ? 1 : 0;
+    gwenesis_io_th_count[pad] = 0;
+    gwenesis_io_pad6_used[pad] = 0;
+    gwenesis_io_pad_phase[pad] = (gwenesis_io_pad_state[pad] >> 6) & 1;
+}
+
+int gwenesis_io_pad6_used_by_game(int pad)
+{
+    return gwenesis_io_pad6_used[pad];
+}
+
+void gwenesis_io_frame_end(int frame_cycles)
+{
+    for (int pad = 0; pad < 3; pad++)
     {
-        value &= (button_state[pad] & 0x3f);
+        int edge = gwenesis_io_th_edge[pad] - frame_cycles;
+        /* keep an old edge expired without letting it wrap */
+        if (edge < -PAD6_TIMEOUT)
+            edge = -PAD6_TIMEOUT - 1;
+        gwenesis_io_th_edge[pad] = edge;
     }
-    else
+}
+
+void gwenesis_io_latch_buttons(void)
+{
+    /* get host button */
+    gwenesis_io_get_buttons();
+    gwenesis_io_update_response();
+}
+
+static inline  unsigned char gwenesis_io_pad_read(int pad)
+{
+    unsigned int phase = gwenesis_io_pad_phase[pad];
+
+    /* counter may have expired while TH stayed put */
+    if (phase >= PAD6_PHASE_ID)
     {
-        value &= ((button_state[pad] & 3) | ((button_state[pad] >> 2) & 0x30));
+        if (m68k_cycles_master() - gwenesis_io_th_edge[pad] > PAD6_TIMEOUT)
+        {
+            gwenesis_io_th_count[pad] = 0;
+            phase &= 1;
+            gwenesis_io_pad_phase[pad] = phase;
+        }
+        else if (phase == 7)
+        {
+            gwenesis_io_pad6_used[pad] = 1;
+        }
     }
-    return value;
+    return gwenesis_io_pad_response[pad][phase];
 }
 
 void gwenesis_io_write_ctrl(unsigned int address, unsigned int value)
@@ -209,6 +317,7 @@ unsigned int gwenesis_io_read_ctrl(unsigned int address)
         unsigned char value;
         value = io_reg[address] & mask;
         value |= gwenesis_io_pad_read(address - 1) & ~mask;
+        LATENCY_PAD_READ();
 
         return value;
     }
@@ -229,6 +338,9 @@ void gwenesis_io_save_state() {
     saveGwenesisStateSetBuffer(state, "button_state", button_state, sizeof(button_state));
     saveGwenesisStateSetBuffer(state, "gwenesis_io_pad_state", gwenesis_io_pad_state, sizeof(gwenesis_io_pad_state));
     saveGwenesisStateSetBuffer(state, "io_reg", io_reg, sizeof(io_reg));
+    saveGwenesisStateSetBuffer(state, "button_state_ext", button_state_ext, sizeof(button_state_ext));
+    saveGwenesisStateSetBuffer(state, "th_count", gwenesis_io_th_count, sizeof(gwenesis_io_th_count));
+    saveGwenesisStateSetBuffer(state, "th_edge", gwenesis_io_th_edge, sizeof(gwenesis_io_th_edge));
 }
 
 void gwenesis_io_load_state() {
@@ -236,4 +348,18 @@ void gwenesis_io_load_state() {
     saveGwenesisStateGetBuffer(state, "button_state", button_state, sizeof(button_state));
     saveGwenesisStateGetBuffer(state, "gwenesis_io_pad_state", gwenesis_io_pad_state, sizeof(gwenesis_io_pad_state));
     saveGwenesisStateGetBuffer(state, "io_reg", io_reg, sizeof(io_reg));
+    /* states from before the 6-button pad: counters idle */
+    if (!saveGwenesisStateGetBuffer(state, "button_state_ext", button_state_ext, sizeof(button_state_ext)))
+        memset(button_state_ext, 0xff, sizeof(button_state_ext));
+    if (!saveGwenesisStateGetBuffer(state, "th_count", gwenesis_io_th_count, sizeof(gwenesis_io_th_count)))
+        memset(gwenesis_io_th_count, 0, sizeof(gwenesis_io_th_count));
+    if (!saveGwenesisStateGetBuffer(state, "th_edge", gwenesis_io_th_edge, sizeof(gwenesis_io_th_edge)))
+        gwenesis_io_frame_end(2 * PAD6_TIMEOUT);
+    for (int pad = 0; pad < 3; pad++)
+    {
+        if (!gwenesis_io_pad6[pad] || gwenesis_io_th_count[pad] > PAD6_COUNT_MAX)
+            gwenesis_io_th_count[pad] = 0;
+        gwenesis_io_pad_phase[pad] = gwenesis_io_th_count[pad] * 2 + ((gwenesis_io_pad_state[pad] >> 6) & 1);
+    }
+    gwenesis_io_update_response();
 }
@@ -28,7 +28,17 @@ void gwenesis_io_write_ctrl(unsigned int address, unsigned int value);
 unsigned int gwenesis_io_read_ctrl(unsigned int address);
 
 void gwenesis_io_set_reg(unsigned int reg, unsigned int value);
+/* Host hook: fill button_state from the real controllers */
 void gwenesis_io_get_buttons();
+/* Poll the host once and precompute the pad port responses */
+void gwenesis_io_latch_buttons(void);
+
+/* 6-button pad (default on ports 1 & 2) or 3-button pad */
+void gwenesis_io_set_pad6(int pad, int enable);
+/* Nonzero once the game has read X Y Z Mode from the pad */
+int gwenesis_io_pad6_used_by_game(int pad);
+/* Rebase the TH timeout on the next frame (after m68k.cycles -= frame_cycles) */
+void gwenesis_io_frame_end(int frame_cycles);
 
 void gwenesis_io_save_state();
 void gwenesis_io_load_state();
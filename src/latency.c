@@ -0,0 +1,190 @@
+/*
+ * Input-to-photon latency probe Implementation
+ *
+ * One press is tracked at a time. Core 0 records the press, the first
+ * pad port read and the first changed frame; the HDMI vsync interrupt
+ * stamps the start of the next scanout, which is the first time the
+ * whole changed frame reaches the display. Completed samples are folded
+ * into the statistics on core 0 at the next rendered frame.
+ */
+#include "latency.h"
+
+#if INPUT_LATENCY_PROBE
+
+#include "HDMI.h"
+#include "pico/stdlib.h"
+#include <string.h>
+#include <stdio.h>
+
+#define STAGES 3            // press->read, read->change, change->scanout
+#define HIST_BIN_US 2000
+#define HIST_BINS 64        // Last bin collects everything >= 126 ms
+
+typedef struct {
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t sum_us;
+} stage_stats_t;
+
+static const char *stage_names[STAGES] = { "press->read", "read->change", "change->scanout" };
+
+volatile uint8_t latency_state = LATENCY_IDLE;
+
+static uint32_t t_press;
+static uint32_t t_read;
+static uint32_t t_change;
+static volatile uint32_t t_scanout;
+
+static uint32_t prev_pad;
+static uint32_t last_hash;
+
+static stage_stats_t stages[STAGES];
+static stage_stats_t total;
+static uint16_t histogram[HIST_BINS];
+static uint32_t samples;
+static uint32_t dropped;
+
+// HDMI vsync (interrupt): the changed frame starts scanning out now
+static void __not_in_flash_func(latency_vsync)(void) {
+    if (latency_state == LATENCY_CHANGED && t_scanout == 0) {
+        t_scanout = time_us_32();
+    }
+}
+
+static void stats_reset(void) {
+    for (int i = 0; i < STAGES; i++) {
+        stages[i].min_us = UINT32_MAX;
+        stages[i].max_us = 0;
+        stages[i].sum_us = 0;
+    }
+    total.min_us = UINT32_MAX;
+    total.max_us = 0;
+    total.sum_us = 0;
+    memset(histogram, 0, sizeof(histogram));
+    samples = 0;
+    dropped = 0;
+}
+
+static void stats_add(stage_stats_t *s, uint32_t us) {
+    if (us < s->min_us) s->min_us = us;
+    if (us > s->max_us) s->max_us = us;
+    s->sum_us += us;
+}
+
+// Upper edge of the bin holding the given fraction of the samples
+static uint32_t percentile_us(uint32_t permille) {
+    uint32_t wanted = (samples * permille + 999) / 1000;
+    uint32_t seen = 0;
+    for (int i = 0; i < HIST_BINS; i++) {
+        seen += histogram[i];
+        if (seen >= wanted) return (uint32_t)(i + 1) * HIST_BIN_US;
+    }
+    return HIST_BINS * HIST_BIN_US;
+}
+
+static void report(void) {
+    printf("=== Input latency: %lu presses (%lu dropped) ===\n",
+           (unsigned long)samples, (unsigned long)dropped);
+    for (int i = 0; i < STAGES; i++) {
+        printf("  %-16s min %6lu  avg %6lu  max %6lu us\n", stage_names[i],
+               (unsigned long)stages[i].min_us,
+               (unsigned long)(stages[i].sum_us / samples),
+               (unsigned long)stages[i].max_us);
+    }
+    printf("  %-16s min %6lu  avg %6lu  max %6lu us\n", "press->scanout",
+           (unsigned long)total.min_us,
+           (unsigned long)(total.sum_us / samples),
+           (unsigned long)total.max_us);
+    printf("  p50 <%lu us  p90 <%lu us  p99 <%lu us\n",
+           (unsigned long)percentile_us(500),
+           (unsigned long)percentile_us(900),
+           (unsigned long)percentile_us(990));
+    for (int i = 0; i < HIST_BINS; i++) {
+        if (histogram[i] == 0) continue;
+        printf("  %3d-%3d ms: %u\n", i * HIST_BIN_US / 1000,
+               (i + 1) * HIST_BIN_US / 1000, histogram[i]);
+    }
+}
+
+static void sample_complete(void) {
+    uint32_t delays[STAGES] = {
+        t_read - t_press,
+        t_change - t_read,
+        t_scanout - t_change
+    };
+    uint32_t sum = t_scanout - t_press;
+
+    for (int i = 0; i < STAGES; i++) {
+        stats_add(&stages[i], delays[i]);
+    }
+    stats_add(&total, sum);
+
+    uint32_t bin = sum / HIST_BIN_US;
+    if (bin >= HIST_BINS) bin = HIST_BINS - 1;
+    histogram[bin]++;
+
+    if (++samples >= LATENCY_REPORT_SAMPLES) {
+        report();
+        stats_reset();
+    }
+}
+
+static uint32_t screen_hash(const uint8_t *screen, uint32_t size) {
+    const uint32_t *words = (const uint32_t *)screen;
+    uint32_t hash = 2166136261u;
+    for (uint32_t i = 0; i < size / 4; i++) {
+        hash = (hash ^ words[i]) * 16777619u;
+    }
+    return hash;
+}
+
+void latency_init(void) {
+    stats_reset();
+    latency_state = LATENCY_IDLE;
+    graphics_set_vsync_callback(latency_vsync);
+}
+
+void latency_input_sample(uint32_t pad_state) {
+    uint32_t pressed = pad_state & ~prev_pad;
+    prev_pad = pad_state;
+
+    if (latency_state != LATENCY_IDLE || pressed == 0) return;
+    t_press = time_us_32();
+    t_scanout = 0;
+    latency_state = LATENCY_PRESSED;
+}
+
+void latency_pad_read(void) {
+    t_read = time_us_32();
+    latency_state = LATENCY_READ;
+}
+
+void latency_frame_rendered(const uint8_t *screen, uint32_t size) {
+    uint32_t now = time_us_32();
+    uint32_t hash = screen_hash(screen, size);
+    bool changed = (hash != last_hash);
+    last_hash = hash;
+
+    switch (latency_state) {
+        case LATENCY_PRESSED:
+        case LATENCY_READ:
+            if (latency_state == LATENCY_READ && changed) {
+                t_change = now;
+                latency_state = LATENCY_CHANGED;
+            } else if (now - t_press > LATENCY_TIMEOUT_US) {
+                dropped++;
+                latency_state = LATENCY_IDLE;
+            }
+            break;
+        case LATENCY_CHANGED:
+            if (t_scanout != 0) {
+                sample_complete();
+                latency_state = LATENCY_IDLE;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+#endif // INPUT_LATENCY_PROBE
@@ -0,0 +1,79 @@
+/*
+ * Input-to-photon latency probe
+ *
+ * Build with INPUT_LATENCY_PROBE=1 to time each gamepad press through
+ * the emulator:
+ *   press   - nespad_read() first reports the new button
+ *   read    - the emulated game first reads the pad port afterwards
+ *   change  - a rendered frame differs from the previous one (SCREEN hash)
+ *   scanout - the HDMI driver starts scanning out that frame
+ * A summary with the distribution is printed every
+ * LATENCY_REPORT_SAMPLES presses. Measure on a screen that stays still
+ * until the button acts (pause menu, title screen) so the hash only
+ * changes in response to the press.
+ */
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef INPUT_LATENCY_PROBE
+#define INPUT_LATENCY_PROBE 0
+#endif
+
+// Presses per printed report
+#ifndef LATENCY_REPORT_SAMPLES
+#define LATENCY_REPORT_SAMPLES 32
+#endif
+
+// A press that changes nothing on screen within this time is dropped
+#ifndef LATENCY_TIMEOUT_US
+#define LATENCY_TIMEOUT_US 500000
+#endif
+
+#if INPUT_LATENCY_PROBE
+
+enum {
+    LATENCY_IDLE = 0,
+    LATENCY_PRESSED,    // Waiting for the game to read the pad
+    LATENCY_READ,       // Waiting for the screen to change
+    LATENCY_CHANGED     // Waiting for scanout
+};
+
+extern volatile uint8_t latency_state;
+
+/**
+ * Hook the HDMI vsync and reset the statistics
+ */
+void latency_init(void);
+
+/**
+ * Host pad state right after nespad_read() (core 0)
+ */
+void latency_input_sample(uint32_t pad_state);
+
+/**
+ * Emulated pad port read (68K bus)
+ */
+void latency_pad_read(void);
+
+/**
+ * A frame was rendered into the screen buffer (core 0)
+ */
+void latency_frame_rendered(const uint8_t *screen, uint32_t size);
+
+#define LATENCY_PAD_READ() do { \
+    if (latency_state == LATENCY_PRESSED) latency_pad_read(); \
+} while (0)
+
+#else
+
+#define latency_init()
+#define latency_input_sample(pad_state)
+#define latency_frame_rendered(screen, size)
+#define LATENCY_PAD_READ() do {} while (0)
+
+#endif // INPUT_LATENCY_PROBE
+
+#endif // LATENCY_H
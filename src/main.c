@@ -8,6 +8,7 @@
 #include "hardware/vreg.h"
 #include "hardware/clocks.h"
 #include "hardware/structs/qmi.h"
+#include "hardware/structs/xip_ctrl.h"
 #include "hardware/watchdog.h"
 #include "hardware/sync.h"  // For memory barriers
 #include "hardware/dma.h"   // For DMA reset at startup
@@ -20,12 +21,15 @@
 #include "HDMI.h"
 #include "psram_init.h"
 #include "psram_allocator.h"
+#include "psram_stream.h"
 #include "ff.h"
 
 // Gwenesis includes
 #include "bus/gwenesis_bus.h"
+#include "bus/gwenesis_sram.h"
 #include "io/gwenesis_io.h"
 #include "vdp/gwenesis_vdp.h"
+#include "savestate/gwenesis_savestate.h"
 
 // Enable M68K opcode profiling (must be defined before m68k.h)
 #define M68K_OPCODE_PROFILING 1
@@ -56,6 +60,20 @@
 // Settings menu
 #include "settings.h"
 
+// Quick-save slots
+#include "quicksave.h"
+#include "perf_osd.h"
+#include "bench.h"
+#include "rewind.h"
+#include "runahead.h"
+#include "cartsave.h"
+#include "latency.h"
+#include "pcsample.h"
+#include "cycprof.h"
+#include "input_poll.h"
+#include "psram_tune.h"
+#include "z80_core1.h"
+
 //=============================================================================
 // Profiling
 //=============================================================================
@@ -84,6 +102,12 @@
 #define LINE_INTERLACE 0
 #endif
 
+// Host input is latched into the pad port tables once per frame.
+// For latency-critical titles set -DINPUT_LATCH_EVERY_LINES=N to also re-latch every N scanlines.
+#ifndef INPUT_LATCH_EVERY_LINES
+#define INPUT_LATCH_EVERY_LINES 0
+#endif
+
 // Constant frameskip pattern:
 // - Pattern length is in frames
 // - Bit i (LSB=frame 0) indicates whether to render that frame (1) or skip (0)
@@ -122,6 +146,15 @@ void set_frameskip_level(uint8_t level) {
     frameskip_pattern_mask = frameskip_patterns[level][1];
 }
 
+// Runtime Z80 slice length in scanlines (set from g_settings.z80_slice_lines)
+static uint32_t z80_slice_lines = Z80_SLICE_LINES;
+
+// Set Z80 slice length at runtime
+void set_z80_slice_lines(uint8_t lines) {
+    if (lines < 1 || lines > Z80_SLICE_LINES_MAX) lines = Z80_SLICE_LINES;  // Clamp to valid range
+    z80_slice_lines = lines;
+}
+
 #if FRAMESKIP_LEVEL == 0
   #define FRAMESKIP_PATTERN_LEN 1u
   #define FRAMESKIP_PATTERN_MASK 0x01u  // render every frame
@@ -185,6 +218,8 @@ typedef struct {
     uint64_t audio_wait_time;
     uint64_t frame_time;
     uint64_t idle_time;
+    uint64_t rewind_time;
+    uint64_t runahead_time;  // Whole run-ahead, emulation included in the lines above
     uint32_t frame_count;
     uint64_t min_frame_time;
     uint64_t max_frame_time;
@@ -217,9 +252,14 @@ static void print_profiling_stats(void) {
     if (profile_stats.frame_count == 0) return;
     
     uint64_t total = profile_stats.frame_time;
+    runahead_stats_t ra;
+    runahead_get_stats(&ra);
+    uint64_t runahead_sync_time = ra.snapshot_us + ra.restore_us;
+    
     uint64_t tracked = profile_stats.m68k_time + profile_stats.z80_time + 
                        profile_stats.vdp_time + profile_stats.sound_time + 
-                       profile_stats.audio_wait_time + profile_stats.idle_time;
+                       profile_stats.audio_wait_time + profile_stats.idle_time +
+                       profile_stats.rewind_time + runahead_sync_time;
     uint64_t other = (total > tracked) ? (total - tracked) : 0;
     
     LOG("\n=== Profiling Stats (avg per frame over %u frames) ===\n", profile_stats.frame_count);
@@ -257,6 +297,93 @@ static void print_profiling_stats(void) {
     LOG("Audio wait:      %6lu us (%3d%%)\n", 
         (unsigned long)(profile_stats.audio_wait_time / profile_stats.frame_count),
         (int)((profile_stats.audio_wait_time * 100) / total));
+    if (rewind_enabled()) {
+        rewind_stats_t rw;
+        rewind_get_stats(&rw);
+        LOG("Rewind capture:  %6lu us (%3d%%)\n",
+            (unsigned long)(profile_stats.rewind_time / profile_stats.frame_count),
+            (int)((profile_stats.rewind_time * 100) / total));
+        if (rw.captures) {
+            LOG("  per snapshot:  %6lu us (max=%lu), %lu B delta, depth %d (%d frames)\n",
+                (unsigned long)(rw.capture_us / rw.captures),
+                (unsigned long)rw.max_capture_us,
+                (unsigned long)(rw.delta_bytes / rw.captures),
+                rw.depth, rw.depth * REWIND_INTERVAL);
+        }
+    }
+    if (ra.snapshots) {
+        LOG("Run-ahead:       %6lu us (%3d%%) total, %u frame(s)\n",
+            (unsigned long)(profile_stats.runahead_time / profile_stats.frame_count),
+            (int)((profile_stats.runahead_time * 100) / total), g_settings.runahead);
+        LOG("  save/restore:  %6lu us (%3d%%), pages %lu/%lu per snapshot\n",
+            (unsigned long)(runahead_sync_time / profile_stats.frame_count),
+            (int)((runahead_sync_time * 100) / total),
+            (unsigned long)(ra.pages_saved / ra.snapshots),
+            (unsigned long)(ra.pages_restored / ra.snapshots));
+    }
+    input_poll_stats_t in;
+    input_poll_get_stats(&in);
+    if (in.polls) {
+        LOG("Input (core 1):  %6lu us/frame, %lu polls, max %lu us\n",
+            (unsigned long)(in.poll_us / profile_stats.frame_count),
+            (unsigned long)in.polls, (unsigned long)in.max_poll_us);
+    }
+    m68k_fetch_stats_t fetch;
+    m68k_fetch_get_stats(&fetch);
+    if (fetch.fetches) {
+        LOG("M68K fetch:      %3lu.%lu%% from SRAM window, %lu page switches, %lu fills/frame\n",
+            (unsigned long)((uint64_t)(fetch.fetches - fetch.outside) * 100 / fetch.fetches),
+            (unsigned long)((uint64_t)(fetch.fetches - fetch.outside) * 1000 / fetch.fetches % 10),
+            (unsigned long)(fetch.switches / profile_stats.frame_count),
+            (unsigned long)(fetch.fills / profile_stats.frame_count));
+    }
+#if M68K_BLOCK_MOVES
+    m68k_block_stats_t block;
+    m68k_block_get_stats(&block);
+    if (block.loops) {
+        LOG("M68K block:      %lu moves, %lu iterations, %lu B (%lu VDP words)/frame\n",
+            (unsigned long)(block.loops / profile_stats.frame_count),
+            (unsigned long)(block.iterations / profile_stats.frame_count),
+            (unsigned long)(block.bytes / profile_stats.frame_count),
+            (unsigned long)(block.vdp_words / profile_stats.frame_count));
+    }
+#endif
+#if Z80_CORE1
+    z80_core1_stats_t c1;
+    z80_core1_get_stats(&c1);
+    if (c1.frames) {
+        LOG("Z80 (core 1):    %6lu us Z80, %lu us sound, %lu us idle/frame\n",
+            (unsigned long)(c1.z80_us / c1.frames),
+            (unsigned long)(c1.sound_us / c1.frames),
+            (unsigned long)(c1.idle_us / c1.frames));
+        LOG("  events:        %lu/frame, %lu syncs (%lu us wait), %lu remote, %lu queue full\n",
+            (unsigned long)(c1.events / c1.frames),
+            (unsigned long)(c1.syncs / c1.frames),
+            (unsigned long)(c1.sync_wait_us / c1.frames),
+            (unsigned long)c1.remote, (unsigned long)c1.queue_full);
+    }
+#endif
+    // XIP cache serves flash code/data and PSRAM alike, counters restart each report
+    uint32_t xip_acc = xip_ctrl_hw->ctr_acc;
+    uint32_t xip_hit = xip_ctrl_hw->ctr_hit;
+    xip_ctrl_hw->ctr_acc = 0;
+    xip_ctrl_hw->ctr_hit = 0;
+    if (xip_acc) {
+        LOG("XIP cache:       %3lu.%lu%% hits, %lu accesses/frame, %lu misses/frame\n",
+            (unsigned long)((uint64_t)xip_hit * 100 / xip_acc),
+            (unsigned long)((uint64_t)xip_hit * 1000 / xip_acc % 10),
+            (unsigned long)(xip_acc / profile_stats.frame_count),
+            (unsigned long)((xip_acc - xip_hit) / profile_stats.frame_count));
+    }
+    psram_stream_stats_t stream;
+    psram_stream_get_stats(&stream);
+    if (stream.copies) {
+        LOG("PSRAM stream:    %lu copies (%lu DMA), %lu B/frame%s\n",
+            (unsigned long)(stream.copies / profile_stats.frame_count),
+            (unsigned long)(stream.dma / profile_stats.frame_count),
+            (unsigned long)(stream.bytes / profile_stats.frame_count),
+            PSRAM_STREAM ? "" : " (through the cache)");
+    }
     LOG("Other/overhead:  %6lu us (%3d%%)\n", 
         (unsigned long)(other / profile_stats.frame_count),
         (int)((other * 100) / total));
@@ -317,6 +444,9 @@ int16_t *audio_read_ym2612 = NULL;
 
 // ROM buffer in PSRAM
 static uint8_t *rom_buffer = NULL;
+
+// Savestate file for the loaded ROM (ROM path with .sav extension)
+static char savestate_path[MAX_ROM_PATH + 8];
 // Remove duplicate MAX_ROM_SIZE - it's defined in gwenesis_bus.h
 
 // Gwenesis external variables
@@ -428,11 +558,14 @@ static void __no_inline_not_in_flash_func(reconfigure_clocks)(uint16_t cpu_mhz,
     
     // Re-initialize PSRAM with new clock settings
     uint psram_pin = get_psram_pin();
-    psram_init_with_freq(psram_pin, psram_mhz);
+    psram_init_with_freq(psram_pin, psram_mhz != PSRAM_FREQ_AUTO ? psram_mhz : PSRAM_MAX_FREQ_MHZ);
     
     LOG("Clocks reconfigured: CPU=%lu MHz\n", clock_get_hz(clk_sys) / 1000000);
 }
 
+// ROM load chunk: read, byte-swapped and streamed to PSRAM at a time
+#define ROM_LOAD_CHUNK 4096
+
 // Load ROM from SD card
 static bool load_rom(const char *filename) {
     FIL file;
@@ -455,8 +588,18 @@ static bool load_rom(const char *filename) {
         return false;
     }
     
+    // Peek at the header: cartridge save memory is mirrored into the ROM
+    // buffer, which must then reach the end of its window
+    uint8_t header[0x200];
+    UINT header_read = 0;
+    memset(header, 0, sizeof(header));
+    f_read(&file, header, sizeof(header), &header_read);
+    f_lseek(&file, 0);
+    size_t rom_span = gwenesis_sram_init(header, file_size);
+    if (rom_span < file_size) rom_span = file_size;
+    
     // Allocate ROM buffer in PSRAM (size based on actual file, rounded up to 64KB)
-    size_t alloc_size = (file_size + 0xFFFF) & ~0xFFFF;  // Round up to 64KB boundary
+    size_t alloc_size = (rom_span + 0xFFFF) & ~0xFFFF;  // Round up to 64KB boundary
     if (rom_buffer == NULL) {
         rom_buffer = (uint8_t *)psram_malloc(alloc_size);
         if (rom_buffer == NULL) {
@@ -467,8 +610,28 @@ static bool load_rom(const char *filename) {
         LOG("Allocated %lu bytes for ROM\n", (unsigned long)alloc_size);
     }
     
-    // Read ROM into buffer
-    res = f_read(&file, rom_buffer, file_size, &bytes_read);
+    // Read ROM in chunks, byte-swap each in SRAM (Genesis ROMs are
+    // big-endian) and stream it to PSRAM past the XIP cache
+    static uint32_t chunk[ROM_LOAD_CHUNK / 4];
+    uint32_t xip_acc = xip_ctrl_hw->ctr_acc;
+    uint32_t xip_hit = xip_ctrl_hw->ctr_hit;
+    uint64_t load_start_us = time_us_64();
+    bytes_read = 0;
+    while (bytes_read < file_size) {
+        UINT want = file_size - bytes_read < ROM_LOAD_CHUNK ? file_size - bytes_read : ROM_LOAD_CHUNK;
+        UINT got = 0;
+        res = f_read(&file, chunk, want, &got);
+        if (res != FR_OK || got != want) break;
+        // Pad a partial word (the buffer is 64 KB aligned, a word past the end is ours)
+        UINT words = (got + 3) / 4;
+        if (got & 3) memset((uint8_t *)chunk + got, 0, words * 4 - got);
+        for (UINT i = 0; i < words; i++) {
+            uint32_t w = chunk[i];
+            chunk[i] = ((w & 0x00FF00FF) << 8) | ((w >> 8) & 0x00FF00FF);
+        }
+        psram_stream_copy(rom_buffer + bytes_read, chunk, words * 4);
+        bytes_read += got;
+    }
     f_close(&file);
     
     if (res != FR_OK || bytes_read != file_size) {
@@ -476,21 +639,32 @@ static bool load_rom(const char *filename) {
         return false;
     }
     
-    LOG("ROM loaded: %lu bytes\n", (unsigned long)bytes_read);
-    
-    // Byte-swap ROM (Genesis ROMs are big-endian)
-    for (size_t i = 0; i < bytes_read; i += 2) {
-        uint8_t tmp = rom_buffer[i];
-        rom_buffer[i] = rom_buffer[i + 1];
-        rom_buffer[i + 1] = tmp;
-    }
+    xip_acc = xip_ctrl_hw->ctr_acc - xip_acc;
+    xip_hit = xip_ctrl_hw->ctr_hit - xip_hit;
+    LOG("ROM loaded: %lu bytes in %lu ms, XIP cache %lu accesses, %lu misses\n",
+        (unsigned long)bytes_read, (unsigned long)((time_us_64() - load_start_us) / 1000),
+        (unsigned long)xip_acc, (unsigned long)(xip_acc - xip_hit));
     
-    // Set ROM_DATA to point to our PSRAM buffer
+    // Set ROM_DATA to point to our PSRAM buffer, ROM reads go through the
+    // bank map and the page cache
     ROM_DATA = rom_buffer;
-    
+    rom_cache_init();
+    rom_mapper_init(file_size);
+
     return true;
 }
 
+// Derive savestate path from ROM path: /genesis/game.md -> /genesis/game.sav
+static void set_savestate_path(const char *rom_path) {
+    snprintf(savestate_path, sizeof(savestate_path), "%s", rom_path);
+    char *slash = strrchr(savestate_path, '/');
+    char *dot = strrchr(savestate_path, '.');
+    if (dot == NULL || (slash != NULL && dot < slash)) {
+        dot = savestate_path + strlen(savestate_path);
+    }
+    snprintf(dot, sizeof(savestate_path) - (size_t)(dot - savestate_path), ".sav");
+}
+
 // Initialize Genesis emulator
 static void genesis_init(void) {
     // Print M68K struct offsets for assembly optimization
@@ -548,9 +722,68 @@ static void setup_genesis_palette(void) {
     }
 }
 
+// Fixed 888 samples per NTSC frame (53280 Hz / 60 fps)
+#define TARGET_SAMPLES_PER_FRAME 888
+#define AUDIO_TARGET_CLOCK (TARGET_SAMPLES_PER_FRAME * AUDIO_FREQ_DIVISOR)
+
+// Reset the Z80 and sound chip clocks for a new frame
+static void __time_critical_func(sound_frame_start)(void) {
+    extern volatile int zclk;
+    zclk = 0;
+#ifdef USE_Z80_GPX
+    // GPX Z80 needs timing reset when zclk is reset
+    extern void z80_reset_timing(void);
+    z80_reset_timing();
+#endif
+    
+    // Reset sound chip indices for new frame
+    sn76489_clock = 0;
+    sn76489_index = 0;
+    ym2612_clock = 0;
+    ym2612_index = 0;
+}
+
+// Generate any remaining audio samples for this frame
+static void __time_critical_func(sound_frame_end)(void) {
+    gwenesis_SN76489_run(AUDIO_TARGET_CLOCK);
+    ym2612_run(AUDIO_TARGET_CLOCK);
+}
+
+// Publish the finished frame's samples for audio_submit() and swap buffers
+static void __time_critical_func(audio_frame_handoff)(void) {
+    // Save sample counts for Core 1 BEFORE swapping buffers
+    saved_ym_samples = ym2612_index;
+    saved_sn_samples = sn76489_index;
+    
+    // Set read buffer pointers for Core 1 (current write buffer becomes read buffer)
+    audio_read_sn76489 = gwenesis_sn76489_buffer;
+    audio_read_ym2612 = gwenesis_ym2612_buffer;
+    
+    // Memory barrier to ensure all writes are visible to Core 1
+    __dmb();
+    
+    // Swap to other buffer for next frame's writes
+    audio_write_buffer = 1 - audio_write_buffer;
+    gwenesis_sn76489_buffer = gwenesis_sn76489_buffer_mem[audio_write_buffer];
+    gwenesis_ym2612_buffer = gwenesis_ym2612_buffer_mem[audio_write_buffer];
+}
+
+#if Z80_CORE1
+// Core 1 at the end of a frame: finish and submit its samples, then
+// persist a chunk of any dirty quick-save slot and cartridge save memory
+static void __time_critical_func(core1_frame_end)(void) {
+    sound_frame_end();
+    audio_frame_handoff();
+    audio_submit();
+    quicksave_flush_step();
+    cartsave_flush_step();
+}
+#endif
+
 // Sound processing on Core 1 (I2S output only)
 // With GWENESIS_AUDIO_ACCURATE=1, sound chips are run during M68K/Z80 emulation
 // Core 1 just submits the already-generated samples to I2S DMA
+// With Z80_CORE1 it also runs the Z80 and the sound chips (see z80_core1.h)
 static void __scratch_x("sound") sound_core(void) {
     // Allow core 0 to pause this core during flash operations
     multicore_lockout_victim_init();
@@ -567,11 +800,14 @@ static void __scratch_x("sound") sound_core(void) {
     // Signal that we're ready
     sem_release(&render_start_semaphore);
     
+#if Z80_CORE1
+    z80_core1_loop(sound_frame_start, core1_frame_end, input_poll_step);
+#else
     // Core 1 loop - synchronized with Core 0 emulation
     while (1) {
-        // Wait for Core 0 to complete a frame
+        // Wait for Core 0 to complete a frame, servicing USB/PS/2 meanwhile
         while (!frame_ready) {
-            tight_loop_contents();
+            input_poll_step();
         }
         frame_ready = false;
         
@@ -584,7 +820,186 @@ static void __scratch_x("sound") sound_core(void) {
         
         // Signal Core 0 that audio is done
         audio_done = true;
+        
+        // Idle until next frame: persist a chunk of any dirty quick-save slot
+        // and of settled cartridge save memory
+        quicksave_flush_step();
+        cartsave_flush_step();
+        input_poll_step();
+    }
+#endif
+}
+
+// Vblank interrupt line of the Z80, at the end of the line just run
+static inline void z80_vblank_irq(unsigned int value) {
+#if Z80_CORE1
+    z80_core1_post(system_clock + VDP_CYCLES_PER_LINE, Z80_EV_IRQ, 0, value);
+#else
+    z80_irq_line(value);
+#endif
+}
+
+// Run one frame of M68K/Z80 and finish the frame's audio samples
+static void __time_critical_func(emulate_frame)(void) {
+    int hint_counter = gwenesis_vdp_regs[10];
+    
+    system_clock = 0;
+    scan_line = 0;
+    
+    // Reset the Z80 and sound chip clocks for new frame
+#if Z80_CORE1
+    z80_core1_frame_start();
+#else
+    sound_frame_start();
+#endif
+    
+    // ==================================================================
+    // PHASE 1: Run all emulation first (M68K + Z80 + sound chips)
+    // This ensures sound chip state is updated at consistent timing
+    // Z80 can be run in larger timeslices to reduce interpreter overhead.
+    // This preserves overall playback speed (same total cycles), but may
+    // reduce sub-scanline timing fidelity for some PCM-heavy drivers.
+    // ==================================================================
+    while (scan_line < lines_per_frame) {
+#if INPUT_LATCH_EVERY_LINES
+        if (scan_line && (scan_line % INPUT_LATCH_EVERY_LINES) == 0) {
+            gwenesis_io_latch_buttons();
+        }
+#endif
+        // Run M68K for one line
+        PROFILE_START();
+#if USE_M68K_FAST_LOOP
+        m68k_run_fast(system_clock + VDP_CYCLES_PER_LINE);
+#else
+        m68k_run(system_clock + VDP_CYCLES_PER_LINE);
+#endif
+        PROFILE_END(m68k_time);
+        
+#if Z80_CORE1
+        // Core 1 may run the Z80 up to here, serve its accesses to 68K space
+        z80_core1_publish(system_clock + VDP_CYCLES_PER_LINE);
+        z80_core1_service();
+#else
+        // Run Z80 in chunks of scanlines to reduce call overhead.
+        if (((scan_line % z80_slice_lines) == (z80_slice_lines - 1)) || (scan_line == (lines_per_frame - 1))) {
+            PROFILE_START();
+            z80_run(system_clock + VDP_CYCLES_PER_LINE);
+            PROFILE_END(z80_time);
+        }
+#endif
+        
+        // Note: Sound chips are called automatically during YM2612Write/SN76489_Write
+        // with GWENESIS_AUDIO_ACCURATE=1 for cycle-accurate timing
+        
+        // Handle line counter interrupt
+        if (scan_line == 0 || scan_line > screen_height) {
+            hint_counter = gwenesis_vdp_regs[10];
+        }
+        
+        if (--hint_counter < 0) {
+            if (REG0_LINE_INTERRUPT != 0 && scan_line <= screen_height) {
+                hint_pending = 1;
+                if ((gwenesis_vdp_status & STATUS_VIRQPENDING) == 0)
+                    m68k_update_irq(4);
+            }
+            hint_counter = gwenesis_vdp_regs[10];
+        }
+        
+        scan_line++;
+        
+        // VBlank
+        if (scan_line == screen_height) {
+            if (REG1_VBLANK_INTERRUPT != 0) {
+                gwenesis_vdp_status |= STATUS_VIRQPENDING;
+                m68k_set_irq(6);
+            }
+            // Z80 IRQ for vblank
+            z80_vblank_irq(1);
+        }
+        if (scan_line == screen_height + 1) {
+            z80_vblank_irq(0);
+        }
+        
+        system_clock += VDP_CYCLES_PER_LINE;
+    }
+    
+#if Z80_CORE1
+    // Core 1 finishes the frame's samples
+    z80_core1_frame_end(system_clock);
+#else
+    PROFILE_START();
+    sound_frame_end();
+    PROFILE_END(sound_time);
+#endif
+}
+
+// Render the emulated frame into SCREEN, returns the render time in us
+static uint32_t __time_critical_func(render_frame)(void) {
+    PROFILE_START();
+    uint64_t render_start_us = time_us_64();
+    // Plane sizes and per-line scrolling, also when line 0 is skipped
+    gwenesis_vdp_render_config();
+#if LINE_INTERLACE
+    // Line interlacing: render every other line, then duplicate
+    // Alternates between even and odd lines each frame for better quality
+    int start_line = (frame_counter & 1);  // 0 or 1
+    for (int line = start_line; line < screen_height; line += 2) {
+        gwenesis_vdp_render_line(line);
+    }
+    // Duplicate rendered lines to adjacent lines (using SCREEN buffer)
+    for (int line = start_line; line < screen_height - 1; line += 2) {
+        memcpy(SCREEN[line + 1], SCREEN[line], screen_width);
     }
+#else
+    for (int line = 0; line < screen_height; line++) {
+        gwenesis_vdp_render_line(line);
+    }
+#endif
+    quicksave_draw_indicator((uint8_t *)SCREEN, screen_width, screen_height);
+    perf_osd_draw((uint8_t *)SCREEN, screen_width, screen_height);
+    latency_frame_rendered((const uint8_t *)SCREEN, sizeof(SCREEN));
+    uint32_t render_us = (uint32_t)(time_us_64() - render_start_us);
+    PROFILE_END(vdp_time);
+    return render_us;
+}
+
+#if ENABLE_ADAPTIVE_FRAMESKIP
+// EMA update (1/8 smoothing). Keep a non-zero estimate.
+static inline uint32_t render_cost_ema_update(uint32_t ema_us, uint32_t render_us) {
+    if (ema_us == 0) return render_us ? render_us : FRAMESKIP_RENDER_COST_DEFAULT_US;
+    return (ema_us * 7u + (render_us ? render_us : ema_us)) / 8u;
+}
+#endif
+
+// Run-ahead: emulate the next frame(s) with the current input, show the last
+// one and return to the real timeline. Audio of these frames lands in the
+// write buffer that the next real frame overwrites from sample 0.
+static uint32_t __time_critical_func(run_ahead_frames)(int frames) {
+    uint64_t start_us = time_us_64();
+    unsigned int saved_frame_counter = frame_counter;
+    
+    if (!runahead_snapshot()) {
+        return render_frame();
+    }
+    
+    for (int i = 0; i < frames; i++) {
+        emulate_frame();
+        if (i == frames - 1) {
+            render_frame();
+        }
+        frame_counter++;
+        m68k.cycles -= system_clock;
+        gwenesis_io_frame_end(system_clock);
+    }
+    
+    runahead_restore();
+    frame_counter = saved_frame_counter;
+    
+    uint32_t elapsed_us = (uint32_t)(time_us_64() - start_us);
+#if ENABLE_PROFILING
+    profile_stats.runahead_time += elapsed_us;
+#endif
+    return elapsed_us;
 }
 
 // Main emulation loop
@@ -614,6 +1029,7 @@ static void __time_critical_func(emulation_loop)(void) {
     uint32_t frame_budget_us = 16666;
     uint32_t frame_work_us = 0;
     uint32_t audio_wait_us_local = 0;
+    uint32_t runahead_work_us = 0;           // run-ahead runs after the work measurement
 
     // Adaptive frameskip state
     uint32_t backlog_us = 0;                 // accumulated "time behind" (work - budget)
@@ -622,6 +1038,12 @@ static void __time_critical_func(emulation_loop)(void) {
     uint32_t frameskip_rng = 0xC001D00Du;    // simple PRNG state for dithering
 #endif
 
+    // Core 1 takes over USB/PS/2 polling for the rest of the game
+    input_poll_start();
+    // ... and with Z80_CORE1 the Z80 and the sound chips
+    z80_core1_start();
+    perf_osd_set_enabled(PERF_OSD);
+
     while (1) {
         // Check for Start+Select hotkey to open settings menu
         if (settings_check_hotkey()) {
@@ -636,10 +1058,16 @@ static void __time_critical_func(emulation_loop)(void) {
                 sleep_ms(50);
             }
             
+            // The menu and the savestates see the whole machine at the frame boundary
+            z80_core1_drain();
+            
+            // The menu polls USB/PS/2 itself
+            input_poll_stop();
+            
             // Save current screen BEFORE changing anything
             // Note: saved_game_screen allocated in main(), may be NULL if allocation failed
             if (saved_game_screen != NULL) {
-                memcpy(saved_game_screen, (uint8_t *)SCREEN, SCREEN_WIDTH * SCREEN_HEIGHT);
+                psram_stream_copy(saved_game_screen, (uint8_t *)SCREEN, SCREEN_WIDTH * SCREEN_HEIGHT);
             }
             
             // Save current palette before showing settings
@@ -678,17 +1106,22 @@ static void __time_critical_func(emulation_loop)(void) {
             switch (result) {
                 case SETTINGS_RESULT_SAVE_RESTART:
                     // Save settings to SD card and restart
+                    cartsave_sync();
+                    quicksave_sd_lock();
                     settings_save();
                     watchdog_reboot(0, 0, 10);
                     while(1) tight_loop_contents();
                     break;
                     
                 case SETTINGS_RESULT_RESTART:
-                    // Restart without saving
+                    // Restart without saving settings (pending game saves are still written)
+                    cartsave_sync();
                     watchdog_reboot(0, 0, 10);
                     while(1) tight_loop_contents();
                     break;
                     
+                case SETTINGS_RESULT_SAVE_STATE:
+                case SETTINGS_RESULT_LOAD_STATE:
                 case SETTINGS_RESULT_CANCEL:
                 default:
                     // Restore Genesis palette FIRST (before screen is visible)
@@ -703,12 +1136,27 @@ static void __time_critical_func(emulation_loop)(void) {
                     
                     // Now restore the saved screen (with correct palette already set)
                     if (saved_game_screen != NULL) {
-                        memcpy((uint8_t *)SCREEN, saved_game_screen, SCREEN_WIDTH * SCREEN_HEIGHT);
+                        psram_stream_copy((uint8_t *)SCREEN, saved_game_screen, SCREEN_WIDTH * SCREEN_HEIGHT);
                     }
                     gwenesis_vdp_render_config();
                     last_screen_width = saved_screen_width;
                     last_screen_height = saved_screen_height;
                     
+                    // Savestates run between frames, after the game palette is back
+                    // (loading re-pushes the palette from the restored CRAM)
+                    if (result == SETTINGS_RESULT_SAVE_STATE || result == SETTINGS_RESULT_LOAD_STATE) {
+                        uint64_t state_start_us = time_us_64();
+                        quicksave_sd_lock();
+                        bool state_ok = (result == SETTINGS_RESULT_SAVE_STATE)
+                            ? gwenesis_savestate_save_file(savestate_path)
+                            : gwenesis_savestate_load_file(savestate_path);
+                        quicksave_sd_unlock();
+                        LOG("%s %s: %s (%lu us)\n",
+                            result == SETTINGS_RESULT_SAVE_STATE ? "Save state" : "Load state",
+                            savestate_path, state_ok ? "OK" : "FAILED",
+                            (unsigned long)(time_us_64() - state_start_us));
+                    }
+                    
                     // Keep buttons locked, wait for ALL buttons to be released
                     do {
                         sleep_ms(50);
@@ -719,6 +1167,7 @@ static void __time_critical_func(emulation_loop)(void) {
                     sleep_ms(100);
                     
                     // NOW unlock buttons
+                    input_poll_start();
                     button_lock = false;
                     
                     // Skip to next frame
@@ -726,7 +1175,34 @@ static void __time_critical_func(emulation_loop)(void) {
             }
         }
         
-        int hint_counter = gwenesis_vdp_regs[10];
+        // Quick-save hotkeys: only the in-memory snapshot runs here, between frames
+        switch (quicksave_check_hotkey()) {
+            case QUICKSAVE_ACTION_SAVE:
+                z80_core1_drain();
+                quicksave_save();
+                break;
+            case QUICKSAVE_ACTION_LOAD:
+                z80_core1_drain();
+                quicksave_load();
+                break;
+            case QUICKSAVE_ACTION_SLOT_PREV:
+                quicksave_set_slot(quicksave_get_slot() - 1);
+                LOG("Quick save slot: %d\n", quicksave_get_slot() + 1);
+                break;
+            case QUICKSAVE_ACTION_SLOT_NEXT:
+                quicksave_set_slot(quicksave_get_slot() + 1);
+                LOG("Quick save slot: %d\n", quicksave_get_slot() + 1);
+                break;
+            default:
+                break;
+        }
+        
+        // Hold-to-rewind: step back one snapshot per frame, then play that frame
+        bool rewinding = false;
+        if (rewind_hotkey_held()) {
+            z80_core1_drain();
+            rewinding = rewind_step();
+        }
         
         bool is_pal = REG1_PAL;
         // Target frame budget for adaptive frame skipping
@@ -790,6 +1266,10 @@ static void __time_critical_func(emulation_loop)(void) {
         if (force_render) {
             render_this_frame = true;
         }
+#if BENCH_FRAMES
+        // Benchmark runs render every frame, whatever the frameskip setting
+        render_this_frame = true;
+#endif
 
 #if ENABLE_ADAPTIVE_FRAMESKIP
         // If we choose to skip, immediately reduce backlog by the estimated render cost.
@@ -804,135 +1284,46 @@ static void __time_critical_func(emulation_loop)(void) {
 
         PROFILE_FRAME_START();
         frame_work_start_us = time_us_64();
-        
-        // No explicit frame limiting needed - audio DMA wait provides natural pacing
-        // When running fast, Core 1 waits for DMA buffer room (~60 FPS)
-        // When running slow, no waiting occurs (raw emulation speed)
-        
-        system_clock = 0;
-        scan_line = 0;
-        
-        // Reset Z80 clock for new frame (now runs on Core 0)
-        extern volatile int zclk;
-        zclk = 0;
-#ifdef USE_Z80_GPX
-        // GPX Z80 needs timing reset when zclk is reset
-        extern void z80_reset_timing(void);
-        z80_reset_timing();
+#if ENABLE_PROFILING
+        const profile_stats_t osd_base = profile_stats;  // Phase split of this frame for the overlay
 #endif
         
-        // Reset sound chip indices for new frame
-        sn76489_clock = 0;
-        sn76489_index = 0;
-        ym2612_clock = 0;
-        ym2612_index = 0;
-        
-        // ==================================================================
-        // PHASE 1: Run all emulation first (M68K + Z80 + sound chips)
-        // This ensures sound chip state is updated at consistent timing
-        // Z80 can be run in larger timeslices to reduce interpreter overhead.
-        // This preserves overall playback speed (same total cycles), but may
-        // reduce sub-scanline timing fidelity for some PCM-heavy drivers.
-        // ==================================================================
-        #ifndef Z80_SLICE_LINES
-        #define Z80_SLICE_LINES 16
-        #endif
-        while (scan_line < lines_per_frame) {
-            // Run M68K for one line
+        // Rewind snapshot at the frame boundary (not while walking backwards)
+        if (!rewinding && (frame_num % REWIND_INTERVAL) == 0 && rewind_enabled()) {
             PROFILE_START();
-#if USE_M68K_FAST_LOOP
-            m68k_run_fast(system_clock + VDP_CYCLES_PER_LINE);
-#else
-            m68k_run(system_clock + VDP_CYCLES_PER_LINE);
-#endif
-            PROFILE_END(m68k_time);
-            
-            // Run Z80 in chunks of scanlines to reduce call overhead.
-            if (((scan_line % Z80_SLICE_LINES) == (Z80_SLICE_LINES - 1)) || (scan_line == (lines_per_frame - 1))) {
-                PROFILE_START();
-                z80_run(system_clock + VDP_CYCLES_PER_LINE);
-                PROFILE_END(z80_time);
-            }
-            
-            // Note: Sound chips are called automatically during YM2612Write/SN76489_Write
-            // with GWENESIS_AUDIO_ACCURATE=1 for cycle-accurate timing
-            
-            // Handle line counter interrupt
-            if (scan_line == 0 || scan_line > screen_height) {
-                hint_counter = gwenesis_vdp_regs[10];
-            }
-            
-            if (--hint_counter < 0) {
-                if (REG0_LINE_INTERRUPT != 0 && scan_line <= screen_height) {
-                    hint_pending = 1;
-                    if ((gwenesis_vdp_status & STATUS_VIRQPENDING) == 0)
-                        m68k_update_irq(4);
-                }
-                hint_counter = gwenesis_vdp_regs[10];
-            }
-            
-            scan_line++;
-            
-            // VBlank
-            if (scan_line == screen_height) {
-                if (REG1_VBLANK_INTERRUPT != 0) {
-                    gwenesis_vdp_status |= STATUS_VIRQPENDING;
-                    m68k_set_irq(6);
-                }
-                // Z80 IRQ for vblank (Z80 runs on Core 0)
-                z80_irq_line(1);
-            }
-            if (scan_line == screen_height + 1) {
-                z80_irq_line(0);
-            }
-            
-            system_clock += VDP_CYCLES_PER_LINE;
+            z80_core1_drain();
+            rewind_capture();
+            PROFILE_END(rewind_time);
         }
         
-        // Generate any remaining audio samples for this frame
-        // Fixed 888 samples per NTSC frame (53280 Hz / 60 fps)
-        #define TARGET_SAMPLES_PER_FRAME 888
-        #define AUDIO_TARGET_CLOCK (TARGET_SAMPLES_PER_FRAME * AUDIO_FREQ_DIVISOR)
-        PROFILE_START();
-        gwenesis_SN76489_run(AUDIO_TARGET_CLOCK);
-        ym2612_run(AUDIO_TARGET_CLOCK);
-        PROFILE_END(sound_time);
+        // No explicit frame limiting needed - audio DMA wait provides natural pacing
+        // When running fast, Core 1 waits for DMA buffer room (~60 FPS)
+        // When running slow, no waiting occurs (raw emulation speed)
+        
+        // Pad reads during the frame are table loads from this snapshot
+        gwenesis_io_latch_buttons();
+        emulate_frame();
+        cartsave_frame();
         
         // ==================================================================
         // PHASE 2: Render the frame AFTER emulation is complete
         // This decouples rendering from emulation timing for stable audio
         // ==================================================================
-        if (render_this_frame) {
-            PROFILE_START();
-            uint64_t render_start_us = time_us_64();
-#if LINE_INTERLACE
-            // Line interlacing: render every other line, then duplicate
-            // Alternates between even and odd lines each frame for better quality
-            int start_line = (frame_counter & 1);  // 0 or 1
-            for (int line = start_line; line < screen_height; line += 2) {
-                gwenesis_vdp_render_line(line);
-            }
-            // Duplicate rendered lines to adjacent lines (using SCREEN buffer)
-            for (int line = start_line; line < screen_height - 1; line += 2) {
-                memcpy(SCREEN[line + 1], SCREEN[line], screen_width);
-            }
-#else
-            for (int line = 0; line < screen_height; line++) {
-                gwenesis_vdp_render_line(line);
-            }
-#endif
-            uint32_t render_us = (uint32_t)(time_us_64() - render_start_us);
-            PROFILE_END(vdp_time);
-
+        // With run-ahead the frame shown is rendered after the speculative frames
+        // (not with the Z80 on core 1, the snapshot covers core 0 only, nor in benchmark runs)
+        bool run_ahead = !Z80_CORE1 && !BENCH_FRAMES && render_this_frame && g_settings.runahead > 0 && runahead_init();
+        if (render_this_frame && !run_ahead) {
+            uint32_t render_us = render_frame();
 #if ENABLE_ADAPTIVE_FRAMESKIP
-            // EMA update (1/8 smoothing). Keep a non-zero estimate.
-            if (render_cost_ema_us == 0) render_cost_ema_us = render_us ? render_us : FRAMESKIP_RENDER_COST_DEFAULT_US;
-            else render_cost_ema_us = (render_cost_ema_us * 7u + (render_us ? render_us : render_cost_ema_us)) / 8u;
+            render_cost_ema_us = render_cost_ema_update(render_cost_ema_us, render_us);
+#else
+            (void)render_us;
 #endif
         }
         
         frame_counter++;
         m68k.cycles -= system_clock;
+        gwenesis_io_frame_end(system_clock);
 
 #if Z80_BENCHMARK
         z80_benchmark_frame_end();
@@ -973,7 +1364,8 @@ static void __time_critical_func(emulation_loop)(void) {
 
         // Compute work time for this frame (emulation + optional render), excluding audio wait.
     #if ENABLE_ADAPTIVE_FRAMESKIP
-        frame_work_us = (uint32_t)(time_us_64() - frame_work_start_us);
+        frame_work_us = (uint32_t)(time_us_64() - frame_work_start_us) + runahead_work_us;
+        runahead_work_us = 0;
     #endif
         
         // Wait for previous audio submission to complete 
@@ -981,9 +1373,14 @@ static void __time_critical_func(emulation_loop)(void) {
         // while Core 1 is still reading it
         PROFILE_START();
         uint64_t audio_wait_start_us = time_us_64();
+#if Z80_CORE1
+        // Core 1 hands its samples over itself, keep it at most one frame behind
+        z80_core1_wait_frames(1);
+#else
         while (!audio_done && frame_num > 0) {
             tight_loop_contents();
         }
+#endif
     #if ENABLE_ADAPTIVE_FRAMESKIP
         audio_wait_us_local = (uint32_t)(time_us_64() - audio_wait_start_us);
     #endif
@@ -1010,34 +1407,42 @@ static void __time_critical_func(emulation_loop)(void) {
         }
 #endif
         
-        // Save sample counts for Core 1 BEFORE swapping buffers
-        saved_ym_samples = ym2612_index;
-        saved_sn_samples = sn76489_index;
-        
-        // Set read buffer pointers for Core 1 (current write buffer becomes read buffer)
-        audio_read_sn76489 = gwenesis_sn76489_buffer;
-        audio_read_ym2612 = gwenesis_ym2612_buffer;
-        
-        // Memory barrier to ensure all writes are visible to Core 1
-        __dmb();
-        
-        // Swap to other buffer for next frame's writes
-        audio_write_buffer = 1 - audio_write_buffer;
-        gwenesis_sn76489_buffer = gwenesis_sn76489_buffer_mem[audio_write_buffer];
-        gwenesis_ym2612_buffer = gwenesis_ym2612_buffer_mem[audio_write_buffer];
+#if !Z80_CORE1
+        audio_frame_handoff();
         
         // Signal Core 1 to process audio (from read buffer)
         // Core 1's DMA wait provides natural frame pacing when running fast
         frame_ready = true;
+#endif
+        
+        // Run-ahead after the audio handoff: its samples land in the new write buffer
+        if (run_ahead) {
+            uint32_t run_ahead_us = run_ahead_frames(g_settings.runahead);
+#if ENABLE_ADAPTIVE_FRAMESKIP
+            // Skipping this frame's render now saves the whole run-ahead
+            render_cost_ema_us = render_cost_ema_update(render_cost_ema_us, run_ahead_us);
+            runahead_work_us = run_ahead_us;
+#else
+            (void)run_ahead_us;
+#endif
+        }
         
         frame_num++;
+        pcsample_frame();
+        cycprof_frame();
         
         PROFILE_FRAME_END();
         
-#ifdef USB_HID_ENABLED
-        // Poll USB HID Host for gamepad events
-        usbhid_task();
+        perf_osd_frame_t osd_frame = { .frame_us = (uint32_t)(time_us_64() - frame_work_start_us) };
+#if ENABLE_PROFILING
+        osd_frame.m68k_us = (uint32_t)(profile_stats.m68k_time - osd_base.m68k_time);
+        osd_frame.z80_us = (uint32_t)(profile_stats.z80_time - osd_base.z80_time);
+        osd_frame.sound_us = (uint32_t)(profile_stats.sound_time - osd_base.sound_time);
+        osd_frame.vdp_us = (uint32_t)(profile_stats.vdp_time - osd_base.vdp_time);
+        osd_frame.audio_wait_us = (uint32_t)(profile_stats.audio_wait_time - osd_base.audio_wait_time);
 #endif
+        perf_osd_frame(&osd_frame);
+        bench_frame(&osd_frame, (const uint8_t *)SCREEN, sizeof(SCREEN));
         
         // Print profiling stats every 300 frames (~5 seconds at 60fps)
         if ((frame_counter % 300) == 0) {
@@ -1121,6 +1526,7 @@ int main(void) {
     LOG("PSRAM pin: %u\n", psram_pin);
     psram_init(psram_pin);
     psram_reset();
+    psram_stream_init();
     LOG("PSRAM initialized\n");
     
     // Defer SD card mounting to after graphics init
@@ -1252,6 +1658,8 @@ int main(void) {
             current_cpu_mhz, g_settings.cpu_freq, PSRAM_MAX_FREQ_MHZ, g_settings.psram_freq);
         reconfigure_clocks(g_settings.cpu_freq, g_settings.psram_freq);
     }
+    psram_tune_apply();
+    uint16_t psram_mhz = g_settings.psram_freq;
     
     // Show ROM selector
     LOG("Showing ROM selector...\n");
@@ -1277,8 +1685,30 @@ int main(void) {
         }
     }
     
+    // Per-game settings, keyed by the header checksum (ROM is word-swapped,
+    // so a native halfword read gives the big-endian value). A game profile
+    // may override clocks, Z80, audio and frameskip, apply them before the
+    // first frame.
+    settings_load_game(*(uint16_t *)(ROM_DATA + 0x18E));
+    current_cpu_mhz = clock_get_hz(clk_sys) / 1000000;
+    if (g_settings.cpu_freq != current_cpu_mhz || g_settings.psram_freq != psram_mhz) {
+        LOG("Game profile requires clock reconfiguration (CPU: %lu->%d, PSRAM: %d->%d)\n",
+            current_cpu_mhz, g_settings.cpu_freq, psram_mhz, g_settings.psram_freq);
+        reconfigure_clocks(g_settings.cpu_freq, g_settings.psram_freq);
+        psram_tune_apply();
+    }
+    settings_apply_runtime();
+    
     // Initialize emulator
     genesis_init();
+    set_savestate_path(selected_rom);
+    quicksave_init(savestate_path);
+    cartsave_init(selected_rom);
+    bench_init(selected_rom);
+    rewind_init(g_settings.rewind_kb);
+    latency_init();
+    pcsample_init();
+    cycprof_init();
     
     // Allocate screen save buffer for in-game settings menu
     saved_game_screen = (uint8_t *)psram_malloc(SCREEN_WIDTH * SCREEN_HEIGHT);
@@ -1298,6 +1728,7 @@ int main(void) {
 
 // Gwenesis button state is defined in gwenesis_io.c
 extern unsigned char button_state[];
+extern unsigned char button_state_ext[];
 
 // Genesis button mapping (button_state bits):
 // Bit 0: Up
@@ -1313,6 +1744,12 @@ extern unsigned char button_state[];
 // Bit 6: A
 // Bit 7: Start
 //
+// 6-button extras (button_state_ext bits):
+// Bit 0: Z
+// Bit 1: Y
+// Bit 2: X
+// Bit 3: Mode
+//
 // NES Controller mapping (3-button):
 // - D-pad → Genesis D-pad
 // - NES B → Genesis B
@@ -1330,19 +1767,31 @@ extern unsigned char button_state[];
 // - SNES R → Genesis B (primary alt)
 // - Start → Genesis Start
 // - Select+Start → Reset to ROM selector
+//
+// Once the game reads the pad as a 6-button controller, the SNES face and
+// shoulder buttons follow the Genesis 6-button layout instead:
+// - SNES Y, X, L → Genesis X, Y, Z (top row)
+// - SNES B, A, R → Genesis A, B, C (bottom row)
 
 void gwenesis_io_get_buttons(void) {
     // Simple lock - if locked, all buttons released, period.
-    if (button_lock) {
+    // Benchmark runs never see input.
+    if (button_lock || BENCH_FRAMES) {
         button_state[0] = 0xFF;
         button_state[1] = 0xFF;
         button_state[2] = 0xFF;
+        button_state_ext[0] = 0xFF;
+        button_state_ext[1] = 0xFF;
+        button_state_ext[2] = 0xFF;
         return;
     }
+    button_state_ext[0] = 0xFF;
+    button_state_ext[1] = 0xFF;
 
 #ifdef NESPAD_GPIO_CLK
     // Read gamepad state
     nespad_read();
+    latency_input_sample(nespad_state);
     
     // Debug: track button presses for player 1
     static uint32_t prev_nespad_state = 0;
@@ -1376,17 +1825,32 @@ void gwenesis_io_get_buttons(void) {
     bool is_snes_pad1 = (nespad_state & (DPAD_X | DPAD_Y | DPAD_LT | DPAD_RT));
     bool is_snes_pad2 = (nespad_state2 & (DPAD_X | DPAD_Y | DPAD_LT | DPAD_RT));
     
+    // Select is the quick-save and rewind modifier: the buttons of the
+    // Select+A/B/Left/Right/Up hotkeys never reach the game, the rest does
+    uint32_t pad1 = nespad_state;
+    if ((pad1 & DPAD_SELECT) && !(pad1 & DPAD_START)) {
+        pad1 &= ~(DPAD_A | DPAD_B | DPAD_LEFT | DPAD_RIGHT | DPAD_UP);
+    }
+    
     // Map buttons to Genesis controller - Pad 1
     button_state[0] = 0xFF; // Start with all buttons released
     
     // D-pad mapping (same for NES/SNES)
-    if (nespad_state & DPAD_UP)    button_state[0] &= ~(1 << 0);
-    if (nespad_state & DPAD_DOWN)  button_state[0] &= ~(1 << 1);
-    if (nespad_state & DPAD_LEFT)  button_state[0] &= ~(1 << 2);
-    if (nespad_state & DPAD_RIGHT) button_state[0] &= ~(1 << 3);
-    
-    if (is_snes_pad1) {
-        // SNES controller - 6-button mapping
+    if (pad1 & DPAD_UP)    button_state[0] &= ~(1 << 0);
+    if (pad1 & DPAD_DOWN)  button_state[0] &= ~(1 << 1);
+    if (pad1 & DPAD_LEFT)  button_state[0] &= ~(1 << 2);
+    if (pad1 & DPAD_RIGHT) button_state[0] &= ~(1 << 3);
+    
+    if (is_snes_pad1 && gwenesis_io_pad6_used_by_game(0)) {
+        // SNES controller - Genesis 6-button layout
+        if (pad1 & DPAD_B)  button_state_ext[0] &= ~(1 << 2); // SNES Y → Genesis X
+        if (pad1 & DPAD_X)  button_state_ext[0] &= ~(1 << 1); // SNES X → Genesis Y
+        if (pad1 & DPAD_LT) button_state_ext[0] &= ~(1 << 0); // SNES L → Genesis Z
+        if (pad1 & DPAD_A)  button_state[0] &= ~(1 << 6);     // SNES B → Genesis A
+        if (pad1 & DPAD_Y)  button_state[0] &= ~(1 << 4);     // SNES A → Genesis B
+        if (pad1 & DPAD_RT) button_state[0] &= ~(1 << 5);     // SNES R → Genesis C
+    } else if (is_snes_pad1) {
+        // SNES controller - 3-button mapping
         // Note: Bit names don't match physical SNES button labels!
         // DPAD_A bit = Physical SNES B button (bottom)
         // DPAD_B bit = Physical SNES Y button (left)
@@ -1400,16 +1864,16 @@ void gwenesis_io_get_buttons(void) {
         // SNES X (top) → Genesis C (alternate)
         // SNES L → Genesis A (alternate jump)
         // SNES R → Genesis B (alternate shoot)
-        if (nespad_state & DPAD_A)  button_state[0] &= ~(1 << 6); // SNES B → Genesis A (jump)
-        if (nespad_state & DPAD_Y)  button_state[0] &= ~(1 << 4); // SNES A → Genesis B (shoot)
-        if (nespad_state & DPAD_B)  button_state[0] &= ~(1 << 5); // SNES Y → Genesis C (special)
-        if (nespad_state & DPAD_X)  button_state[0] &= ~(1 << 5); // SNES X → Genesis C (special alt)
-        if (nespad_state & DPAD_LT) button_state[0] &= ~(1 << 6); // SNES L → Genesis A (jump alt)
-        if (nespad_state & DPAD_RT) button_state[0] &= ~(1 << 4); // SNES R → Genesis B (shoot alt)
+        if (pad1 & DPAD_A)  button_state[0] &= ~(1 << 6); // SNES B → Genesis A (jump)
+        if (pad1 & DPAD_Y)  button_state[0] &= ~(1 << 4); // SNES A → Genesis B (shoot)
+        if (pad1 & DPAD_B)  button_state[0] &= ~(1 << 5); // SNES Y → Genesis C (special)
+        if (pad1 & DPAD_X)  button_state[0] &= ~(1 << 5); // SNES X → Genesis C (special alt)
+        if (pad1 & DPAD_LT) button_state[0] &= ~(1 << 6); // SNES L → Genesis A (jump alt)
+        if (pad1 & DPAD_RT) button_state[0] &= ~(1 << 4); // SNES R → Genesis B (shoot alt)
     } else {
         // NES controller - button combos
-        bool a_pressed = (nespad_state & DPAD_A);
-        bool b_pressed = (nespad_state & DPAD_B);
+        bool a_pressed = (pad1 & DPAD_A);
+        bool b_pressed = (pad1 & DPAD_B);
         
         // A+B combo = Genesis C
         if (a_pressed && b_pressed) {
@@ -1436,8 +1900,16 @@ void gwenesis_io_get_buttons(void) {
         if (nespad_state2 & DPAD_LEFT)  button_state[1] &= ~(1 << 2);
         if (nespad_state2 & DPAD_RIGHT) button_state[1] &= ~(1 << 3);
         
-        if (is_snes_pad2) {
-            // SNES controller - 6-button mapping (same as pad 1)
+        if (is_snes_pad2 && gwenesis_io_pad6_used_by_game(1)) {
+            // SNES controller - Genesis 6-button layout (same as pad 1)
+            if (nespad_state2 & DPAD_B)  button_state_ext[1] &= ~(1 << 2); // SNES Y → Genesis X
+            if (nespad_state2 & DPAD_X)  button_state_ext[1] &= ~(1 << 1); // SNES X → Genesis Y
+            if (nespad_state2 & DPAD_LT) button_state_ext[1] &= ~(1 << 0); // SNES L → Genesis Z
+            if (nespad_state2 & DPAD_A)  button_state[1] &= ~(1 << 6);     // SNES B → Genesis A
+            if (nespad_state2 & DPAD_Y)  button_state[1] &= ~(1 << 4);     // SNES A → Genesis B
+            if (nespad_state2 & DPAD_RT) button_state[1] &= ~(1 << 5);     // SNES R → Genesis C
+        } else if (is_snes_pad2) {
+            // SNES controller - 3-button mapping (same as pad 1)
             if (nespad_state2 & DPAD_A)  button_state[1] &= ~(1 << 6); // SNES B → Genesis A (jump)
             if (nespad_state2 & DPAD_Y)  button_state[1] &= ~(1 << 4); // SNES A → Genesis B (shoot)
             if (nespad_state2 & DPAD_B)  button_state[1] &= ~(1 << 5); // SNES Y → Genesis C (special)
@@ -1466,15 +1938,19 @@ void gwenesis_io_get_buttons(void) {
     button_state[1] = 0xFF;
 #endif
 
+    // USB/PS/2 state published by core 1 (packed input word)
+    uint32_t input_word = input_poll_read();
+
 #ifdef USB_HID_ENABLED
     // USB gamepad handling based on gamepad2_mode setting
     // Default: USB mirrors NES (both control P1)
     // USB mode: USB controls P2, NES controls P1
     int usb_target_player = (g_settings.gamepad2_mode == GAMEPAD2_MODE_USB) ? 1 : 0;
     
-    if (usbhid_gamepad_connected()) {
+    if (input_word & INPUT_WORD_GP_CONNECTED) {
         usbhid_gamepad_state_t gp;
-        usbhid_get_gamepad_state(&gp);
+        gp.buttons = INPUT_WORD_GP(input_word);
+        gp.dpad = INPUT_WORD_DPAD(input_word);
         
         // D-pad from USB gamepad
         if (gp.dpad & 0x01) button_state[usb_target_player] &= ~(1 << 0); // Up
@@ -1487,6 +1963,9 @@ void gwenesis_io_get_buttons(void) {
         if (gp.buttons & 0x01) button_state[usb_target_player] &= ~(1 << 6); // A → Genesis A
         if (gp.buttons & 0x02) button_state[usb_target_player] &= ~(1 << 4); // B → Genesis B
         if (gp.buttons & 0x04) button_state[usb_target_player] &= ~(1 << 5); // C → Genesis C
+        if (gp.buttons & 0x08) button_state_ext[usb_target_player] &= ~(1 << 2); // X → Genesis X
+        if (gp.buttons & 0x10) button_state_ext[usb_target_player] &= ~(1 << 1); // Y → Genesis Y
+        if (gp.buttons & 0x20) button_state_ext[usb_target_player] &= ~(1 << 0); // Z → Genesis Z
         if (gp.buttons & 0x40) button_state[usb_target_player] &= ~(1 << 7); // Start → Genesis Start
         
         // SELECT+START combo is now handled in the emulation loop for settings menu
@@ -1498,14 +1977,8 @@ void gwenesis_io_get_buttons(void) {
     // Keyboard mode: Keyboard controls P2
     int kbd_target_player = (g_settings.gamepad2_mode == GAMEPAD2_MODE_KEYBOARD) ? 1 : 0;
     
-    // PS/2 Keyboard input
-    ps2kbd_tick();
-    uint16_t kbd_state = ps2kbd_get_state();
-    
-#ifdef USB_HID_ENABLED
-    // Merge USB keyboard state with PS/2 keyboard state
-    kbd_state |= usbhid_get_kbd_state();
-#endif
+    // PS/2 and USB keyboard input (merged by the input service)
+    uint16_t kbd_state = INPUT_WORD_KBD(input_word);
     
     // Apply keyboard state to the appropriate player
     if (kbd_state & KBD_STATE_UP)    button_state[kbd_target_player] &= ~(1 << 0);  // Up
@@ -1517,5 +1990,8 @@ void gwenesis_io_get_buttons(void) {
     if (kbd_state & KBD_STATE_C)     button_state[kbd_target_player] &= ~(1 << 5);  // D key -> Genesis C (bit 5)
     if (kbd_state & KBD_STATE_START) button_state[kbd_target_player] &= ~(1 << 7);  // Start
     if (kbd_state & KBD_STATE_SELECT) button_state[kbd_target_player] &= ~(1 << 7); // Select also as Start for P2
-    // Note: X, Y, Z, Mode are for 6-button controllers (not yet fully implemented in gwenesis_io)
+    if (kbd_state & KBD_STATE_X)     button_state_ext[kbd_target_player] &= ~(1 << 2); // Q key -> Genesis X
+    if (kbd_state & KBD_STATE_Y)     button_state_ext[kbd_target_player] &= ~(1 << 1); // W key -> Genesis Y
+    if (kbd_state & KBD_STATE_Z)     button_state_ext[kbd_target_player] &= ~(1 << 0); // E key -> Genesis Z
+    if (kbd_state & KBD_STATE_MODE)  button_state_ext[kbd_target_player] &= ~(1 << 3); // Alt -> Genesis Mode
 }
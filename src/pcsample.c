@@ -0,0 +1,123 @@
+/*
+ * PC sampling profiler Implementation
+ *
+ * The SysTick handler takes the interrupted PC from the exception frame
+ * (MSP or PSP, selected by EXC_RETURN bit 2) and tail-calls the recorder.
+ * Both live in SRAM so sampling does not touch the XIP cache it is meant
+ * to measure. Addresses are counted in an open-addressed table; a sample
+ * that finds no free slot within a few probes is counted as dropped.
+ */
+#include "pcsample.h"
+
+#if PC_SAMPLING
+
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/structs/systick.h"
+#include <string.h>
+#include <stdio.h>
+
+#define SLOT_MASK (PCSAMPLE_SLOTS - 1)
+#define MAX_PROBES 16
+#define DITHER 256          // Reload jitter in clocks
+
+#define SYSTICK_ENABLE    (1u << 0)
+#define SYSTICK_TICKINT   (1u << 1)
+#define SYSTICK_CLKSOURCE (1u << 2)   // Processor clock
+
+#if PCSAMPLE_SLOTS & SLOT_MASK
+#error "PCSAMPLE_SLOTS must be a power of two"
+#endif
+
+typedef struct {
+    uint32_t pc;
+    uint32_t count;
+} pc_slot_t;
+
+static pc_slot_t slots[PCSAMPLE_SLOTS];
+static uint32_t samples;
+static uint32_t dropped;
+static uint32_t used;
+static uint32_t reload;
+static uint32_t lfsr = 0xACE1u;
+static uint32_t frames;
+
+void pcsample_record(uint32_t pc);
+
+// SysTick: fetch the stacked PC and hand it to the recorder
+void __attribute__((naked)) __not_in_flash_func(isr_systick)(void) {
+    __asm volatile(
+        "movs r0, #4\n"
+        "mov r1, lr\n"
+        "tst r0, r1\n"
+        "beq 1f\n"
+        "mrs r0, psp\n"
+        "b 2f\n"
+        "1: mrs r0, msp\n"
+        "2: ldr r0, [r0, #24]\n"
+        "b pcsample_record\n"
+    );
+}
+
+void __not_in_flash_func(pcsample_record)(uint32_t pc) {
+    // Next period: base reload plus a pseudo-random offset
+    lfsr = (lfsr >> 1) ^ (-(lfsr & 1u) & 0xB400u);
+    systick_hw->rvr = reload + (lfsr & (DITHER - 1));
+
+    pc &= ~1u;
+    uint32_t hash = (pc * 2654435761u) >> 16;
+    for (uint32_t probe = 0; probe < MAX_PROBES; probe++) {
+        pc_slot_t *slot = &slots[(hash + probe) & SLOT_MASK];
+        if (slot->pc == pc) {
+            slot->count++;
+            samples++;
+            return;
+        }
+        if (slot->pc == 0) {
+            slot->pc = pc;
+            slot->count = 1;
+            used++;
+            samples++;
+            return;
+        }
+    }
+    dropped++;
+}
+
+static void systick_start(void) {
+    systick_hw->csr = 0;
+    systick_hw->rvr = reload;
+    systick_hw->cvr = 0;
+    systick_hw->csr = SYSTICK_CLKSOURCE | SYSTICK_TICKINT | SYSTICK_ENABLE;
+}
+
+static void report(void) {
+    printf("=== PC samples: %lu samples, %lu dropped, %lu addresses ===\n",
+           (unsigned long)samples, (unsigned long)dropped, (unsigned long)used);
+    for (int i = 0; i < PCSAMPLE_SLOTS; i++) {
+        if (slots[i].count == 0) continue;
+        printf("PCS %08lx %lu\n", (unsigned long)slots[i].pc, (unsigned long)slots[i].count);
+    }
+    printf("=== PC samples end ===\n");
+}
+
+void pcsample_init(void) {
+    memset(slots, 0, sizeof(slots));
+    samples = dropped = used = 0;
+    frames = 0;
+    reload = clock_get_hz(clk_sys) / PCSAMPLE_HZ - DITHER / 2;
+    systick_start();
+}
+
+void pcsample_frame(void) {
+    if (++frames < PCSAMPLE_REPORT_FRAMES) return;
+
+    systick_hw->csr = 0;
+    report();
+    memset(slots, 0, sizeof(slots));
+    samples = dropped = used = 0;
+    frames = 0;
+    systick_start();
+}
+
+#endif // PC_SAMPLING
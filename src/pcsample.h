@@ -0,0 +1,57 @@
+/*
+ * PC sampling profiler
+ *
+ * Build with PC_SAMPLING=1 to sample the core 0 program counter from the
+ * SysTick exception at PCSAMPLE_HZ (the period is dithered so it cannot
+ * lock onto the frame or scanline loop). Samples are counted per address
+ * in an SRAM hash table and dumped over the log every
+ * PCSAMPLE_REPORT_FRAMES frames as
+ *   PCS <address> <count>
+ * lines between "=== PC samples" markers. tools/hot_code.py maps the
+ * addresses to functions through the link map and picks the hot functions
+ * to move into SRAM (see HOT_CODE_LIST in CMakeLists.txt).
+ */
+#ifndef PCSAMPLE_H
+#define PCSAMPLE_H
+
+#include <stdint.h>
+
+#ifndef PC_SAMPLING
+#define PC_SAMPLING 0
+#endif
+
+// Sampling rate on core 0
+#ifndef PCSAMPLE_HZ
+#define PCSAMPLE_HZ 10000
+#endif
+
+// Frames between two dumps (sampling pauses while dumping)
+#ifndef PCSAMPLE_REPORT_FRAMES
+#define PCSAMPLE_REPORT_FRAMES 1800
+#endif
+
+// Distinct addresses kept per dump (power of two, 8 bytes each)
+#ifndef PCSAMPLE_SLOTS
+#define PCSAMPLE_SLOTS 2048
+#endif
+
+#if PC_SAMPLING
+
+/**
+ * Start sampling core 0 (call on core 0)
+ */
+void pcsample_init(void);
+
+/**
+ * A frame was emulated, dumps and restarts every PCSAMPLE_REPORT_FRAMES
+ */
+void pcsample_frame(void);
+
+#else
+
+#define pcsample_init()
+#define pcsample_frame()
+
+#endif // PC_SAMPLING
+
+#endif // PCSAMPLE_H
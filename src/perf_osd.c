@@ -0,0 +1,213 @@
+/*
+ * Performance overlay Implementation
+ *
+ * Per frame the overlay adds the phase times to the window sums, stores the
+ * frame time for the sparkline and samples the audio fill (a few register
+ * reads). Every PERF_OSD_REFRESH_FRAMES frames it formats the text lines,
+ * takes the cache totals and picks its colors. Drawing is a fixed-size box:
+ * a clear, at most TEXT_ROWS * TEXT_COLS glyphs and SPARK_SAMPLES bars, so
+ * its cost does not depend on the game.
+ */
+#include "perf_osd.h"
+#include "settings.h"
+#include "gwenesis_bus.h"
+#include "z80inst.h"
+#include "audio.h"
+#include "HDMI.h"
+#include "pico/stdlib.h"
+#include <stdio.h>
+#include <string.h>
+
+#define GLYPH_WIDTH 6       // 5px glyph + 1px spacing
+#define GLYPH_HEIGHT 7
+#define ROW_HEIGHT 8
+#define TEXT_ROWS 4
+#define TEXT_COLS 30
+
+#define SPARK_SAMPLES 64    // Frames shown, oldest on the left
+#define SPARK_BAR 2         // Pixels per frame
+#define SPARK_HEIGHT 16
+#define SPARK_FULL_US 33333 // Top of the sparkline: two 60 Hz frames
+#define SPARK_GUIDE_US 16667
+
+#define PAD 2
+#define OSD_X 2
+#define OSD_WIDTH (TEXT_COLS * GLYPH_WIDTH + 2 * PAD)
+#define OSD_HEIGHT (PAD + TEXT_ROWS * ROW_HEIGHT + SPARK_HEIGHT + PAD)
+#define OSD_BOTTOM 8        // Lines kept clear below, the quick-save indicator lives there
+
+// Tenths of a millisecond as two printf arguments
+#define MS_ARGS(us) (unsigned long)((us) / 1000), (unsigned long)((us) % 1000 / 100)
+
+static bool enabled = false;       // main applies PERF_OSD when gameplay starts
+
+// Refresh window
+static perf_osd_frame_t sum;
+static uint32_t window_frames;
+static uint32_t window_start_us;
+static uint32_t min_fill_pct;
+static uint32_t draw_sum_us;
+static uint32_t draw_count;
+static uint32_t draw_max_us;
+static rom_cache_totals_t rom_base;
+static z80_bank_cache_totals_t z80_base;
+
+static uint16_t spark[SPARK_SAMPLES];   // Frame times in us, saturated
+static uint32_t spark_pos;              // Next sample to write (the oldest)
+
+static char text[TEXT_ROWS][TEXT_COLS + 1];
+static uint8_t color_fg, color_bg;
+
+// Brightest and darkest palette entries (the game owns the palette)
+static void pick_colors(void) {
+    int best_fg = -1, best_bg = 1 << 30;
+    for (int i = 0; i < 64; i++) {
+        uint32_t c = graphics_get_palette(i);
+        int luma = (int)(((c >> 16) & 0xFF) * 3 + ((c >> 8) & 0xFF) * 6 + (c & 0xFF));
+        if (luma > best_fg) { best_fg = luma; color_fg = (uint8_t)i; }
+        if (luma < best_bg) { best_bg = luma; color_bg = (uint8_t)i; }
+    }
+}
+
+static void window_reset(void) {
+    memset(&sum, 0, sizeof(sum));
+    window_frames = 0;
+    window_start_us = time_us_32();
+    min_fill_pct = 100;
+    draw_sum_us = 0;
+    draw_count = 0;
+    draw_max_us = 0;
+    rom_cache_get_totals(&rom_base);
+    z80_bank_cache_get_totals(&z80_base);
+}
+
+void perf_osd_set_enabled(bool on) {
+    if (on && !enabled) {
+        window_reset();
+        memset(spark, 0, sizeof(spark));
+        memset(text, 0, sizeof(text));
+        snprintf(text[0], sizeof(text[0]), "PERF OVERLAY");
+        pick_colors();
+    }
+    enabled = on;
+}
+
+bool perf_osd_enabled(void) {
+    return enabled;
+}
+
+// Hit rate of lookups/misses since the window start
+static void rate_text(char *buf, size_t size, uint32_t lookups, uint32_t misses) {
+    if (lookups == 0) {
+        snprintf(buf, size, "--");
+    } else {
+        snprintf(buf, size, "%lu%%", (unsigned long)((uint64_t)(lookups - misses) * 100 / lookups));
+    }
+}
+
+static void refresh(void) {
+    uint32_t n = window_frames;
+    uint32_t elapsed_us = time_us_32() - window_start_us;
+    uint32_t fps10 = elapsed_us ? (uint32_t)((uint64_t)n * 10000000u / elapsed_us) : 0;
+
+    rom_cache_totals_t rom;
+    z80_bank_cache_totals_t z80;
+    rom_cache_get_totals(&rom);
+    z80_bank_cache_get_totals(&z80);
+    char rom_rate[8], z80_rate[8];
+    rate_text(rom_rate, sizeof(rom_rate), rom.lookups - rom_base.lookups, rom.misses - rom_base.misses);
+    rate_text(z80_rate, sizeof(z80_rate), z80.lookups - z80_base.lookups, z80.misses - z80_base.misses);
+
+    uint32_t draw_avg_us = draw_count ? draw_sum_us / draw_count : 0;
+
+    snprintf(text[0], sizeof(text[0]), "FPS %lu.%lu FRAME %lu.%lu MS",
+             (unsigned long)(fps10 / 10), (unsigned long)(fps10 % 10), MS_ARGS(sum.frame_us / n));
+    snprintf(text[1], sizeof(text[1]), "68K %lu.%lu Z80 %lu.%lu SND %lu.%lu",
+             MS_ARGS(sum.m68k_us / n), MS_ARGS(sum.z80_us / n), MS_ARGS(sum.sound_us / n));
+    snprintf(text[2], sizeof(text[2]), "VDP %lu.%lu WAIT %lu.%lu OSD %lu/%luUS",
+             MS_ARGS(sum.vdp_us / n), MS_ARGS(sum.audio_wait_us / n),
+             (unsigned long)draw_avg_us, (unsigned long)draw_max_us);
+    snprintf(text[3], sizeof(text[3]), "ROM %s ZBANK %s AUD %lu%%",
+             rom_rate, z80_rate, (unsigned long)min_fill_pct);
+
+    pick_colors();
+    window_reset();
+}
+
+void perf_osd_frame(const perf_osd_frame_t *frame) {
+    if (!enabled) return;
+
+    sum.frame_us += frame->frame_us;
+    sum.m68k_us += frame->m68k_us;
+    sum.z80_us += frame->z80_us;
+    sum.sound_us += frame->sound_us;
+    sum.vdp_us += frame->vdp_us;
+    sum.audio_wait_us += frame->audio_wait_us;
+
+    spark[spark_pos] = (uint16_t)(frame->frame_us > UINT16_MAX ? UINT16_MAX : frame->frame_us);
+    spark_pos = (spark_pos + 1) % SPARK_SAMPLES;
+
+    uint32_t queued, capacity;
+    audio_get_fill(&queued, &capacity);
+    if (capacity) {
+        uint32_t pct = queued * 100 / capacity;
+        if (pct < min_fill_pct) min_fill_pct = pct;
+    }
+
+    if (++window_frames >= PERF_OSD_REFRESH_FRAMES) {
+        refresh();
+    }
+}
+
+static void draw_text(uint8_t *screen, int width, int x, int y, const char *s) {
+    for (; *s; s++, x += GLYPH_WIDTH) {
+        if (*s == ' ') continue;
+        const uint8_t *rows = settings_glyph_5x7(*s);
+        for (int row = 0; row < GLYPH_HEIGHT; row++) {
+            uint8_t bits = rows[row];
+            uint8_t *p = screen + (y + row) * width + x;
+            for (int col = 0; col < 5; col++) {
+                if (bits & (1u << (4 - col))) p[col] = color_fg;
+            }
+        }
+    }
+}
+
+void perf_osd_draw(uint8_t *screen, int width, int height) {
+    if (!enabled) return;
+
+    int y0 = height - OSD_BOTTOM - OSD_HEIGHT;
+    if (y0 < 0 || width < OSD_X + OSD_WIDTH) return;
+
+    uint32_t start_us = time_us_32();
+
+    for (int y = y0; y < y0 + OSD_HEIGHT; y++) {
+        memset(screen + y * width + OSD_X, color_bg, OSD_WIDTH);
+    }
+
+    for (int row = 0; row < TEXT_ROWS; row++) {
+        draw_text(screen, width, OSD_X + PAD, y0 + PAD + row * ROW_HEIGHT, text[row]);
+    }
+
+    // Sparkline, bars grow up from the bottom line, dotted 60 Hz budget
+    int base = y0 + PAD + TEXT_ROWS * ROW_HEIGHT + SPARK_HEIGHT - 1;
+    int x = OSD_X + PAD;
+    for (int i = 0; i < SPARK_SAMPLES; i++, x += SPARK_BAR) {
+        uint32_t us = spark[(spark_pos + i) % SPARK_SAMPLES];
+        int h = (int)(us * SPARK_HEIGHT / SPARK_FULL_US);
+        if (h > SPARK_HEIGHT) h = SPARK_HEIGHT;
+        if (h == 0 && us) h = 1;
+        for (int y = base - h + 1; y <= base; y++) {
+            memset(screen + y * width + x, color_fg, SPARK_BAR - 1);
+        }
+    }
+    int guide = base - SPARK_GUIDE_US * SPARK_HEIGHT / SPARK_FULL_US;
+    for (int gx = OSD_X + PAD; gx < OSD_X + PAD + SPARK_SAMPLES * SPARK_BAR; gx += 4) {
+        screen[guide * width + gx] = color_fg;
+    }
+
+    uint32_t us = time_us_32() - start_us;
+    draw_sum_us += us;
+    draw_count++;
+    if (us > draw_max_us) draw_max_us = us;
+}
@@ -0,0 +1,50 @@
+/*
+ * Performance overlay
+ * A box over the bottom-left of the picture with FPS, a frame-time
+ * sparkline, the core 0 time of each emulation phase, the ROM page cache
+ * and Z80 bank cache hit rates and the audio output fill. Drawn into SCREEN
+ * after the frame is rendered, with the 5x7 font of the settings menu.
+ * Numbers are averages over PERF_OSD_REFRESH_FRAMES frames (audio: the
+ * lowest fill seen); the text is only formatted then. The overlay times
+ * its own drawing and shows it on screen.
+ */
+#ifndef PERF_OSD_H
+#define PERF_OSD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Shown from boot (it is toggled in the settings menu at runtime)
+#ifndef PERF_OSD
+#define PERF_OSD 0
+#endif
+
+// Frames per text refresh
+#ifndef PERF_OSD_REFRESH_FRAMES
+#define PERF_OSD_REFRESH_FRAMES 30
+#endif
+
+// One emulated frame on core 0. Phases run on core 1 with Z80_CORE1 are 0.
+typedef struct {
+    uint32_t frame_us;       // Whole frame, audio pacing included
+    uint32_t m68k_us;
+    uint32_t z80_us;
+    uint32_t sound_us;
+    uint32_t vdp_us;
+    uint32_t audio_wait_us;
+} perf_osd_frame_t;
+
+void perf_osd_set_enabled(bool enabled);
+bool perf_osd_enabled(void);
+
+/**
+ * Account a finished frame (core 0, once per frame)
+ */
+void perf_osd_frame(const perf_osd_frame_t *frame);
+
+/**
+ * Draw the overlay into an 8-bit indexed screen of `width` x `height`
+ */
+void perf_osd_draw(uint8_t *screen, int width, int height);
+
+#endif // PERF_OSD_H
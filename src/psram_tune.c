@@ -0,0 +1,234 @@
+/*
+ * PSRAM timing calibration and benchmark Implementation
+ *
+ * All tests run in the first 64 KB of the allocator's scratch area, which
+ * nothing else uses, through the uncached XIP alias so every access reaches
+ * the chip. A candidate timing is first only read with: the patterns are
+ * written with the formula timing, so a clock the chip cannot follow never
+ * writes (a mis-sampled address would land anywhere in PSRAM). Points
+ * whose reads pass then write the patterns themselves, checked back with
+ * the formula timing.
+ */
+#include "psram_tune.h"
+#include "psram_allocator.h"
+#include "psram_stream.h"
+#include "settings.h"
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include <stdio.h>
+
+// Simple logging (conditional on ENABLE_LOGGING)
+#if ENABLE_LOGGING
+#define LOG(fmt, ...) printf(fmt, ##__VA_ARGS__)
+#else
+#define LOG(fmt, ...) do {} while(0)
+#endif
+
+// PSRAM max frequency from build config, the reference timing of the tests
+#ifndef PSRAM_MAX_FREQ_MHZ
+#define PSRAM_MAX_FREQ_MHZ 133
+#endif
+
+#define TEST_WORDS (16 * 1024)      // 64 KB
+#define LATENCY_READS 8192
+#define RXDELAY_MAX 7
+#define COOLDOWN_MAX 3
+#define PAGE_BYTES 4096             // ROM cache page
+
+static volatile uint32_t *test_area;
+
+static inline uint32_t pattern(uint32_t i, uint32_t invert) {
+    uint32_t x = (i + 1) * 0x9E3779B1u;
+    return (x ^ (x >> 15)) ^ invert;
+}
+
+static void __no_inline_not_in_flash_func(pattern_fill)(uint32_t invert) {
+    for (uint32_t i = 0; i < TEST_WORDS; i++) {
+        test_area[i] = pattern(i, invert);
+    }
+}
+
+static bool __no_inline_not_in_flash_func(pattern_check)(uint32_t invert) {
+    for (uint32_t i = 0; i < TEST_WORDS; i++) {
+        if (test_area[i] != pattern(i, invert)) return false;
+    }
+    return true;
+}
+
+// Reads with `timing` of patterns written with `reference`
+static bool read_ok(const psram_timing_t *reference, const psram_timing_t *timing) {
+    for (uint32_t invert = 0; invert <= 1; invert++) {
+        psram_set_timing(reference);
+        pattern_fill(invert ? ~0u : 0);
+        psram_set_timing(timing);
+        bool ok = pattern_check(invert ? ~0u : 0);
+        psram_set_timing(reference);
+        if (!ok) return false;
+    }
+    return true;
+}
+
+// Writes with `timing`, read back with both timings
+static bool write_ok(const psram_timing_t *reference, const psram_timing_t *timing) {
+    for (uint32_t invert = 0; invert <= 1; invert++) {
+        psram_set_timing(timing);
+        pattern_fill(invert ? ~0u : 0);
+        bool ok = pattern_check(invert ? ~0u : 0);
+        psram_set_timing(reference);
+        if (!ok || !pattern_check(invert ? ~0u : 0)) return false;
+    }
+    return true;
+}
+
+static void __no_inline_not_in_flash_func(bench_latency)(psram_bench_t *bench) {
+    uint32_t lfsr = 0xACE1u;
+    uint32_t sum = 0;
+    uint64_t t0 = time_us_64();
+    for (int i = 0; i < LATENCY_READS; i++) {
+        lfsr = (lfsr >> 1) ^ (-(lfsr & 1u) & 0xB400u);
+        sum += test_area[lfsr & (TEST_WORDS - 1)];
+    }
+    uint32_t us = (uint32_t)(time_us_64() - t0);
+    (void)sum;
+    bench->latency_ns = us * 1000u / LATENCY_READS;
+}
+
+static void bench_burst(psram_bench_t *bench) {
+    int channel = dma_claim_unused_channel(false);
+    if (channel < 0) {
+        bench->burst_kbs = 0;
+        return;
+    }
+    static uint32_t sink;
+    dma_channel_config c = dma_channel_get_default_config(channel);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+
+    // Best of two passes
+    uint32_t best_us = UINT32_MAX;
+    for (int pass = 0; pass < 2; pass++) {
+        uint64_t t0 = time_us_64();
+        dma_channel_configure(channel, &c, &sink, (const void *)test_area, TEST_WORDS, true);
+        dma_channel_wait_for_finish_blocking(channel);
+        uint32_t us = (uint32_t)(time_us_64() - t0);
+        if (us < best_us) best_us = us;
+    }
+    dma_channel_unclaim(channel);
+
+    if (best_us == 0) best_us = 1;
+    bench->burst_kbs = (uint32_t)((uint64_t)TEST_WORDS * 4 * 1000000 / 1024 / best_us);
+}
+
+void psram_bench_run(psram_bench_t *bench) {
+    bench_latency(bench);
+    bench_burst(bench);
+    bench->page_fill_ns = bench->latency_ns;
+    if (bench->burst_kbs) {
+        bench->page_fill_ns += (uint32_t)((uint64_t)PAGE_BYTES * 1000000000 / 1024 / bench->burst_kbs);
+    }
+}
+
+static uint32_t sck_mhz(const psram_timing_t *timing) {
+    return clock_get_hz(clk_sys) / 1000000 / timing->clkdiv;
+}
+
+// Sweep at the current clock, returns the reference timing if nothing beats it
+static void calibrate(const psram_timing_t *reference, psram_timing_t *best) {
+    const uint32_t clock_hz = clock_get_hz(clk_sys);
+    uint32_t min_div = (clock_hz + PSRAM_TUNE_MAX_MHZ * 1000000 - 1) / (PSRAM_TUNE_MAX_MHZ * 1000000);
+    if (min_div < 2) min_div = 2;
+
+    psram_bench_t bench;
+    *best = *reference;
+    psram_bench_run(&bench);
+    uint32_t best_ns = bench.page_fill_ns;
+    LOG("PSRAM calibration at %lu MHz, reference clkdiv %u rxdelay %u: %lu ns/page\n",
+        clock_hz / 1000000, reference->clkdiv, reference->rxdelay, (unsigned long)best_ns);
+
+    for (uint32_t div = min_div; div <= reference->clkdiv; div++) {
+        psram_timing_t t = { .clkdiv = (uint8_t)div, .cooldown = reference->cooldown };
+
+        // Read delays that pass, keep the middle of the widest window
+        int run_start = 0, run_len = 0, win_start = 0, win_len = 0;
+        for (int rx = 0; rx <= RXDELAY_MAX; rx++) {
+            t.rxdelay = (uint8_t)rx;
+            if (read_ok(reference, &t)) {
+                if (run_len++ == 0) run_start = rx;
+                if (run_len > win_len) {
+                    win_start = run_start;
+                    win_len = run_len;
+                }
+            } else {
+                run_len = 0;
+            }
+        }
+        if (win_len < PSRAM_TUNE_MIN_WINDOW) {
+            LOG("  clkdiv %lu (%lu MHz): no stable read delay\n",
+                (unsigned long)div, (unsigned long)sck_mhz(&t));
+            continue;
+        }
+        t.rxdelay = (uint8_t)(win_start + win_len / 2);
+        if (!write_ok(reference, &t)) {
+            LOG("  clkdiv %lu (%lu MHz): writes fail\n", (unsigned long)div, (unsigned long)sck_mhz(&t));
+            continue;
+        }
+
+        for (int cd = 0; cd <= COOLDOWN_MAX; cd++) {
+            t.cooldown = (uint8_t)cd;
+            if (!read_ok(reference, &t)) continue;
+            psram_set_timing(&t);
+            psram_bench_run(&bench);
+            psram_set_timing(reference);
+            LOG("  clkdiv %lu (%lu MHz) rxdelay %u [%d-%d] cooldown %d: %lu ns, %lu KB/s, %lu ns/page\n",
+                (unsigned long)div, (unsigned long)sck_mhz(&t), t.rxdelay,
+                win_start, win_start + win_len - 1, cd, (unsigned long)bench.latency_ns,
+                (unsigned long)bench.burst_kbs, (unsigned long)bench.page_fill_ns);
+            if (bench.page_fill_ns < best_ns) {
+                best_ns = bench.page_fill_ns;
+                *best = t;
+            }
+        }
+    }
+}
+
+void psram_tune_apply(void) {
+    const uint16_t cpu_mhz = (uint16_t)(clock_get_hz(clk_sys) / 1000000);
+    psram_timing_t timing;
+
+    test_area = (volatile uint32_t *)psram_nocache(psram_get_scratch_1(TEST_WORDS * 4));
+
+    if (g_settings.psram_freq == PSRAM_FREQ_AUTO) {
+        psram_timing_t reference;
+        psram_timing_for_freq(PSRAM_MAX_FREQ_MHZ * 1000000, &reference);
+
+        psram_timing_t *stored = settings_psram_timing(cpu_mhz);
+        bool ok = false;
+        if (stored && stored->clkdiv) {
+            timing = *stored;
+            ok = read_ok(&reference, &timing) && write_ok(&reference, &timing);
+            if (!ok) {
+                LOG("PSRAM: stored timing fails at %u MHz, calibrating again\n", cpu_mhz);
+            }
+        }
+        if (!ok) {
+            calibrate(&reference, &timing);
+            if (stored) {
+                *stored = timing;
+                if (!settings_save()) {
+                    LOG("PSRAM: could not save the calibration\n");
+                }
+            }
+        }
+        psram_set_timing(&timing);
+    }
+
+    psram_bench_t bench;
+    psram_get_timing(&timing);
+    psram_bench_run(&bench);
+    LOG("PSRAM: clkdiv %u (%lu MHz) rxdelay %u cooldown %u: %lu ns/word, %lu KB/s, %lu ns/page\n",
+        timing.clkdiv, (unsigned long)sck_mhz(&timing), timing.rxdelay, timing.cooldown,
+        (unsigned long)bench.latency_ns, (unsigned long)bench.burst_kbs,
+        (unsigned long)bench.page_fill_ns);
+}
@@ -0,0 +1,49 @@
+/*
+ * PSRAM timing calibration and benchmark
+ *
+ * With psram_freq = auto in settings.ini the QMI timing of the PSRAM is
+ * not derived from a frequency but calibrated at the current system
+ * clock: every clock divider from the fixed formula's down to
+ * PSRAM_TUNE_MAX_MHZ, every read delay and every cooldown is checked with
+ * a pattern test in the allocator's scratch area, and the passing points
+ * are benchmarked (random word latency, sequential DMA burst throughput).
+ * The point with the cheapest ROM cache page fill is stored per CPU clock
+ * in settings.ini and reused on later boots once it passes the pattern
+ * test again; a stored timing that fails is calibrated anew.
+ */
+#ifndef PSRAM_TUNE_H
+#define PSRAM_TUNE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "psram_init.h"
+
+// Fastest SCK the sweep tries (MHz)
+#ifndef PSRAM_TUNE_MAX_MHZ
+#define PSRAM_TUNE_MAX_MHZ 180
+#endif
+
+// Passing read delays needed around the chosen one (half clk_sys cycles)
+#ifndef PSRAM_TUNE_MIN_WINDOW
+#define PSRAM_TUNE_MIN_WINDOW 2
+#endif
+
+typedef struct {
+    uint32_t latency_ns;    // Random word read, uncached
+    uint32_t burst_kbs;     // Sequential DMA read, KB/s
+    uint32_t page_fill_ns;  // 4 KB ROM cache page: latency + 4 KB at burst rate
+} psram_bench_t;
+
+/**
+ * Benchmark the current PSRAM timing (reads the scratch area only)
+ */
+void psram_bench_run(psram_bench_t *bench);
+
+/**
+ * Apply the PSRAM timing of g_settings at the current system clock and
+ * log its benchmark. In auto mode this verifies the stored calibration of
+ * this clock, or calibrates and saves settings.ini.
+ */
+void psram_tune_apply(void);
+
+#endif // PSRAM_TUNE_H
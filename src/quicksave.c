@@ -0,0 +1,292 @@
+/*
+ * Quick-save slots Implementation
+ *
+ * Core 0 owns the slot buffers: save/load run between frames and only ever
+ * cost the in-memory copy. Core 1 owns the flush: after submitting a frame
+ * of audio it writes one QUICKSAVE_FLUSH_CHUNK of a dirty slot, so a full
+ * ~150 KB snapshot reaches the SD card in well under a second without ever
+ * blocking emulation.
+ *
+ * Slot state is tracked with generation counters instead of a shared flag:
+ * core 0 bumps `generation` after each snapshot, core 1 records the
+ * generation it finished writing in `flushed_generation`. A slot is dirty
+ * while they differ, and a snapshot taken mid-flush simply restarts it.
+ */
+#include "quicksave.h"
+#include "gwenesis_savestate.h"
+#include "psram_allocator.h"
+#include "ff.h"
+#include "pico/stdlib.h"
+#include "pico/sync.h"
+#include "hardware/sync.h"
+#include "HDMI.h"
+#include "nespad/nespad.h"
+#include "ps2kbd/ps2kbd_wrapper.h"
+#include "input_poll.h"
+#include <string.h>
+#include <stdio.h>
+
+// Simple logging (conditional on ENABLE_LOGGING)
+#if ENABLE_LOGGING
+#define LOG(fmt, ...) printf(fmt, ##__VA_ARGS__)
+#else
+#define LOG(fmt, ...) do {} while(0)
+#endif
+
+// Progress bar geometry (bottom-left corner of the game frame)
+#define INDICATOR_X 4
+#define INDICATOR_WIDTH 64
+#define INDICATOR_HEIGHT 3
+
+typedef struct {
+    unsigned char *buffer;              // PSRAM snapshot (NULL until first use)
+    volatile uint32_t size;             // Valid bytes in buffer
+    volatile uint32_t generation;       // Bumped by core 0 after each snapshot
+    volatile uint32_t flushed_generation;  // Last generation written by core 1
+    char path[MAX_QUICKSAVE_PATH];
+} quicksave_slot_t;
+
+static quicksave_slot_t slots[QUICKSAVE_SLOT_COUNT];
+static int current_slot = 0;
+
+// Flush state (core 1 only)
+static FIL flush_file;
+static int flush_slot = -1;
+static uint32_t flush_generation = 0;
+static volatile uint32_t flush_offset = 0;
+
+// FatFs is built without FF_FS_REENTRANT: one core on the card at a time
+auto_init_mutex(sd_mutex);
+
+void quicksave_sd_lock(void) {
+    mutex_enter_blocking(&sd_mutex);
+}
+
+bool quicksave_sd_try_lock(void) {
+    return mutex_try_enter(&sd_mutex, NULL);
+}
+
+void quicksave_sd_unlock(void) {
+    mutex_exit(&sd_mutex);
+}
+
+void quicksave_init(const char *savestate_path) {
+    for (int i = 0; i < QUICKSAVE_SLOT_COUNT; i++) {
+        snprintf(slots[i].path, sizeof(slots[i].path), "%s%d", savestate_path, i + 1);
+        slots[i].size = 0;
+        slots[i].generation = 0;
+        slots[i].flushed_generation = 0;
+    }
+    current_slot = 0;
+}
+
+static unsigned char *quicksave_get_buffer(quicksave_slot_t *slot) {
+    if (slot->buffer == NULL) {
+        slot->buffer = (unsigned char *)psram_malloc(GWENESIS_SAVESTATE_MAX_SIZE);
+    }
+    return slot->buffer;
+}
+
+bool quicksave_save(void) {
+    quicksave_slot_t *slot = &slots[current_slot];
+    unsigned char *buffer = quicksave_get_buffer(slot);
+    if (buffer == NULL) return false;
+
+    uint64_t start_us = time_us_64();
+    int size = saveGwenesisState(buffer, GWENESIS_SAVESTATE_MAX_SIZE);
+    if (size == 0) return false;
+
+    slot->size = (uint32_t)size;
+    // Publish the snapshot to core 1 only once it is complete
+    __dmb();
+    slot->generation++;
+
+    LOG("Quick save slot %d: %d bytes (%lu us)\n", current_slot + 1, size,
+        (unsigned long)(time_us_64() - start_us));
+    return true;
+}
+
+// Read a slot file written by a previous session
+static bool quicksave_read_file(quicksave_slot_t *slot, unsigned char *buffer) {
+    FIL file;
+    UINT br = 0;
+    bool ok = false;
+
+    quicksave_sd_lock();
+    if (f_open(&file, slot->path, FA_READ) == FR_OK) {
+        FSIZE_t size = f_size(&file);
+        if (size > 0 && size <= GWENESIS_SAVESTATE_MAX_SIZE &&
+            f_read(&file, buffer, (UINT)size, &br) == FR_OK && br == (UINT)size &&
+            gwenesis_savestate_check(buffer, (uint32_t)size)) {
+            slot->size = (uint32_t)size;
+            ok = true;
+        }
+        f_close(&file);
+    }
+    quicksave_sd_unlock();
+
+    return ok;
+}
+
+bool quicksave_load(void) {
+    quicksave_slot_t *slot = &slots[current_slot];
+
+    if (slot->size == 0) {
+        unsigned char *buffer = quicksave_get_buffer(slot);
+        if (buffer == NULL || !quicksave_read_file(slot, buffer)) return false;
+    }
+
+    uint64_t start_us = time_us_64();
+    bool ok = loadGwenesisState(slot->buffer) != 0;
+
+    LOG("Quick load slot %d: %s (%lu us)\n", current_slot + 1, ok ? "OK" : "FAILED",
+        (unsigned long)(time_us_64() - start_us));
+    return ok;
+}
+
+int quicksave_get_slot(void) {
+    return current_slot;
+}
+
+void quicksave_set_slot(int slot) {
+    if (slot < 0) slot = QUICKSAVE_SLOT_COUNT - 1;
+    if (slot >= QUICKSAVE_SLOT_COUNT) slot = 0;
+    current_slot = slot;
+}
+
+quicksave_action_t quicksave_check_hotkey(void) {
+    static quicksave_action_t prev_action = QUICKSAVE_ACTION_NONE;
+    quicksave_action_t action = QUICKSAVE_ACTION_NONE;
+
+    // Select is the modifier on gamepads (Select+Start stays the settings menu)
+    uint32_t buttons = nespad_state;
+    bool select = (buttons & DPAD_SELECT) && !(buttons & DPAD_START);
+
+    uint32_t input_word = input_poll_read();
+
+#ifdef USB_HID_ENABLED
+    if (input_word & INPUT_WORD_GP_CONNECTED) {
+        uint8_t gp_buttons = INPUT_WORD_GP(input_word);
+        uint8_t gp_dpad = INPUT_WORD_DPAD(input_word);
+        // Select=0x80, A=0x01, B=0x02, Start=0x40
+        if ((gp_buttons & 0x80) && !(gp_buttons & 0x40)) {
+            select = true;
+            if (gp_buttons & 0x01) buttons |= DPAD_A;
+            if (gp_buttons & 0x02) buttons |= DPAD_B;
+            if (gp_dpad & 0x04) buttons |= DPAD_LEFT;
+            if (gp_dpad & 0x08) buttons |= DPAD_RIGHT;
+        }
+    }
+#endif
+
+    if (select) {
+        if (buttons & DPAD_B)          action = QUICKSAVE_ACTION_SAVE;
+        else if (buttons & DPAD_A)     action = QUICKSAVE_ACTION_LOAD;
+        else if (buttons & DPAD_LEFT)  action = QUICKSAVE_ACTION_SLOT_PREV;
+        else if (buttons & DPAD_RIGHT) action = QUICKSAVE_ACTION_SLOT_NEXT;
+    }
+
+    // Keyboard: F5 = save, F8 = load
+    uint16_t kbd_state = INPUT_WORD_KBD(input_word);
+    if (kbd_state & KBD_STATE_SAVE)      action = QUICKSAVE_ACTION_SAVE;
+    else if (kbd_state & KBD_STATE_LOAD) action = QUICKSAVE_ACTION_LOAD;
+
+    // Edge triggered: one action per press
+    if (action == prev_action) return QUICKSAVE_ACTION_NONE;
+    prev_action = action;
+    return action;
+}
+
+void quicksave_flush_step(void) {
+    // Never wait for the card: core 0 may be using it
+    if (!mutex_try_enter(&sd_mutex, NULL)) return;
+
+    if (flush_slot < 0) {
+        for (int i = 0; i < QUICKSAVE_SLOT_COUNT; i++) {
+            if (slots[i].generation != slots[i].flushed_generation) {
+                if (f_open(&flush_file, slots[i].path, FA_WRITE | FA_CREATE_ALWAYS) == FR_OK) {
+                    flush_slot = i;
+                    flush_generation = slots[i].generation;
+                    flush_offset = 0;
+                } else {
+                    // Card not writable: drop the request instead of retrying every frame
+                    slots[i].flushed_generation = slots[i].generation;
+                }
+                break;
+            }
+        }
+        if (flush_slot < 0) {
+            mutex_exit(&sd_mutex);
+            return;
+        }
+    }
+
+    quicksave_slot_t *slot = &slots[flush_slot];
+
+    // A new snapshot landed mid-flush: rewrite from the start
+    if (slot->generation != flush_generation) {
+        flush_generation = slot->generation;
+        flush_offset = 0;
+        f_lseek(&flush_file, 0);
+    }
+    __dmb();
+
+    uint32_t size = slot->size;
+    uint32_t chunk = size - flush_offset;
+    if (chunk > QUICKSAVE_FLUSH_CHUNK) chunk = QUICKSAVE_FLUSH_CHUNK;
+
+    UINT bw = 0;
+    FRESULT res = f_write(&flush_file, slot->buffer + flush_offset, chunk, &bw);
+    flush_offset += bw;
+
+    if (res != FR_OK || bw != chunk || flush_offset >= size) {
+        f_truncate(&flush_file);
+        f_close(&flush_file);
+        if (res != FR_OK || bw != chunk) {
+            LOG("Quick save slot %d: SD write failed (%d)\n", flush_slot + 1, res);
+        }
+        // If a snapshot raced the last chunk, generation moved on and the slot stays dirty
+        slot->flushed_generation = flush_generation;
+        flush_slot = -1;
+    }
+
+    mutex_exit(&sd_mutex);
+}
+
+// Brightest and darkest entries of the current game palette
+static void find_indicator_colors(uint8_t *fg, uint8_t *bg) {
+    int best_fg = -1, best_bg = 1 << 30;
+    *fg = 0;
+    *bg = 0;
+    for (int i = 0; i < 64; i++) {
+        uint32_t c = graphics_get_palette(i);
+        int luma = (int)(((c >> 16) & 0xFF) * 3 + ((c >> 8) & 0xFF) * 6 + (c & 0xFF));
+        if (luma > best_fg) { best_fg = luma; *fg = (uint8_t)i; }
+        if (luma < best_bg) { best_bg = luma; *bg = (uint8_t)i; }
+    }
+}
+
+void quicksave_draw_indicator(uint8_t *screen, int width, int height) {
+    int dirty = -1;
+    for (int i = 0; i < QUICKSAVE_SLOT_COUNT; i++) {
+        if (slots[i].generation != slots[i].flushed_generation) {
+            dirty = i;
+            break;
+        }
+    }
+    if (dirty < 0) return;
+
+    uint32_t size = slots[dirty].size;
+    uint32_t done = (flush_slot == dirty && size) ? flush_offset : 0;
+    int filled = (int)((uint64_t)done * INDICATOR_WIDTH / (size ? size : 1));
+
+    uint8_t fg, bg;
+    find_indicator_colors(&fg, &bg);
+
+    int y0 = height - INDICATOR_HEIGHT - 2;
+    for (int y = y0; y < y0 + INDICATOR_HEIGHT; y++) {
+        uint8_t *line = screen + y * width + INDICATOR_X;
+        memset(line, fg, (size_t)filled);
+        memset(line + filled, bg, (size_t)(INDICATOR_WIDTH - filled));
+    }
+}
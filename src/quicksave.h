@@ -0,0 +1,78 @@
+/*
+ * Quick-save slots - instant savestates held in PSRAM
+ * Snapshots are taken between frames at memcpy speed; core 1 persists
+ * dirty slots to the SD card in small chunks during its idle time.
+ */
+#ifndef QUICKSAVE_H
+#define QUICKSAVE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Number of quick-save slots (each holds one GWENESIS_SAVESTATE_MAX_SIZE snapshot)
+#ifndef QUICKSAVE_SLOT_COUNT
+#define QUICKSAVE_SLOT_COUNT 4
+#endif
+
+// Bytes written to the SD card per core 1 idle step (~2 ms on SPI)
+#ifndef QUICKSAVE_FLUSH_CHUNK
+#define QUICKSAVE_FLUSH_CHUNK 4096
+#endif
+
+// Slot file path: savestate path plus slot digit
+#define MAX_QUICKSAVE_PATH 144
+
+// Hotkey actions
+typedef enum {
+    QUICKSAVE_ACTION_NONE,
+    QUICKSAVE_ACTION_SAVE,       // Select+B, F5
+    QUICKSAVE_ACTION_LOAD,       // Select+A, F8
+    QUICKSAVE_ACTION_SLOT_PREV,  // Select+Left
+    QUICKSAVE_ACTION_SLOT_NEXT,  // Select+Right
+} quicksave_action_t;
+
+/**
+ * Set up slot file names from the savestate path (game.sav -> game.sav1..N)
+ * Slot buffers are allocated in PSRAM on first use.
+ */
+void quicksave_init(const char *savestate_path);
+
+/**
+ * Snapshot the machine into the current slot (core 0, between frames)
+ * @return true on success
+ */
+bool quicksave_save(void);
+
+/**
+ * Restore the current slot; reads it from the SD card if it is not in PSRAM yet
+ * @return true on success
+ */
+bool quicksave_load(void);
+
+int quicksave_get_slot(void);
+void quicksave_set_slot(int slot);
+
+/**
+ * Check the quick-save hotkeys (uses the pad/keyboard state already polled
+ * this frame by settings_check_hotkey). Edge triggered.
+ */
+quicksave_action_t quicksave_check_hotkey(void);
+
+/**
+ * Write the next chunk of a dirty slot to the SD card (core 1 idle time)
+ */
+void quicksave_flush_step(void);
+
+/**
+ * Draw the slot flush progress bar into the frame (nothing when all slots are clean)
+ */
+void quicksave_draw_indicator(uint8_t *screen, int width, int height);
+
+/**
+ * Serialize SD card access between cores (FatFs is not reentrant)
+ */
+void quicksave_sd_lock(void);
+bool quicksave_sd_try_lock(void);
+void quicksave_sd_unlock(void);
+
+#endif // QUICKSAVE_H
@@ -0,0 +1,315 @@
+/*
+ * Rewind Implementation
+ *
+ * The ring keeps one full "key" snapshot (the newest state) plus a chain of
+ * backward deltas: entry n holds snapshot(n-1) XOR snapshot(n). Rewinding
+ * XORs the newest delta into the key and loads it, so every step costs one
+ * pass over a small delta and a normal savestate load.
+ *
+ * Capture streams the savestate through a sink instead of serializing it
+ * into a buffer first. Each 512-byte chunk of the stream is hashed while it
+ * is still in SRAM; only chunks whose hash changed since the last capture
+ * are compared against the key in PSRAM. Most of M68K_RAM and VRAM is idle
+ * from one snapshot to the next, so a capture typically reads a few KB of
+ * PSRAM rather than the whole ~150 KB key.
+ *
+ * Delta encoding is word-wide: a token (zero words << 16 | literal words)
+ * followed by the literal XOR words. Trailing zeros need no token.
+ */
+#include "rewind.h"
+#include "gwenesis_savestate.h"
+#include "psram_allocator.h"
+#include "pico/stdlib.h"
+#include "nespad/nespad.h"
+#include "input_poll.h"
+#include <string.h>
+#include <stdio.h>
+
+// Simple logging (conditional on ENABLE_LOGGING)
+#if ENABLE_LOGGING
+#define LOG(fmt, ...) printf(fmt, ##__VA_ARGS__)
+#else
+#define LOG(fmt, ...) do {} while(0)
+#endif
+
+// Stream chunk hashed as a unit (words) and number of chunk hashes kept in SRAM
+#define REWIND_CHUNK_WORDS 128
+#define REWIND_MAX_CHUNKS 512
+
+#define TOKEN_MAX_RUN 0xFFFFu
+
+typedef struct {
+    uint32_t offset;    // Delta start in ring (words)
+    uint32_t size;      // Delta length (words)
+} rewind_entry_t;
+
+static uint32_t *key_state = NULL;  // Newest snapshot (PSRAM)
+static uint32_t key_words = 0;      // 0 until the first capture
+static uint32_t *ring = NULL;       // Delta ring (PSRAM)
+static uint32_t ring_words = 0;
+static uint32_t ring_head = 0;      // Next delta start (words)
+
+static rewind_entry_t entries[REWIND_MAX_ENTRIES];
+static int entry_first = 0;
+static int entry_count = 0;
+
+// Hash of each stream chunk at the last capture; the key matches them while valid
+static uint32_t chunk_hash[REWIND_MAX_CHUNKS];
+static bool hash_valid = false;
+
+// Encoder state (valid during rewind_capture only)
+static uint32_t enc_pos;            // Stream position (words)
+static uint32_t enc_chunk;          // Chunk index in emit order
+static uint32_t *enc_out;
+static uint32_t *enc_end;
+static uint32_t *enc_token;         // Token of the literal run in progress
+static uint32_t enc_token_zeros;
+static uint32_t enc_literals;
+static uint32_t enc_zeros;          // Zero words not yet covered by a token
+static bool enc_failed;
+
+static rewind_stats_t stats;
+
+static inline uint32_t load_word(const uint8_t *p) {
+    uint32_t w;
+    memcpy(&w, p, sizeof(w));  // Tag payloads are not always word aligned
+    return w;
+}
+
+static inline void enc_close_run(void) {
+    if (enc_token) {
+        *enc_token = (enc_token_zeros << 16) | enc_literals;
+        enc_token = NULL;
+    }
+}
+
+static inline void enc_skip(uint32_t words) {
+    enc_close_run();
+    enc_zeros += words;
+}
+
+static inline void enc_literal(uint32_t x) {
+    if (enc_token == NULL || enc_literals == TOKEN_MAX_RUN) {
+        enc_close_run();
+        // Zero runs longer than a token field become literal-free tokens
+        while (enc_zeros > TOKEN_MAX_RUN && enc_out < enc_end) {
+            *enc_out++ = TOKEN_MAX_RUN << 16;
+            enc_zeros -= TOKEN_MAX_RUN;
+        }
+        if (enc_out + 2 > enc_end) {
+            enc_failed = true;
+            return;
+        }
+        enc_token = enc_out++;
+        enc_token_zeros = enc_zeros;
+        enc_literals = 0;
+        enc_zeros = 0;
+    } else if (enc_out >= enc_end) {
+        enc_failed = true;
+        return;
+    }
+    *enc_out++ = x;
+    enc_literals++;
+}
+
+static void __not_in_flash_func(rewind_sink)(uint32_t offset, const void *data, uint32_t length) {
+    uint32_t pos = offset >> 2;
+    uint32_t words = length >> 2;
+    const uint8_t *src = (const uint8_t *)data;
+
+    if (enc_failed) return;
+    if (pos + words > key_words) {
+        enc_failed = true;  // State layout grew: start a new key
+        return;
+    }
+
+    // Section/file headers are emitted after their payload, over space the
+    // stream already skipped. They only change with the layout.
+    if (pos < enc_pos) {
+        for (uint32_t i = 0; i < words; i++) {
+            if (load_word(src + i * 4) != key_state[pos + i]) enc_failed = true;
+        }
+        return;
+    }
+    if (pos > enc_pos) {
+        enc_skip(pos - enc_pos);
+        enc_pos = pos;
+    }
+
+    while (words) {
+        uint32_t n = words < REWIND_CHUNK_WORDS ? words : REWIND_CHUNK_WORDS;
+
+        // Rotate keeps high bits flowing into the low ones (a plain multiply never does)
+        uint32_t h = 0x811C9DC5u;
+        for (uint32_t i = 0; i < n; i++) {
+            h = (((h << 5) | (h >> 27)) ^ load_word(src + i * 4)) * 0x9E3779B1u;
+        }
+
+        uint32_t chunk = enc_chunk++;
+        if (hash_valid && chunk < REWIND_MAX_CHUNKS && chunk_hash[chunk] == h) {
+            enc_skip(n);
+        } else {
+            if (chunk < REWIND_MAX_CHUNKS) chunk_hash[chunk] = h;
+            uint32_t *key = key_state + enc_pos;
+            for (uint32_t i = 0; i < n; i++) {
+                uint32_t w = load_word(src + i * 4);
+                uint32_t x = w ^ key[i];
+                if (x) {
+                    key[i] = w;
+                    enc_literal(x);
+                } else {
+                    enc_skip(1);
+                }
+            }
+        }
+
+        enc_pos += n;
+        src += n * 4;
+        words -= n;
+    }
+}
+
+bool rewind_init(uint32_t budget_kb) {
+    if (budget_kb == 0) return false;
+
+    key_state = (uint32_t *)psram_malloc(GWENESIS_SAVESTATE_MAX_SIZE);
+    ring = (uint32_t *)psram_malloc(budget_kb * 1024);
+    if (key_state == NULL || ring == NULL) {
+        LOG("Rewind: failed to allocate %lu KB, disabled\n", (unsigned long)budget_kb);
+        ring = NULL;
+        return false;
+    }
+    ring_words = budget_kb * 1024 / sizeof(uint32_t);
+
+    rewind_reset();
+    LOG("Rewind: %lu KB ring, snapshot every %d frames\n", (unsigned long)budget_kb, REWIND_INTERVAL);
+    return true;
+}
+
+void rewind_reset(void) {
+    key_words = 0;
+    ring_head = 0;
+    entry_first = 0;
+    entry_count = 0;
+    hash_valid = false;
+}
+
+bool rewind_enabled(void) {
+    return ring != NULL;
+}
+
+static void rewind_evict_oldest(void) {
+    entry_first = (entry_first + 1) % REWIND_MAX_ENTRIES;
+    entry_count--;
+}
+
+void rewind_capture(void) {
+    if (ring == NULL) return;
+
+    uint64_t start_us = time_us_64();
+
+    if (key_words == 0) {
+        // First snapshot: plain serialization into the key
+        int size = saveGwenesisState((unsigned char *)key_state, GWENESIS_SAVESTATE_MAX_SIZE);
+        key_words = (uint32_t)size / sizeof(uint32_t);
+        hash_valid = false;
+    } else {
+        // Room for a delta as large as the state; anything bigger restarts the chain
+        uint32_t need = key_words + key_words / 4 + 2;
+        if (need > ring_words / 2) need = ring_words / 2;
+        if (ring_head + need > ring_words) {
+            // Wrap: whatever lies past the head is older than everything below it
+            while (entry_count > 0 && entries[entry_first].offset >= ring_head) {
+                rewind_evict_oldest();
+            }
+            ring_head = 0;
+        }
+
+        // Circular log: the oldest entries sit right after the head
+        while (entry_count > 0) {
+            rewind_entry_t *oldest = &entries[entry_first];
+            bool overlaps = oldest->offset < ring_head + need &&
+                            oldest->offset + oldest->size > ring_head;
+            if (!overlaps && entry_count < REWIND_MAX_ENTRIES) break;
+            rewind_evict_oldest();
+        }
+
+        enc_pos = 0;
+        enc_chunk = 0;
+        enc_out = ring + ring_head;
+        enc_end = enc_out + need;
+        enc_token = NULL;
+        enc_zeros = 0;
+        enc_failed = false;
+
+        int size = saveGwenesisStateToSink(rewind_sink, GWENESIS_SAVESTATE_MAX_SIZE);
+        enc_close_run();
+
+        if (enc_failed || (uint32_t)size != key_words * sizeof(uint32_t)) {
+            // Key is half updated: drop the chain and re-key next time
+            LOG("Rewind: delta overflow, ring reset\n");
+            rewind_reset();
+            return;
+        }
+
+        int slot = (entry_first + entry_count) % REWIND_MAX_ENTRIES;
+        entries[slot].offset = ring_head;
+        entries[slot].size = (uint32_t)(enc_out - (ring + ring_head));
+        entry_count++;
+        ring_head += entries[slot].size;
+        hash_valid = true;
+
+        stats.delta_bytes += entries[slot].size * sizeof(uint32_t);
+    }
+
+    uint32_t elapsed = (uint32_t)(time_us_64() - start_us);
+    stats.captures++;
+    stats.capture_us += elapsed;
+    if (elapsed > stats.max_capture_us) stats.max_capture_us = elapsed;
+}
+
+bool rewind_step(void) {
+    if (ring == NULL || entry_count == 0) return false;
+
+    int slot = (entry_first + entry_count - 1) % REWIND_MAX_ENTRIES;
+    const uint32_t *src = ring + entries[slot].offset;
+    const uint32_t *end = src + entries[slot].size;
+    uint32_t *key = key_state;
+
+    while (src < end) {
+        uint32_t token = *src++;
+        key += token >> 16;
+        for (uint32_t n = token & TOKEN_MAX_RUN; n; n--) {
+            *key++ ^= *src++;
+        }
+    }
+
+    // Newest delta is consumed: reuse its space, hashes no longer match the key
+    ring_head = entries[slot].offset;
+    entry_count--;
+    hash_valid = false;
+
+    return loadGwenesisState((unsigned char *)key_state) != 0;
+}
+
+bool rewind_hotkey_held(void) {
+    bool held = (nespad_state & DPAD_SELECT) && (nespad_state & DPAD_UP) &&
+                !(nespad_state & DPAD_START);
+
+#ifdef USB_HID_ENABLED
+    uint32_t input_word = input_poll_read();
+    if (input_word & INPUT_WORD_GP_CONNECTED) {
+        uint8_t gp_buttons = INPUT_WORD_GP(input_word);
+        // Select=0x80, Start=0x40, dpad bit 0 = up
+        if ((gp_buttons & 0x80) && !(gp_buttons & 0x40) && (INPUT_WORD_DPAD(input_word) & 0x01)) held = true;
+    }
+#endif
+
+    return held;
+}
+
+void rewind_get_stats(rewind_stats_t *out) {
+    stats.depth = entry_count;
+    *out = stats;
+    memset(&stats, 0, sizeof(stats));
+}
@@ -0,0 +1,66 @@
+/*
+ * Rewind - delta-compressed snapshot ring in PSRAM
+ * Every REWIND_INTERVAL frames the machine state is captured as a word-wide
+ * XOR delta against the previous snapshot; holding the rewind hotkey walks
+ * the ring backwards one snapshot per frame.
+ */
+#ifndef REWIND_H
+#define REWIND_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Frames between snapshots (rewind plays back at this many times real speed)
+#ifndef REWIND_INTERVAL
+#define REWIND_INTERVAL 4
+#endif
+
+// Maximum snapshots kept, whatever the memory budget allows
+#ifndef REWIND_MAX_ENTRIES
+#define REWIND_MAX_ENTRIES 256
+#endif
+
+typedef struct {
+    uint32_t captures;      // Snapshots taken since last reset
+    uint64_t capture_us;    // Time spent capturing since last reset
+    uint32_t max_capture_us;
+    uint64_t delta_bytes;   // Compressed bytes written since last reset
+    int depth;              // Snapshots currently in the ring
+} rewind_stats_t;
+
+/**
+ * Allocate the key snapshot and a ring of budget_kb in PSRAM
+ * @param budget_kb Ring size in KB, 0 disables rewind
+ * @return true if rewind is available
+ */
+bool rewind_init(uint32_t budget_kb);
+
+/**
+ * Drop all snapshots (e.g. after loading a savestate)
+ */
+void rewind_reset(void);
+
+/**
+ * Capture the current state into the ring (core 0, between frames)
+ */
+void rewind_capture(void);
+
+/**
+ * Restore the newest snapshot and drop it from the ring
+ * @return true if a snapshot was restored
+ */
+bool rewind_step(void);
+
+bool rewind_enabled(void);
+
+/**
+ * Rewind hotkey: Select+Up held on a gamepad (level triggered)
+ */
+bool rewind_hotkey_held(void);
+
+/**
+ * Read and clear the capture statistics (profiler)
+ */
+void rewind_get_stats(rewind_stats_t *stats);
+
+#endif // REWIND_H
@@ -368,8 +368,14 @@ static void draw_info_text(uint8_t *screen) {
     uint32_t sys_hz = clock_get_hz(clk_sys);
     uint32_t cpu_mhz = (sys_hz + 500000) / 1000000;
 
-    // PSRAM clock: show the configured max frequency from settings
+    // PSRAM clock: show the configured max frequency from settings, or the
+    // calibrated SCK in auto mode
     uint32_t psram_mhz = g_settings.psram_freq;
+    if (psram_mhz == PSRAM_FREQ_AUTO) {
+        psram_timing_t timing;
+        psram_get_timing(&timing);
+        psram_mhz = (sys_hz / timing.clkdiv + 500000) / 1000000;
+    }
 
     snprintf(info_str, sizeof(info_str), "V%s %s %u MHZ/%u MHZ", MURMGENESIS_VERSION, board_str, cpu_mhz, psram_mhz);
 
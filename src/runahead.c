@@ -0,0 +1,190 @@
+/*
+ * Run-ahead Implementation
+ *
+ * The 68K RAM, VRAM and Z80 RAM make up almost all of the machine state
+ * and are written from dozens of inline assembly fast paths, so instead of
+ * hooking every store they are tracked as 256-byte pages with a 64-bit
+ * content hash kept in SRAM. Snapshot copies only pages whose hash moved
+ * since the backup was last in sync; restore copies back only pages the
+ * speculative frames touched. Hashing 136 KB of SRAM is far cheaper than
+ * moving it through PSRAM.
+ *
+ * Cartridge save memory, when present, is tracked the same way.
+ *
+ * Everything else (CPU cores, sound chips, VDP registers/CRAM) goes
+ * through the regular savestate code with the tracked arrays excluded.
+ */
+#include "runahead.h"
+#include "gwenesis_savestate.h"
+#include "gwenesis_bus.h"
+#include "gwenesis_sram.h"
+#include "gwenesis_vdp.h"
+#include "psram_allocator.h"
+#include "psram_stream.h"
+#include "pico/stdlib.h"
+#include "HDMI.h"
+#include <string.h>
+#include <stdio.h>
+
+// Simple logging (conditional on ENABLE_LOGGING)
+#if ENABLE_LOGGING
+#define LOG(fmt, ...) printf(fmt, ##__VA_ARGS__)
+#else
+#define LOG(fmt, ...) do {} while(0)
+#endif
+
+// Serialized size of everything but the tracked arrays (~20 KB today)
+#ifndef RUNAHEAD_STATE_SIZE
+#define RUNAHEAD_STATE_SIZE (48 * 1024)
+#endif
+
+#define PAGE_SIZE 256
+#define PAGE_WORDS (PAGE_SIZE / 4)
+
+extern unsigned char M68K_RAM[];
+extern unsigned char ZRAM[];
+extern unsigned char VRAM[];
+
+typedef struct {
+    unsigned char *live;
+    uint32_t size;
+    unsigned char *backup;  // PSRAM copy
+    uint32_t first_page;    // Index into page_hash
+} runahead_region_t;
+
+// Last entry is the cartridge save memory (filled in by runahead_init)
+#define REGION_SRAM 3
+static runahead_region_t regions[] = {
+    { M68K_RAM, MAX_RAM_SIZE,     NULL, 0 },
+    { VRAM,     VRAM_MAX_SIZE,    NULL, 0 },
+    { ZRAM,     MAX_Z80_RAM_SIZE, NULL, 0 },
+    { NULL,     0,                NULL, 0 },
+};
+#define MAX_REGIONS (sizeof(regions) / sizeof(regions[0]))
+#define TOTAL_PAGES ((MAX_RAM_SIZE + VRAM_MAX_SIZE + MAX_Z80_RAM_SIZE + GWENESIS_SRAM_MAX_SIZE) / PAGE_SIZE)
+
+static unsigned region_count = REGION_SRAM;
+static const void *excluded[MAX_REGIONS] = { M68K_RAM, VRAM, ZRAM, NULL };
+
+// Hash of each backup page; live pages with the same hash are in sync
+static uint64_t page_hash[TOTAL_PAGES];
+static bool backup_valid = false;
+
+static unsigned char *state_buffer = NULL;
+static bool init_done = false;
+
+static runahead_stats_t stats;
+
+// Two independent lanes: a missed dirty page would silently corrupt the game
+static inline uint64_t __not_in_flash_func(hash_page)(const unsigned char *p) {
+    uint32_t a = 0x811C9DC5u, b = 0x01000193u;
+    for (int i = 0; i < PAGE_WORDS; i++) {
+        uint32_t w;
+        memcpy(&w, p + i * 4, sizeof(w));
+        a = (((a << 5) | (a >> 27)) ^ w) * 0x9E3779B1u;
+        b = (((b << 13) | (b >> 19)) + w) * 0x85EBCA77u;
+    }
+    return ((uint64_t)a << 32) | b;
+}
+
+bool runahead_init(void) {
+    if (init_done) return state_buffer != NULL;
+    init_done = true;
+
+    // Save memory is allocated in whole pages
+    if (gwenesis_sram_data() != NULL) {
+        regions[REGION_SRAM].live = gwenesis_sram_data();
+        regions[REGION_SRAM].size = (gwenesis_sram_size() + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+        excluded[REGION_SRAM] = gwenesis_sram_data();
+        region_count = REGION_SRAM + 1;
+    }
+
+    state_buffer = (unsigned char *)psram_malloc(RUNAHEAD_STATE_SIZE);
+    uint32_t page = 0;
+    for (unsigned i = 0; i < region_count && state_buffer; i++) {
+        regions[i].backup = (unsigned char *)psram_malloc(regions[i].size);
+        regions[i].first_page = page;
+        page += regions[i].size / PAGE_SIZE;
+        if (regions[i].backup == NULL) state_buffer = NULL;
+    }
+
+    if (state_buffer == NULL) {
+        LOG("Run-ahead: PSRAM allocation failed, disabled\n");
+        return false;
+    }
+    backup_valid = false;
+    return true;
+}
+
+bool runahead_snapshot(void) {
+    if (state_buffer == NULL) return false;
+
+    uint64_t start_us = time_us_64();
+
+    saveGwenesisStateSetExclusions(excluded, region_count);
+    int size = saveGwenesisState(state_buffer, RUNAHEAD_STATE_SIZE);
+    saveGwenesisStateSetExclusions(NULL, 0);
+    if (size == 0) return false;
+
+    for (unsigned r = 0; r < region_count; r++) {
+        runahead_region_t *region = &regions[r];
+        uint64_t *hash = &page_hash[region->first_page];
+        for (uint32_t off = 0, i = 0; off < region->size; off += PAGE_SIZE, i++) {
+            uint64_t h = hash_page(region->live + off);
+            if (!backup_valid || h != hash[i]) {
+                psram_stream_copy(region->backup + off, region->live + off, PAGE_SIZE);
+                hash[i] = h;
+                stats.pages_saved++;
+            }
+        }
+    }
+    backup_valid = true;
+
+    stats.snapshots++;
+    stats.snapshot_us += time_us_64() - start_us;
+    return true;
+}
+
+void runahead_restore(void) {
+    uint64_t start_us = time_us_64();
+
+    // Loading re-pushes the snapshot's CRAM to HDMI, but the frame on
+    // screen is the speculative one: keep its colors
+    uint32_t palette[64];
+    for (int i = 0; i < 64; i++) {
+        palette[i] = graphics_get_palette(i);
+    }
+
+    bool sram_restored = false;
+    saveGwenesisStateSetExclusions(excluded, region_count);
+    loadGwenesisState(state_buffer);
+    saveGwenesisStateSetExclusions(NULL, 0);
+
+    for (unsigned r = 0; r < region_count; r++) {
+        runahead_region_t *region = &regions[r];
+        const uint64_t *hash = &page_hash[region->first_page];
+        for (uint32_t off = 0, i = 0; off < region->size; off += PAGE_SIZE, i++) {
+            if (hash_page(region->live + off) != hash[i]) {
+                psram_stream_copy(region->live + off, region->backup + off, PAGE_SIZE);
+                stats.pages_restored++;
+                sram_restored |= (r == REGION_SRAM);
+            }
+        }
+    }
+
+    // The speculative frames wrote save memory: refresh its ROM_DATA mirror
+    if (sram_restored) {
+        gwenesis_sram_resync();
+    }
+
+    for (int i = 0; i < 64; i++) {
+        graphics_set_palette(i, palette[i]);
+    }
+
+    stats.restore_us += time_us_64() - start_us;
+}
+
+void runahead_get_stats(runahead_stats_t *out) {
+    *out = stats;
+    memset(&stats, 0, sizeof(stats));
+}
@@ -0,0 +1,48 @@
+/*
+ * Run-ahead - hide the game's internal input lag
+ * After each real frame the machine is snapshotted in memory, the next
+ * frame(s) are emulated with the same input and only the last one is
+ * shown, then the snapshot is restored.
+ */
+#ifndef RUNAHEAD_H
+#define RUNAHEAD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Maximum frames emulated ahead (menu offers OFF..RUNAHEAD_MAX_FRAMES)
+#ifndef RUNAHEAD_MAX_FRAMES
+#define RUNAHEAD_MAX_FRAMES 2
+#endif
+
+typedef struct {
+    uint64_t snapshot_us;     // Time spent saving state since last reset
+    uint64_t restore_us;      // Time spent restoring state since last reset
+    uint32_t pages_saved;     // Dirty pages copied to the backup
+    uint32_t pages_restored;  // Dirty pages copied back
+    uint32_t snapshots;
+} runahead_stats_t;
+
+/**
+ * Allocate the snapshot buffers in PSRAM (first call only)
+ * @return true if run-ahead is available
+ */
+bool runahead_init(void);
+
+/**
+ * Snapshot the machine before the speculative frames (core 0, between frames)
+ * @return false if the state could not be saved (skip run-ahead this frame)
+ */
+bool runahead_snapshot(void);
+
+/**
+ * Return to the snapshot, keeping the palette of the frame on screen
+ */
+void runahead_restore(void);
+
+/**
+ * Read and clear the statistics (profiler)
+ */
+void runahead_get_stats(runahead_stats_t *stats);
+
+#endif // RUNAHEAD_H
@@ -25,12 +25,16 @@ __license__ = "GPLv3"
 #include "m68k.h"
 #include "gwenesis_io.h"
 #include "gwenesis_bus.h"
+#include "gwenesis_sram.h"
 #include "gwenesis_vdp.h"
 #include "z80inst.h"
 #include "ym2612.h"
 #include "gwenesis_sn76489.h"
 
 #include "gwenesis_savestate.h"
+#include "ff.h"
+#include "psram_allocator.h"
+#include "psram_stream.h"
 
 #include <assert.h>
 
@@ -38,6 +42,7 @@ void gwenesis_save_state() {
   gwenesis_m68k_save_state();
   gwenesis_io_save_state();
   gwenesis_bus_save_state();
+  gwenesis_sram_save_state();
   gwenesis_vdp_gfx_save_state();
   gwenesis_vdp_mem_save_state();
   gwenesis_z80inst_save_state();
@@ -50,6 +55,7 @@ void gwenesis_load_state() {
   gwenesis_m68k_load_state();
   gwenesis_io_load_state();
   gwenesis_bus_load_state();
+  gwenesis_sram_load_state();
   gwenesis_vdp_gfx_load_state();
   gwenesis_vdp_mem_load_state();
   gwenesis_z80inst_load_state();
@@ -57,3 +63,383 @@ void gwenesis_load_state() {
   gwenesis_sn76489_load_state();
 
 }
+
+/******************************************************************************
+ *
+ *  SaveState backend
+ *
+ *  A savestate is built in a single staging buffer (PSRAM) and moved to or
+ *  from the SD card in one contiguous transfer. Layout, 4-byte aligned:
+ *
+ *    header  : magic 'GWSS', version, total size, section count
+ *    section : name, payload size, tag count
+ *      tag   : name, length, raw payload (padded to 4 bytes)
+ *
+ *  Sections are the names passed to saveGwenesisStateOpenForWrite() by each
+ *  subsystem, tags are the per-variable names used by Set/SetBuffer.
+ *
+ ******************************************************************************/
+
+#define SAVESTATE_MAGIC    0x53535747u  /* 'GWSS' */
+#define SAVESTATE_VERSION  1u
+#define SAVESTATE_NAME_LEN 24
+
+#define SAVESTATE_ALIGN(n) (((n) + 3u) & ~3u)
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t size;
+  uint32_t sections;
+} savestate_header_t;
+
+typedef struct {
+  char name[SAVESTATE_NAME_LEN];
+  uint32_t size;
+  uint32_t tags;
+} savestate_section_t;
+
+typedef struct {
+  char name[SAVESTATE_NAME_LEN];
+  uint32_t length;
+} savestate_tag_t;
+
+struct SaveState {
+  savestate_section_t *section;
+};
+
+static unsigned char *ss_buffer = NULL;
+static uint32_t ss_capacity = 0;
+static uint32_t ss_offset = 0;
+static bool ss_overflow = false;
+static SaveState ss_state;
+
+/* Write side: every byte goes through savestate_emit() so the same stream
+ * can land in a buffer or in a sink (rewind delta encoder). Sections are
+ * tracked here and their header emitted once the section is complete. */
+static gwenesis_savestate_sink_t ss_sink = NULL;
+static savestate_section_t ss_section;
+static uint32_t ss_section_offset = 0;
+static bool ss_section_open = false;
+static uint32_t ss_section_count = 0;
+
+/* Buffers left out of both save and load (run-ahead keeps them page by page) */
+#define SAVESTATE_MAX_EXCLUSIONS 4
+static const void *ss_exclusions[SAVESTATE_MAX_EXCLUSIONS];
+static int ss_exclusion_count = 0;
+
+static unsigned char *ss_staging = NULL;
+
+static void savestate_set_name(char *dst, const char *name) {
+  memset(dst, 0, SAVESTATE_NAME_LEN);
+  strncpy(dst, name, SAVESTATE_NAME_LEN - 1);
+}
+
+static bool savestate_excluded(const void *buffer) {
+  for (int i = 0; i < ss_exclusion_count; i++) {
+    if (ss_exclusions[i] == buffer)
+      return true;
+  }
+  return false;
+}
+
+void saveGwenesisStateSetExclusions(const void *const *buffers, int count) {
+  if (count > SAVESTATE_MAX_EXCLUSIONS)
+    count = SAVESTATE_MAX_EXCLUSIONS;
+  for (int i = 0; i < count; i++)
+    ss_exclusions[i] = buffers[i];
+  ss_exclusion_count = count;
+}
+
+static bool savestate_reserve(uint32_t size, uint32_t *offset) {
+  size = SAVESTATE_ALIGN(size);
+  if (ss_overflow || ss_offset + size > ss_capacity) {
+    ss_overflow = true;
+    return false;
+  }
+  *offset = ss_offset;
+  ss_offset += size;
+  return true;
+}
+
+/* length is always a multiple of 4 */
+static void savestate_emit(uint32_t offset, const void *data, uint32_t length) {
+  if (ss_sink)
+    ss_sink(offset, data, length);
+  else
+    psram_stream_copy(ss_buffer + offset, data, length);
+}
+
+static void savestate_close_section(void) {
+  if (!ss_section_open)
+    return;
+  savestate_emit(ss_section_offset, &ss_section, sizeof(ss_section));
+  ss_section_open = false;
+}
+
+SaveState* saveGwenesisStateOpenForWrite(const char* fileName) {
+  savestate_close_section();
+
+  ss_state.section = NULL;
+  if (!savestate_reserve(sizeof(savestate_section_t), &ss_section_offset))
+    return &ss_state;
+
+  savestate_set_name(ss_section.name, fileName);
+  ss_section.size = 0;
+  ss_section.tags = 0;
+  ss_section_open = true;
+  ss_section_count++;
+  ss_state.section = &ss_section;
+  return &ss_state;
+}
+
+void saveGwenesisStateSetBuffer(SaveState* state, const char* tagName, void* buffer, int length) {
+  if (state->section == NULL || savestate_excluded(buffer))
+    return;
+
+  uint32_t size = sizeof(savestate_tag_t) + SAVESTATE_ALIGN((uint32_t)length);
+  uint32_t offset;
+  if (!savestate_reserve(size, &offset))
+    return;
+
+  savestate_tag_t tag;
+  savestate_set_name(tag.name, tagName);
+  tag.length = (uint32_t)length;
+  savestate_emit(offset, &tag, sizeof(tag));
+  offset += sizeof(tag);
+
+  /* Whole words straight from the source, the tail word zero padded */
+  uint32_t body = (uint32_t)length & ~3u;
+  if (body)
+    savestate_emit(offset, buffer, body);
+  if (body != (uint32_t)length) {
+    uint32_t tail = 0;
+    memcpy(&tail, (const unsigned char *)buffer + body, (uint32_t)length - body);
+    savestate_emit(offset + body, &tail, sizeof(tail));
+  }
+
+  state->section->size += size;
+  state->section->tags++;
+}
+
+void saveGwenesisStateSet(SaveState* state, const char* tagName, int value) {
+  saveGwenesisStateSetBuffer(state, tagName, &value, sizeof(value));
+}
+
+SaveState* saveGwenesisStateOpenForRead(const char* fileName) {
+  const savestate_header_t *header = (const savestate_header_t *)ss_buffer;
+  uint32_t offset = sizeof(savestate_header_t);
+
+  ss_state.section = NULL;
+  for (uint32_t i = 0; i < header->sections; i++) {
+    savestate_section_t *section = (savestate_section_t *)(ss_buffer + offset);
+    if (strncmp(section->name, fileName, SAVESTATE_NAME_LEN) == 0) {
+      ss_state.section = section;
+      break;
+    }
+    offset += sizeof(savestate_section_t) + section->size;
+  }
+
+  if (ss_state.section == NULL)
+    printf("savestate: missing section %s\n", fileName);
+  return &ss_state;
+}
+
+static savestate_tag_t *savestate_find_tag(SaveState* state, const char* tagName) {
+  if (state->section == NULL)
+    return NULL;
+
+  unsigned char *ptr = (unsigned char *)(state->section + 1);
+  for (uint32_t i = 0; i < state->section->tags; i++) {
+    savestate_tag_t *tag = (savestate_tag_t *)ptr;
+    if (strncmp(tag->name, tagName, SAVESTATE_NAME_LEN) == 0)
+      return tag;
+    ptr += sizeof(savestate_tag_t) + SAVESTATE_ALIGN(tag->length);
+  }
+
+  printf("savestate: missing tag %s.%s\n", state->section->name, tagName);
+  return NULL;
+}
+
+bool saveGwenesisStateGetBuffer(SaveState* state, const char* tagName, void* buffer, int length) {
+  if (savestate_excluded(buffer))
+    return false;
+
+  savestate_tag_t *tag = savestate_find_tag(state, tagName);
+  if (tag == NULL)
+    return false;
+
+  /* Copy what both sides agree on; a size mismatch leaves the tail untouched */
+  uint32_t copy = tag->length < (uint32_t)length ? tag->length : (uint32_t)length;
+  psram_stream_copy(buffer, tag + 1, copy);
+  return true;
+}
+
+int saveGwenesisStateGet(SaveState* state, const char* tagName) {
+  int value = 0;
+  saveGwenesisStateGetBuffer(state, tagName, &value, sizeof(value));
+  return value;
+}
+
+static int savestate_write(int save_size) {
+  ss_capacity = (uint32_t)save_size;
+  ss_offset = 0;
+  ss_overflow = false;
+  ss_section_open = false;
+  ss_section_count = 0;
+
+  uint32_t header_offset;
+  if (!savestate_reserve(sizeof(savestate_header_t), &header_offset))
+    return 0;
+
+  gwenesis_save_state();
+  savestate_close_section();
+
+  if (ss_overflow) {
+    printf("savestate: buffer too small (%d bytes)\n", save_size);
+    return 0;
+  }
+
+  savestate_header_t header;
+  header.magic = SAVESTATE_MAGIC;
+  header.version = SAVESTATE_VERSION;
+  header.size = ss_offset;
+  header.sections = ss_section_count;
+  savestate_emit(header_offset, &header, sizeof(header));
+  return (int)ss_offset;
+}
+
+int saveGwenesisState(unsigned char *destBuffer, int save_size) {
+  ss_buffer = destBuffer;
+  ss_sink = NULL;
+  return savestate_write(save_size);
+}
+
+int saveGwenesisStateToSink(gwenesis_savestate_sink_t sink, int save_size) {
+  ss_buffer = NULL;
+  ss_sink = sink;
+  int size = savestate_write(save_size);
+  ss_sink = NULL;
+  return size;
+}
+
+/* Walk the whole stream once: the header, every section and every tag must
+ * lie inside its `size` bytes, so the readers above never leave the buffer.
+ * Files from the SD card may be truncated or corrupt. */
+bool gwenesis_savestate_check(const unsigned char *buffer, uint32_t size) {
+  const savestate_header_t *header = (const savestate_header_t *)buffer;
+  if (size < sizeof(savestate_header_t) || size > GWENESIS_SAVESTATE_MAX_SIZE || (size & 3u))
+    return false;
+  if (header->magic != SAVESTATE_MAGIC || header->version != SAVESTATE_VERSION ||
+      header->size != size)
+    return false;
+
+  uint32_t offset = sizeof(savestate_header_t);
+  for (uint32_t i = 0; i < header->sections; i++) {
+    if (size - offset < sizeof(savestate_section_t))
+      return false;
+    const savestate_section_t *section = (const savestate_section_t *)(buffer + offset);
+    offset += sizeof(savestate_section_t);
+    if (section->size > size - offset)
+      return false;
+
+    uint32_t end = offset + section->size;
+    for (uint32_t t = 0; t < section->tags; t++) {
+      if (end - offset < sizeof(savestate_tag_t))
+        return false;
+      const savestate_tag_t *tag = (const savestate_tag_t *)(buffer + offset);
+      offset += sizeof(savestate_tag_t);
+      /* Length first: aligning a huge length would wrap */
+      if (tag->length > end - offset || SAVESTATE_ALIGN(tag->length) > end - offset)
+        return false;
+      offset += SAVESTATE_ALIGN(tag->length);
+    }
+    if (offset != end)
+      return false;
+  }
+  return true;
+}
+
+bool initLoadGwenesisState(unsigned char *srcBuffer) {
+  const savestate_header_t *header = (const savestate_header_t *)srcBuffer;
+  if (!gwenesis_savestate_check(srcBuffer, header->size)) {
+    printf("savestate: corrupt state rejected\n");
+    return false;
+  }
+
+  ss_buffer = srcBuffer;
+  ss_capacity = header->size;
+  ss_offset = header->size;
+  ss_overflow = false;
+  return true;
+}
+
+int loadGwenesisState(unsigned char *srcBuffer) {
+  if (!initLoadGwenesisState(srcBuffer))
+    return 0;
+
+  gwenesis_load_state();
+  return (int)ss_capacity;
+}
+
+/******************************************************************************
+ *
+ *  SD card transfer
+ *  The whole staging buffer goes through a single f_write/f_read so FatFs
+ *  can stream full clusters straight to the card without sector copies.
+ *
+ ******************************************************************************/
+
+static unsigned char *savestate_get_staging(void) {
+  if (ss_staging == NULL)
+    ss_staging = (unsigned char *)psram_malloc(GWENESIS_SAVESTATE_MAX_SIZE);
+  return ss_staging;
+}
+
+bool gwenesis_savestate_save_file(const char *path) {
+  unsigned char *buffer = savestate_get_staging();
+  if (buffer == NULL)
+    return false;
+
+  int size = saveGwenesisState(buffer, GWENESIS_SAVESTATE_MAX_SIZE);
+  if (size == 0)
+    return false;
+
+  FIL file;
+  UINT bw = 0;
+  if (f_open(&file, path, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK)
+    return false;
+
+  FRESULT res = f_write(&file, buffer, (UINT)size, &bw);
+  f_close(&file);
+
+  return (res == FR_OK && bw == (UINT)size);
+}
+
+bool gwenesis_savestate_load_file(const char *path) {
+  unsigned char *buffer = savestate_get_staging();
+  if (buffer == NULL)
+    return false;
+
+  FIL file;
+  UINT br = 0;
+  if (f_open(&file, path, FA_READ) != FR_OK)
+    return false;
+
+  FSIZE_t size = f_size(&file);
+  if (size < sizeof(savestate_header_t) || size > GWENESIS_SAVESTATE_MAX_SIZE) {
+    f_close(&file);
+    return false;
+  }
+
+  FRESULT res = f_read(&file, buffer, (UINT)size, &br);
+  f_close(&file);
+  if (res != FR_OK || br != (UINT)size)
+    return false;
+
+  /* Reject truncated files before any subsystem state is touched */
+  if (!gwenesis_savestate_check(buffer, (uint32_t)size))
+    return false;
+
+  return loadGwenesisState(buffer) != 0;
+}
@@ -23,12 +23,28 @@ __license__ = "GPLv3"
 
 #include <stdio.h>
 #include <string.h>
+#include <stdint.h>
 #include <stdbool.h>
 
 typedef struct SaveState SaveState;
 
+/* Staging buffer size: 68K RAM + VRAM + ZRAM + cartridge save memory
+ * (up to 64 KB) + chip state + tag table */
+#define GWENESIS_SAVESTATE_MAX_SIZE (256 * 1024)
+
+/* Receives the serialized stream in emit order: offset and length are
+ * multiples of 4, offsets are not monotonic (headers are emitted last). */
+typedef void (*gwenesis_savestate_sink_t)(uint32_t offset, const void *data, uint32_t length);
+
+/* Returns false unless every section and tag of the stream fits in `size`
+ * bytes (loads check this before any subsystem state is touched) */
+bool gwenesis_savestate_check(const unsigned char *buffer, uint32_t size);
 bool initLoadGwenesisState(unsigned char *srcBuffer);
 int saveGwenesisState(unsigned char *destBuffer, int save_size);
+int saveGwenesisStateToSink(gwenesis_savestate_sink_t sink, int save_size);
+
+/* Leave these buffers out of the following saves and loads (count 0 clears) */
+void saveGwenesisStateSetExclusions(const void *const *buffers, int count);
 int loadGwenesisState(unsigned char *srcBuffer);
 
 SaveState* saveGwenesisStateOpenForRead(const char* fileName);
@@ -37,9 +53,13 @@ SaveState* saveGwenesisStateOpenForWrite(const char* fileName);
 int saveGwenesisStateGet(SaveState* state, const char* tagName);
 void saveGwenesisStateSet(SaveState* state, const char* tagName, int value);
 
-void saveGwenesisStateGetBuffer(SaveState* state, const char* tagName, void* buffer, int length);
+/* Returns false when the tag is missing or the buffer is excluded */
+bool saveGwenesisStateGetBuffer(SaveState* state, const char* tagName, void* buffer, int length);
 void saveGwenesisStateSetBuffer(SaveState* state, const char* tagName, void* buffer, int length);
 
 void gwenesis_save_state();
 void gwenesis_load_state();
-#endif
\ No newline at end of file
+
+bool gwenesis_savestate_save_file(const char *path);
+bool gwenesis_savestate_load_file(const char *path);
+#endif
@@ -12,6 +12,11 @@
 #include "nespad/nespad.h"
 #include "ps2kbd/ps2kbd_wrapper.h"
 #include "audio.h"
+#include "quicksave.h"
+#include "runahead.h"
+#include "perf_osd.h"
+#include "input_poll.h"
+#include "gwenesis_io.h"
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -28,7 +33,7 @@
 // Font constants (same as ROM selector)
 #define FONT_WIDTH 6    // 5px glyph + 1px spacing
 #define FONT_HEIGHT 7
-#define LINE_HEIGHT 10  // Compact spacing for settings
+#define LINE_HEIGHT 8   // Compact spacing for settings
 
 // UI layout
 #define MENU_TITLE_Y 20
@@ -55,7 +60,14 @@ typedef enum {
     MENU_CRT_DIM,
     MENU_FRAMESKIP,
     MENU_GAMEPAD2,
+    MENU_REWIND,
+    MENU_RUNAHEAD,
+    MENU_QUICK_SLOT,
+    MENU_PERF_OVERLAY,
     MENU_SEPARATOR,  // Visual separator
+    MENU_SAVE_STATE,
+    MENU_LOAD_STATE,
+    MENU_GAME_PROFILE,
     MENU_SAVE_RESTART,
     MENU_RESTART,
     MENU_CANCEL,
@@ -88,9 +100,42 @@ settings_t g_settings = {
     .audio_enabled = true,
     .channel_mask = 0x7F,  // All 7 channels enabled (bits 0-6)
     .frameskip = 3,  // Default: high (30fps)
-    .gamepad2_mode = GAMEPAD2_MODE_NES  // Default: NES gamepad 2
+    .gamepad2_mode = GAMEPAD2_MODE_NES,  // Default: NES gamepad 2
+    .rewind_kb = 0,  // Default: rewind off
+    .runahead = 0,  // Default: run-ahead off
+    .pad6 = true,  // Default: 6-button pads
+    .z80_slice_lines = Z80_SLICE_LINES
 };
 
+// Per-game settings file of the loaded ROM (empty until a ROM is loaded)
+static char game_settings_path[32] = "";
+
+// Knobs a game profile can override
+#define PROFILE_CPU_FREQ    (1u << 0)
+#define PROFILE_PSRAM_FREQ  (1u << 1)
+#define PROFILE_Z80         (1u << 2)
+#define PROFILE_AUDIO       (1u << 3)
+#define PROFILE_FM_SOUND    (1u << 4)
+#define PROFILE_CHANNELS    (1u << 5)
+#define PROFILE_FRAMESKIP   (1u << 6)
+#define PROFILE_Z80_SLICE   (1u << 7)
+#define PROFILE_ALL         0xFFu
+
+// settings.ini values, g_settings holds them with the game profile applied
+static settings_t global_settings;
+// PROFILE_* knobs set by the loaded game's profile
+static uint32_t game_overrides = 0;
+
+static bool settings_save_game_profile(const settings_t *settings);
+
+// Result of the last "save as game profile" shown in the menu
+enum {
+    PROFILE_STATUS_NONE,
+    PROFILE_STATUS_SAVED,
+    PROFILE_STATUS_FAILED
+};
+static uint8_t profile_status = PROFILE_STATUS_NONE;
+
 // Frameskip level names
 static const char* frameskip_names[] = {"NONE", "LOW", "MEDIUM", "HIGH", "EXTREME"};
 #define FRAMESKIP_MAX_LEVEL 4
@@ -99,15 +144,23 @@ static const char* frameskip_names[] = {"NONE", "LOW", "MEDIUM", "HIGH", "EXTREM
 static const char* gamepad2_mode_names[] = {"NES", "KEYBOARD", "USB", "DISABLED"};
 #define GAMEPAD2_MODE_MAX 3
 
+// Rewind ring budgets (KB of PSRAM, 0 = off)
+static const uint16_t rewind_kb_values[] = {0, 512, 1024, 2048};
+#define REWIND_KB_COUNT (sizeof(rewind_kb_values) / sizeof(rewind_kb_values[0]))
+
 // Local copy for editing
 static settings_t edit_settings;
 
+// CPU clocks with a calibrated PSRAM timing slot (settings_t.psram_timing)
+static const uint16_t psram_timing_clocks[] = {378, 504};
+#define PSRAM_TIMING_CLOCKS (int)(sizeof(psram_timing_clocks) / sizeof(psram_timing_clocks[0]))
+
 // CRT dim values
 static const uint8_t crt_dim_values[] = {10, 20, 30, 40, 50, 60, 70, 80, 90};
 #define CRT_DIM_COUNT (sizeof(crt_dim_values) / sizeof(crt_dim_values[0]))
 
 // 5x7 font glyphs (copied from rom_selector.c)
-static const uint8_t *glyph_5x7(char ch) {
+const uint8_t *settings_glyph_5x7(char ch) {
     static const uint8_t glyph_space[7] = {0, 0, 0, 0, 0, 0, 0};
     static const uint8_t glyph_dot[7] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C};
     static const uint8_t glyph_hyphen[7] = {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00};
@@ -215,7 +268,7 @@ static const uint8_t *glyph_5x7(char ch) {
 
 // Draw a single character
 static void draw_char(uint8_t *screen, int x, int y, char ch, uint8_t color) {
-    const uint8_t *rows = glyph_5x7(ch);
+    const uint8_t *rows = settings_glyph_5x7(ch);
     for (int row = 0; row < FONT_HEIGHT; ++row) {
         int yy = y + row;
         if (yy < 0 || yy >= SCREEN_HEIGHT) continue;
@@ -271,6 +324,14 @@ static int get_crt_dim_index(uint8_t dim) {
     return 5;  // Default to 60%
 }
 
+// Get index of current rewind budget
+static int get_rewind_index(uint16_t kb) {
+    for (int i = 0; i < (int)REWIND_KB_COUNT; i++) {
+        if (rewind_kb_values[i] == kb) return i;
+    }
+    return 0;  // Default to off
+}
+
 // Get menu item label
 static const char* get_menu_label(menu_item_t item) {
     switch (item) {
@@ -284,7 +345,14 @@ static const char* get_menu_label(menu_item_t item) {
         case MENU_CRT_DIM:      return "CRT DIM";
         case MENU_FRAMESKIP:    return "FRAMESKIP";
         case MENU_GAMEPAD2:     return "GAMEPAD 2";
+        case MENU_REWIND:       return "REWIND BUFFER";
+        case MENU_RUNAHEAD:     return "RUN-AHEAD (THIS GAME)";
+        case MENU_QUICK_SLOT:   return "QUICK SAVE SLOT";
+        case MENU_PERF_OVERLAY: return "PERF OVERLAY";
         case MENU_SEPARATOR:    return "";
+        case MENU_SAVE_STATE:   return "SAVE STATE";
+        case MENU_LOAD_STATE:   return "LOAD STATE";
+        case MENU_GAME_PROFILE: return "SAVE AS GAME PROFILE";
         case MENU_SAVE_RESTART: return "SAVE AND RESTART";
         case MENU_RESTART:      return "RESTART WITHOUT SAVING";
         case MENU_CANCEL:       return "CANCEL";
@@ -299,7 +367,11 @@ static void get_menu_value(menu_item_t item, char *buf, size_t size) {
             snprintf(buf, size, "< %d MHZ >", edit_settings.cpu_freq);
             break;
         case MENU_PSRAM_FREQ:
-            snprintf(buf, size, "< %d MHZ >", edit_settings.psram_freq);
+            if (edit_settings.psram_freq == PSRAM_FREQ_AUTO) {
+                snprintf(buf, size, "< AUTO >");
+            } else {
+                snprintf(buf, size, "< %d MHZ >", edit_settings.psram_freq);
+            }
             break;
         case MENU_Z80:
             snprintf(buf, size, "< %s >", edit_settings.z80_enabled ? "ENABLED" : "DISABLED");
@@ -334,6 +406,38 @@ static void get_menu_value(menu_item_t item, char *buf, size_t size) {
         case MENU_GAMEPAD2:
             snprintf(buf, size, "< %s >", gamepad2_mode_names[edit_settings.gamepad2_mode]);
             break;
+        case MENU_REWIND:
+            if (edit_settings.rewind_kb) {
+                snprintf(buf, size, "< %d KB >", edit_settings.rewind_kb);
+            } else {
+                snprintf(buf, size, "< OFF >");
+            }
+            break;
+        case MENU_RUNAHEAD:
+            if (edit_settings.runahead) {
+                snprintf(buf, size, "< %d FRAME%s >", edit_settings.runahead,
+                         edit_settings.runahead > 1 ? "S" : "");
+            } else {
+                snprintf(buf, size, "< OFF >");
+            }
+            break;
+        case MENU_QUICK_SLOT:
+            snprintf(buf, size, "< %d >", quicksave_get_slot() + 1);
+            break;
+        case MENU_PERF_OVERLAY:
+            snprintf(buf, size, "< %s >", perf_osd_enabled() ? "ON" : "OFF");
+            break;
+        case MENU_GAME_PROFILE:
+            if (profile_status == PROFILE_STATUS_SAVED) {
+                snprintf(buf, size, "SAVED");
+            } else if (profile_status == PROFILE_STATUS_FAILED) {
+                snprintf(buf, size, "FAILED");
+            } else if (game_overrides) {
+                snprintf(buf, size, "ACTIVE");
+            } else {
+                buf[0] = '\0';
+            }
+            break;
         default:
             buf[0] = '\0';
             break;
@@ -352,10 +456,15 @@ static void change_setting(menu_item_t item, int direction) {
             break;
             
         case MENU_PSRAM_FREQ:
-            if (direction < 0 && edit_settings.psram_freq == 166) {
+            // 133 MHz < 166 MHz < auto (calibrated)
+            if (direction < 0 && edit_settings.psram_freq == PSRAM_FREQ_AUTO) {
+                edit_settings.psram_freq = 166;
+            } else if (direction < 0 && edit_settings.psram_freq == 166) {
                 edit_settings.psram_freq = 133;
             } else if (direction > 0 && edit_settings.psram_freq == 133) {
                 edit_settings.psram_freq = 166;
+            } else if (direction > 0 && edit_settings.psram_freq == 166) {
+                edit_settings.psram_freq = PSRAM_FREQ_AUTO;
             }
             break;
             
@@ -408,6 +517,34 @@ static void change_setting(menu_item_t item, int direction) {
             }
             break;
             
+        case MENU_REWIND: {
+            int idx = get_rewind_index(edit_settings.rewind_kb);
+            if (direction < 0 && idx > 0) {
+                edit_settings.rewind_kb = rewind_kb_values[idx - 1];
+            } else if (direction > 0 && idx < (int)REWIND_KB_COUNT - 1) {
+                edit_settings.rewind_kb = rewind_kb_values[idx + 1];
+            }
+            break;
+        }
+            
+        case MENU_RUNAHEAD:
+            if (direction < 0 && edit_settings.runahead > 0) {
+                edit_settings.runahead--;
+            } else if (direction > 0 && edit_settings.runahead < RUNAHEAD_MAX_FRAMES) {
+                edit_settings.runahead++;
+            }
+            break;
+            
+        case MENU_QUICK_SLOT:
+            // Runtime only: takes effect immediately, not stored in settings.ini
+            quicksave_set_slot(quicksave_get_slot() + direction);
+            break;
+            
+        case MENU_PERF_OVERLAY:
+            // Runtime only, like the quick save slot (PERF_OSD=1 shows it from boot)
+            perf_osd_set_enabled(!perf_osd_enabled());
+            break;
+            
         default:
             break;
     }
@@ -419,6 +556,7 @@ static bool is_selectable(menu_item_t item) {
     if (item == MENU_CRT_DIM && !edit_settings.crt_effect) return false;
     if (item == MENU_FM_SOUND && !edit_settings.audio_enabled) return false;
     if (item == MENU_CHANNELS && !edit_settings.audio_enabled) return false;
+    if (item == MENU_GAME_PROFILE && game_settings_path[0] == '\0') return false;
     return true;
 }
 
@@ -752,10 +890,191 @@ static bool parse_ini_line(const char *line, const char *key, char *value, size_
     return true;
 }
 
+static bool ini_bool(const char *value) {
+    return strcasecmp(value, "on") == 0 || strcmp(value, "1") == 0;
+}
+
+// Parse one settings.ini line into s
+// @return PROFILE_* bit of the key if it may be overridden per game, else 0
+static uint32_t parse_setting_line(const char *line, settings_t *s) {
+    char value[64];
+    
+    if (parse_ini_line(line, "cpu_freq", value, sizeof(value))) {
+        int freq = atoi(value);
+        if (freq == 378 || freq == 504) {
+            s->cpu_freq = (uint16_t)freq;
+        }
+        return PROFILE_CPU_FREQ;
+    }
+    else if (parse_ini_line(line, "psram_freq", value, sizeof(value))) {
+        int freq = atoi(value);
+        if (freq == 133 || freq == 166) {
+            s->psram_freq = (uint16_t)freq;
+        } else if (strcasecmp(value, "auto") == 0) {
+            s->psram_freq = PSRAM_FREQ_AUTO;
+        }
+        return PROFILE_PSRAM_FREQ;
+    }
+
+    else if (parse_ini_line(line, "z80", value, sizeof(value))) {
+        s->z80_enabled = ini_bool(value);
+        return PROFILE_Z80;
+    }
+    else if (parse_ini_line(line, "z80_slice_lines", value, sizeof(value))) {
+        int lines = atoi(value);
+        if (lines >= 1 && lines <= Z80_SLICE_LINES_MAX) {
+            s->z80_slice_lines = (uint8_t)lines;
+        }
+        return PROFILE_Z80_SLICE;
+    }
+    else if (parse_ini_line(line, "audio", value, sizeof(value))) {
+        s->audio_enabled = ini_bool(value);
+        return PROFILE_AUDIO;
+    }
+    else if (parse_ini_line(line, "fm_sound", value, sizeof(value))) {
+        s->fm_sound = ini_bool(value);
+        return PROFILE_FM_SOUND;
+    }
+    else if (parse_ini_line(line, "crt_effect", value, sizeof(value))) {
+        s->crt_effect = ini_bool(value);
+    }
+    else if (parse_ini_line(line, "crt_dim", value, sizeof(value))) {
+        int dim = atoi(value);
+        if (dim >= 10 && dim <= 90) {
+            s->crt_dim = (uint8_t)dim;
+        }
+    }
+    else if (parse_ini_line(line, "channel_1", value, sizeof(value))) {
+        s->channel_mask = CHANNEL_SET(s->channel_mask, 0, ini_bool(value));
+        return PROFILE_CHANNELS;
+    }
+    else if (parse_ini_line(line, "channel_2", value, sizeof(value))) {
+        s->channel_mask = CHANNEL_SET(s->channel_mask, 1, ini_bool(value));
+        return PROFILE_CHANNELS;
+    }
+    else if (parse_ini_line(line, "channel_3", value, sizeof(value))) {
+        s->channel_mask = CHANNEL_SET(s->channel_mask, 2, ini_bool(value));
+        return PROFILE_CHANNELS;
+    }
+    else if (parse_ini_line(line, "channel_4", value, sizeof(value))) {
+        s->channel_mask = CHANNEL_SET(s->channel_mask, 3, ini_bool(value));
+        return PROFILE_CHANNELS;
+    }
+    else if (parse_ini_line(line, "channel_5", value, sizeof(value))) {
+        s->channel_mask = CHANNEL_SET(s->channel_mask, 4, ini_bool(value));
+        return PROFILE_CHANNELS;
+    }
+    else if (parse_ini_line(line, "channel_6", value, sizeof(value))) {
+        bool en = ini_bool(value);
+        s->channel_mask = CHANNEL_SET(s->channel_mask, 5, en);
+        s->dac_sound = en;  // Sync dac_sound
+        return PROFILE_CHANNELS;
+    }
+    else if (parse_ini_line(line, "psg", value, sizeof(value))) {
+        s->channel_mask = CHANNEL_SET(s->channel_mask, 6, ini_bool(value));
+        return PROFILE_CHANNELS;
+    }
+    else if (parse_ini_line(line, "frameskip", value, sizeof(value))) {
+        int level = atoi(value);
+        if (level >= 0 && level <= FRAMESKIP_MAX_LEVEL) {
+            s->frameskip = (uint8_t)level;
+        }
+        return PROFILE_FRAMESKIP;
+    }
+    else if (parse_ini_line(line, "gamepad2", value, sizeof(value))) {
+        if (strcasecmp(value, "nes") == 0 || strcmp(value, "0") == 0) {
+            s->gamepad2_mode = GAMEPAD2_MODE_NES;
+        } else if (strcasecmp(value, "keyboard") == 0 || strcmp(value, "1") == 0) {
+            s->gamepad2_mode = GAMEPAD2_MODE_KEYBOARD;
+        } else if (strcasecmp(value, "usb") == 0 || strcmp(value, "2") == 0) {
+            s->gamepad2_mode = GAMEPAD2_MODE_USB;
+        } else if (strcasecmp(value, "disabled") == 0 || strcmp(value, "3") == 0) {
+            s->gamepad2_mode = GAMEPAD2_MODE_DISABLED;
+        }
+    }
+    else if (parse_ini_line(line, "rewind_kb", value, sizeof(value))) {
+        int kb = atoi(value);
+        if (rewind_kb_values[get_rewind_index((uint16_t)kb)] == kb) {
+            s->rewind_kb = (uint16_t)kb;
+        }
+    }
+    else {
+        // psram_timing_<cpu MHz> = clkdiv,rxdelay,cooldown
+        for (int i = 0; i < PSRAM_TIMING_CLOCKS; i++) {
+            char key[20];
+            unsigned clkdiv, rxdelay, cooldown;
+            snprintf(key, sizeof(key), "psram_timing_%d", psram_timing_clocks[i]);
+            if (!parse_ini_line(line, key, value, sizeof(value))) continue;
+            if (sscanf(value, "%u,%u,%u", &clkdiv, &rxdelay, &cooldown) == 3 &&
+                clkdiv >= 2 && clkdiv <= 255 && rxdelay <= 7 && cooldown <= 3) {
+                s->psram_timing[i].clkdiv = (uint8_t)clkdiv;
+                s->psram_timing[i].rxdelay = (uint8_t)rxdelay;
+                s->psram_timing[i].cooldown = (uint8_t)cooldown;
+            }
+            break;
+        }
+    }
+    return 0;
+}
+
+// Copy the profile knobs selected by mask from src to dst
+static void apply_profile(settings_t *dst, const settings_t *src, uint32_t mask) {
+    if (mask & PROFILE_CPU_FREQ)   dst->cpu_freq = src->cpu_freq;
+    if (mask & PROFILE_PSRAM_FREQ) dst->psram_freq = src->psram_freq;
+    if (mask & PROFILE_Z80)        dst->z80_enabled = src->z80_enabled;
+    if (mask & PROFILE_Z80_SLICE)  dst->z80_slice_lines = src->z80_slice_lines;
+    if (mask & PROFILE_AUDIO)      dst->audio_enabled = src->audio_enabled;
+    if (mask & PROFILE_FM_SOUND)   dst->fm_sound = src->fm_sound;
+    if (mask & PROFILE_FRAMESKIP)  dst->frameskip = src->frameskip;
+    if (mask & PROFILE_CHANNELS) {
+        dst->channel_mask = src->channel_mask;
+        dst->dac_sound = src->dac_sound;
+    }
+}
+
+// Append the profile knobs selected by mask in INI format
+static size_t format_profile(char *buf, size_t size, const settings_t *s, uint32_t mask) {
+    size_t len = 0;
+    
+#define APPEND(...) do { \
+    int n = snprintf(buf + len, size - len, __VA_ARGS__); \
+    if (n > 0) len += ((size_t)n < size - len) ? (size_t)n : size - len - 1; \
+} while (0)
+    
+    if (mask & PROFILE_CPU_FREQ)   APPEND("cpu_freq = %d\n", s->cpu_freq);
+    if (mask & PROFILE_PSRAM_FREQ) {
+        if (s->psram_freq == PSRAM_FREQ_AUTO) APPEND("psram_freq = auto\n");
+        else APPEND("psram_freq = %d\n", s->psram_freq);
+    }
+    if (mask & PROFILE_Z80)        APPEND("z80 = %s\n", s->z80_enabled ? "on" : "off");
+    if (mask & PROFILE_Z80_SLICE)  APPEND("z80_slice_lines = %d\n", s->z80_slice_lines);
+    if (mask & PROFILE_AUDIO)      APPEND("audio = %s\n", s->audio_enabled ? "on" : "off");
+    if (mask & PROFILE_FM_SOUND)   APPEND("fm_sound = %s\n", s->fm_sound ? "on" : "off");
+    if (mask & PROFILE_FRAMESKIP)  APPEND("frameskip = %d\n", s->frameskip);
+    if (mask & PROFILE_CHANNELS) {
+        APPEND("channel_1 = %s\n", CHANNEL_ENABLED(s->channel_mask, 0) ? "on" : "off");
+        APPEND("channel_2 = %s\n", CHANNEL_ENABLED(s->channel_mask, 1) ? "on" : "off");
+        APPEND("channel_3 = %s\n", CHANNEL_ENABLED(s->channel_mask, 2) ? "on" : "off");
+        APPEND("channel_4 = %s\n", CHANNEL_ENABLED(s->channel_mask, 3) ? "on" : "off");
+        APPEND("channel_5 = %s\n", CHANNEL_ENABLED(s->channel_mask, 4) ? "on" : "off");
+        APPEND("channel_6 = %s\n", CHANNEL_ENABLED(s->channel_mask, 5) ? "on" : "off");
+        APPEND("psg = %s\n", CHANNEL_ENABLED(s->channel_mask, 6) ? "on" : "off");
+    }
+    
+#undef APPEND
+    return len;
+}
+
+psram_timing_t *settings_psram_timing(uint16_t cpu_mhz) {
+    for (int i = 0; i < PSRAM_TIMING_CLOCKS; i++) {
+        if (psram_timing_clocks[i] == cpu_mhz) return &g_settings.psram_timing[i];
+    }
+    return NULL;
+}
+
 void settings_load(void) {
     FIL file;
     char line[128];
-    char value[64];
     
     // Set defaults first
     g_settings.cpu_freq = 504;
@@ -769,104 +1088,134 @@ void settings_load(void) {
     g_settings.channel_mask = 0x7F;  // All channels on
     g_settings.frameskip = 3;  // Default: high
     g_settings.gamepad2_mode = GAMEPAD2_MODE_NES;  // Default: NES
+    g_settings.rewind_kb = 0;  // Default: off
+    g_settings.runahead = 0;  // Per game, see settings_load_game()
+    g_settings.z80_slice_lines = Z80_SLICE_LINES;
+    memset(g_settings.psram_timing, 0, sizeof(g_settings.psram_timing));
     
     FRESULT res = f_open(&file, "/genesis/settings.ini", FA_READ);
     if (res != FR_OK) {
         // Try uppercase
         res = f_open(&file, "/GENESIS/settings.ini", FA_READ);
-        if (res != FR_OK) {
-            return;  // No settings file, use defaults
+    }
+    
+    if (res == FR_OK) {
+        // Read line by line
+        while (f_gets(line, sizeof(line), &file)) {
+            parse_setting_line(line, &g_settings);
         }
+        f_close(&file);
+    }
+    
+    // Game profiles override a copy: keep the global values for settings.ini
+    global_settings = g_settings;
+}
+
+void settings_load_game(uint16_t rom_checksum) {
+    FIL file;
+    char line[128];
+    char value[64];
+    
+    snprintf(game_settings_path, sizeof(game_settings_path), "/genesis/games/%04X.ini", rom_checksum);
+    
+    // Defaults for settings that only exist per game
+    g_settings.runahead = 0;
+    g_settings.pad6 = true;
+    game_overrides = 0;
+    
+    if (f_open(&file, game_settings_path, FA_READ) != FR_OK) {
+        gwenesis_io_set_pad6(0, 1);
+        gwenesis_io_set_pad6(1, 1);
+        return;  // Nothing saved for this game yet
     }
     
-    // Read line by line
+    // Only the knobs present in the file override the global settings
+    settings_t profile = g_settings;
     while (f_gets(line, sizeof(line), &file)) {
-        if (parse_ini_line(line, "cpu_freq", value, sizeof(value))) {
-            int freq = atoi(value);
-            if (freq == 378 || freq == 504) {
-                g_settings.cpu_freq = (uint16_t)freq;
-            }
-        }
-        else if (parse_ini_line(line, "psram_freq", value, sizeof(value))) {
-            int freq = atoi(value);
-            if (freq == 133 || freq == 166) {
-                g_settings.psram_freq = (uint16_t)freq;
-            }
-        }
-        else if (parse_ini_line(line, "z80", value, sizeof(value))) {
-            g_settings.z80_enabled = (strcasecmp(value, "on") == 0 || strcmp(value, "1") == 0);
-        }
-        else if (parse_ini_line(line, "audio", value, sizeof(value))) {
-            g_settings.audio_enabled = (strcasecmp(value, "on") == 0 || strcmp(value, "1") == 0);
-        }
-        else if (parse_ini_line(line, "fm_sound", value, sizeof(value))) {
-            g_settings.fm_sound = (strcasecmp(value, "on") == 0 || strcmp(value, "1") == 0);
-        }
-        else if (parse_ini_line(line, "crt_effect", value, sizeof(value))) {
-            g_settings.crt_effect = (strcasecmp(value, "on") == 0 || strcmp(value, "1") == 0);
-        }
-        else if (parse_ini_line(line, "crt_dim", value, sizeof(value))) {
-            int dim = atoi(value);
-            if (dim >= 10 && dim <= 90) {
-                g_settings.crt_dim = (uint8_t)dim;
-            }
-        }
-        else if (parse_ini_line(line, "channel_1", value, sizeof(value))) {
-            bool en = (strcasecmp(value, "on") == 0 || strcmp(value, "1") == 0);
-            g_settings.channel_mask = CHANNEL_SET(g_settings.channel_mask, 0, en);
-        }
-        else if (parse_ini_line(line, "channel_2", value, sizeof(value))) {
-            bool en = (strcasecmp(value, "on") == 0 || strcmp(value, "1") == 0);
-            g_settings.channel_mask = CHANNEL_SET(g_settings.channel_mask, 1, en);
-        }
-        else if (parse_ini_line(line, "channel_3", value, sizeof(value))) {
-            bool en = (strcasecmp(value, "on") == 0 || strcmp(value, "1") == 0);
-            g_settings.channel_mask = CHANNEL_SET(g_settings.channel_mask, 2, en);
-        }
-        else if (parse_ini_line(line, "channel_4", value, sizeof(value))) {
-            bool en = (strcasecmp(value, "on") == 0 || strcmp(value, "1") == 0);
-            g_settings.channel_mask = CHANNEL_SET(g_settings.channel_mask, 3, en);
-        }
-        else if (parse_ini_line(line, "channel_5", value, sizeof(value))) {
-            bool en = (strcasecmp(value, "on") == 0 || strcmp(value, "1") == 0);
-            g_settings.channel_mask = CHANNEL_SET(g_settings.channel_mask, 4, en);
-        }
-        else if (parse_ini_line(line, "channel_6", value, sizeof(value))) {
-            bool en = (strcasecmp(value, "on") == 0 || strcmp(value, "1") == 0);
-            g_settings.channel_mask = CHANNEL_SET(g_settings.channel_mask, 5, en);
-            g_settings.dac_sound = en;  // Sync dac_sound
-        }
-        else if (parse_ini_line(line, "psg", value, sizeof(value))) {
-            bool en = (strcasecmp(value, "on") == 0 || strcmp(value, "1") == 0);
-            g_settings.channel_mask = CHANNEL_SET(g_settings.channel_mask, 6, en);
-        }
-        else if (parse_ini_line(line, "frameskip", value, sizeof(value))) {
-            int level = atoi(value);
-            if (level >= 0 && level <= FRAMESKIP_MAX_LEVEL) {
-                g_settings.frameskip = (uint8_t)level;
-            }
-        }
-        else if (parse_ini_line(line, "gamepad2", value, sizeof(value))) {
-            if (strcasecmp(value, "nes") == 0 || strcmp(value, "0") == 0) {
-                g_settings.gamepad2_mode = GAMEPAD2_MODE_NES;
-            } else if (strcasecmp(value, "keyboard") == 0 || strcmp(value, "1") == 0) {
-                g_settings.gamepad2_mode = GAMEPAD2_MODE_KEYBOARD;
-            } else if (strcasecmp(value, "usb") == 0 || strcmp(value, "2") == 0) {
-                g_settings.gamepad2_mode = GAMEPAD2_MODE_USB;
-            } else if (strcasecmp(value, "disabled") == 0 || strcmp(value, "3") == 0) {
-                g_settings.gamepad2_mode = GAMEPAD2_MODE_DISABLED;
+        if (parse_ini_line(line, "runahead", value, sizeof(value))) {
+            int frames = atoi(value);
+            if (frames >= 0 && frames <= RUNAHEAD_MAX_FRAMES) {
+                g_settings.runahead = (uint8_t)frames;
             }
+        } else if (parse_ini_line(line, "pad6", value, sizeof(value))) {
+            // Some titles misread a 6-button pad, they get 3-button pads
+            g_settings.pad6 = ini_bool(value);
+        } else {
+            game_overrides |= parse_setting_line(line, &profile);
         }
     }
     
     f_close(&file);
+    apply_profile(&g_settings, &profile, game_overrides);
+    gwenesis_io_set_pad6(0, g_settings.pad6);
+    gwenesis_io_set_pad6(1, g_settings.pad6);
 }
 
-bool settings_save(void) {
+// Write the per-game settings of the loaded ROM (no-op before a ROM is loaded)
+static bool settings_save_game(void) {
     FIL file;
     UINT bw;
     char buf[512];
     
+    if (game_settings_path[0] == '\0') {
+        return true;
+    }
+    
+    f_mkdir("/genesis/games");
+    
+    if (f_open(&file, game_settings_path, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK) {
+        return false;
+    }
+    
+    size_t len = (size_t)snprintf(buf, sizeof(buf),
+        "; MurmGenesis per-game settings\n"
+        "; Keys below override settings.ini for this game only\n"
+        "\n"
+        "runahead = %d\n"
+        "pad6 = %s\n",
+        g_settings.runahead, g_settings.pad6 ? "on" : "off");
+    len += format_profile(buf + len, sizeof(buf) - len, &g_settings, game_overrides);
+    
+    FRESULT res = f_write(&file, buf, len, &bw);
+    f_close(&file);
+    
+    return (res == FR_OK && bw == len);
+}
+
+// Make the edited knobs the profile of the loaded game
+static bool settings_save_game_profile(const settings_t *settings) {
+    if (game_settings_path[0] == '\0') {
+        return false;
+    }
+    
+    apply_profile(&g_settings, settings, PROFILE_ALL);
+    g_settings.runahead = settings->runahead;
+    game_overrides = PROFILE_ALL;
+    settings_apply_runtime();
+    
+    // Core 1 may be flushing a quick-save slot
+    quicksave_sd_lock();
+    bool ok = settings_save_game();
+    quicksave_sd_unlock();
+    return ok;
+}
+
+bool settings_save(void) {
+    FIL file;
+    UINT bw;
+    char buf[768];
+    
+    // Knobs owned by the game profile keep their global values here
+    settings_t global = g_settings;
+    apply_profile(&global, &global_settings, game_overrides);
+    
+    char psram_freq_value[8];
+    if (global.psram_freq == PSRAM_FREQ_AUTO) {
+        snprintf(psram_freq_value, sizeof(psram_freq_value), "auto");
+    } else {
+        snprintf(psram_freq_value, sizeof(psram_freq_value), "%d", global.psram_freq);
+    }
+    
     // Ensure genesis directory exists
     f_mkdir("/genesis");
     
@@ -881,14 +1230,16 @@ bool settings_save(void) {
         "; This file is auto-generated. Edit with care.\n"
         "\n"
         "cpu_freq = %d\n"
-        "psram_freq = %d\n"
+        "psram_freq = %s\n"
         "z80 = %s\n"
+        "z80_slice_lines = %d\n"
         "audio = %s\n"
         "fm_sound = %s\n"
         "crt_effect = %s\n"
         "crt_dim = %d\n"
         "frameskip = %d\n"
         "gamepad2 = %s\n"
+        "rewind_kb = %d\n"
         "\n"
         "; Audio Channels\n"
         "channel_1 = %s\n"
@@ -898,27 +1249,45 @@ bool settings_save(void) {
         "channel_5 = %s\n"
         "channel_6 = %s\n"
         "psg = %s\n",
-        g_settings.cpu_freq,
-        g_settings.psram_freq,
-        g_settings.z80_enabled ? "on" : "off",
-        g_settings.audio_enabled ? "on" : "off",
-        g_settings.fm_sound ? "on" : "off",
-        g_settings.crt_effect ? "on" : "off",
-        g_settings.crt_dim,
-        g_settings.frameskip,
-        gamepad2_mode_names[g_settings.gamepad2_mode],
-        CHANNEL_ENABLED(g_settings.channel_mask, 0) ? "on" : "off",
-        CHANNEL_ENABLED(g_settings.channel_mask, 1) ? "on" : "off",
-        CHANNEL_ENABLED(g_settings.channel_mask, 2) ? "on" : "off",
-        CHANNEL_ENABLED(g_settings.channel_mask, 3) ? "on" : "off",
-        CHANNEL_ENABLED(g_settings.channel_mask, 4) ? "on" : "off",
-        CHANNEL_ENABLED(g_settings.channel_mask, 5) ? "on" : "off",
-        CHANNEL_ENABLED(g_settings.channel_mask, 6) ? "on" : "off");
+        global.cpu_freq,
+        psram_freq_value,
+        global.z80_enabled ? "on" : "off",
+        global.z80_slice_lines,
+        global.audio_enabled ? "on" : "off",
+        global.fm_sound ? "on" : "off",
+        global.crt_effect ? "on" : "off",
+        global.crt_dim,
+        global.frameskip,
+        gamepad2_mode_names[global.gamepad2_mode],
+        global.rewind_kb,
+        CHANNEL_ENABLED(global.channel_mask, 0) ? "on" : "off",
+        CHANNEL_ENABLED(global.channel_mask, 1) ? "on" : "off",
+        CHANNEL_ENABLED(global.channel_mask, 2) ? "on" : "off",
+        CHANNEL_ENABLED(global.channel_mask, 3) ? "on" : "off",
+        CHANNEL_ENABLED(global.channel_mask, 4) ? "on" : "off",
+        CHANNEL_ENABLED(global.channel_mask, 5) ? "on" : "off",
+        CHANNEL_ENABLED(global.channel_mask, 6) ? "on" : "off");
+    
+    // Calibrated PSRAM timings (psram_freq = auto)
+    bool timing_header = false;
+    for (int i = 0; i < PSRAM_TIMING_CLOCKS; i++) {
+        const psram_timing_t *t = &global.psram_timing[i];
+        if (t->clkdiv == 0) continue;
+        size_t len = strlen(buf);
+        snprintf(buf + len, sizeof(buf) - len, "%spsram_timing_%d = %d,%d,%d\n",
+                 timing_header ? "" : "\n; PSRAM timing calibrated per CPU clock: clkdiv,rxdelay,cooldown\n",
+                 psram_timing_clocks[i], t->clkdiv, t->rxdelay, t->cooldown);
+        timing_header = true;
+    }
     
     res = f_write(&file, buf, strlen(buf), &bw);
     f_close(&file);
     
-    return (res == FR_OK && bw == strlen(buf));
+    if (res != FR_OK || bw != strlen(buf)) {
+        return false;
+    }
+    global_settings = global;
+    return settings_save_game();
 }
 
 // External audio control flags from main.c and ym2612.c
@@ -940,6 +1309,9 @@ extern void graphics_set_crt_effect(bool enabled, uint8_t dim_percent);
 // External frameskip control from main.c
 extern void set_frameskip_level(uint8_t level);
 
+// External Z80 slice control from main.c
+extern void set_z80_slice_lines(uint8_t lines);
+
 void settings_apply_runtime(void) {
     // Apply settings that can be changed without restart
     
@@ -971,6 +1343,9 @@ void settings_apply_runtime(void) {
     
     // Frameskip
     set_frameskip_level(g_settings.frameskip);
+    
+    // Z80 slice length
+    set_z80_slice_lines(g_settings.z80_slice_lines);
 }
 
 settings_result_t settings_menu_show(uint8_t *screen_buffer) {
@@ -1001,6 +1376,7 @@ settings_result_t settings_menu_show_with_restore(uint8_t *screen_buffer, uint8_
     
     // Copy current settings to edit buffer
     memcpy(&edit_settings, &g_settings, sizeof(settings_t));
+    profile_status = PROFILE_STATUS_NONE;
     
     int selected = 0;
     uint32_t prev_buttons = 0;
@@ -1138,6 +1514,25 @@ settings_result_t settings_menu_show_with_restore(uint8_t *screen_buffer, uint8_
                     }
                     break;
                     
+                case MENU_GAME_PROFILE:
+                    // Snapshot the edited knobs for this game, applied right away
+                    profile_status = settings_save_game_profile(&edit_settings) ?
+                        PROFILE_STATUS_SAVED : PROFILE_STATUS_FAILED;
+                    
+                    // Resume with the new audio flags, keep the chips muted in the menu
+                    saved_ym2612_enabled = ym2612_enabled;
+                    saved_ym2612_fm_enabled = ym2612_fm_enabled;
+                    saved_ym2612_dac_enabled = ym2612_dac_enabled;
+                    saved_sn76489_enabled = sn76489_enabled;
+                    ym2612_enabled = false;
+                    ym2612_fm_enabled = false;
+                    ym2612_dac_enabled = false;
+                    sn76489_enabled = false;
+                    needs_redraw = true;
+                    break;
+                    
+                case MENU_SAVE_STATE:
+                case MENU_LOAD_STATE:
                 case MENU_CANCEL: {
                     // Wait for all buttons to be released for multiple consecutive reads
                     int release_count = 0;
@@ -1158,6 +1553,8 @@ settings_result_t settings_menu_show_with_restore(uint8_t *screen_buffer, uint8_
                     ym2612_dac_enabled = saved_ym2612_dac_enabled;
                     sn76489_enabled = saved_sn76489_enabled;
                     audio_set_enabled(true);
+                    if (selected == MENU_SAVE_STATE) return SETTINGS_RESULT_SAVE_STATE;
+                    if (selected == MENU_LOAD_STATE) return SETTINGS_RESULT_LOAD_STATE;
                     return SETTINGS_RESULT_CANCEL;
                 }
                     
@@ -1216,25 +1613,19 @@ bool settings_check_hotkey(void) {
     
     bool start_select = (nespad_state & DPAD_SELECT) && (nespad_state & DPAD_START);
     
-    // Check PS/2 keyboard for ESC
-    ps2kbd_tick();
-    uint16_t kbd_state = ps2kbd_get_state();
-    
-#ifdef USB_HID_ENABLED
-    // Merge USB keyboard state
-    kbd_state |= usbhid_get_kbd_state();
-#endif
+    // Check PS/2 / USB keyboard for ESC
+    uint32_t input_word = input_poll_read();
+    uint16_t kbd_state = INPUT_WORD_KBD(input_word);
     
     if (kbd_state & KBD_STATE_ESC) {
         start_select = true;
     }
     
 #ifdef USB_HID_ENABLED
-    if (!start_select && usbhid_gamepad_connected()) {
-        usbhid_gamepad_state_t gp;
-        usbhid_get_gamepad_state(&gp);
+    if (!start_select && (input_word & INPUT_WORD_GP_CONNECTED)) {
+        uint8_t gp_buttons = INPUT_WORD_GP(input_word);
         // Start=0x40, Select=0x80
-        start_select = (gp.buttons & 0x40) && (gp.buttons & 0x80);
+        start_select = (gp_buttons & 0x40) && (gp_buttons & 0x80);
     }
 #endif
     
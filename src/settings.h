@@ -7,11 +7,12 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "psram_init.h"
 
 // Settings structure stored in genesis/settings.ini
 typedef struct {
     uint16_t cpu_freq;      // RP2350 frequency: 504 (default), 378
-    uint16_t psram_freq;    // PSRAM frequency: 166 (default), 133
+    uint16_t psram_freq;    // PSRAM frequency: 166 (default), 133, PSRAM_FREQ_AUTO
     bool fm_sound;          // FM (YM2612) sound: true (default), false
     bool dac_sound;         // DAC sound: true (default), false
     bool crt_effect;        // CRT scanlines: false (default), true
@@ -21,8 +22,22 @@ typedef struct {
     uint8_t channel_mask;   // Channel enable bitmask: bits 0-5 = FM 1-6, bit 6 = PSG
     uint8_t frameskip;      // Frameskip level: 0=none, 1=low, 2=medium, 3=high (default), 4=extreme
     uint8_t gamepad2_mode;  // Gamepad 2 mode: 0=NES, 1=keyboard, 2=USB, 3=disabled
+    uint16_t rewind_kb;     // Rewind ring budget in KB: 0 (off, default), 512, 1024, 2048
+    uint8_t runahead;       // Run-ahead frames: 0 (off, default), 1, 2 - per game
+    bool pad6;              // 6-button pads on ports 1-2: true (default), false - per game
+    uint8_t z80_slice_lines;// Run the Z80 every N scanlines: 1-64, default Z80_SLICE_LINES
+    psram_timing_t psram_timing[2]; // Calibrated PSRAM timing at 378/504 MHz, clkdiv 0 = none
 } settings_t;
 
+// psram_freq value: calibrated timing (see psram_tune.h)
+#define PSRAM_FREQ_AUTO 0
+
+// Build-time default of z80_slice_lines (CMake Z80_SLICE_LINES)
+#ifndef Z80_SLICE_LINES
+#define Z80_SLICE_LINES 16
+#endif
+#define Z80_SLICE_LINES_MAX 64
+
 // Gamepad 2 mode values
 #define GAMEPAD2_MODE_NES      0  // Second NES/SNES gamepad (default)
 #define GAMEPAD2_MODE_KEYBOARD 1  // Keyboard controls P2 instead of P1
@@ -41,6 +56,8 @@ typedef enum {
     SETTINGS_RESULT_CANCEL,         // User pressed cancel
     SETTINGS_RESULT_SAVE_RESTART,   // Save settings and restart
     SETTINGS_RESULT_RESTART,        // Restart without saving
+    SETTINGS_RESULT_SAVE_STATE,     // Resume game after saving a savestate
+    SETTINGS_RESULT_LOAD_STATE,     // Resume game after loading a savestate
 } settings_result_t;
 
 /**
@@ -50,17 +67,40 @@ typedef enum {
 void settings_load(void);
 
 /**
- * Save current settings to SD card (genesis/settings.ini)
+ * Save current settings to SD card (genesis/settings.ini), plus the
+ * per-game settings of the loaded ROM (genesis/games/<checksum>.ini)
  * @return true if saved successfully
  */
 bool settings_save(void);
 
+/**
+ * Load per-game settings for the ROM just loaded
+ * Keys found in genesis/games/<checksum>.ini override settings.ini for
+ * this game: cpu_freq, psram_freq, z80, z80_slice_lines, audio, fm_sound,
+ * channel_1..6, psg, frameskip (plus runahead and pad6, which only exist
+ * per game)
+ * @param rom_checksum Checksum word from the ROM header (0x18E)
+ */
+void settings_load_game(uint16_t rom_checksum);
+
+/**
+ * Calibrated PSRAM timing slot of a CPU clock
+ * @return NULL for a clock the settings offer no slot for
+ */
+psram_timing_t *settings_psram_timing(uint16_t cpu_mhz);
+
 /**
  * Apply settings that can be changed at runtime
  * (audio enable/disable flags)
  */
 void settings_apply_runtime(void);
 
+/**
+ * 5x7 font glyph of the menus, one byte per row (bit 4 = leftmost column).
+ * Upper case letters, digits and a little punctuation, others are blank.
+ */
+const uint8_t *settings_glyph_5x7(char ch);
+
 /**
  * Display settings menu and wait for user interaction
  * @param screen_buffer Pointer to screen buffer (320x240 8-bit indexed)
@@ -2349,6 +2349,12 @@ unsigned int YM2612Read(int target)
   return ym2612.OPN.ST.status & 0xff;
 }
 
+/* Status without running the chip (it was run up to the read elsewhere) */
+unsigned int YM2612Status(void)
+{
+  return ym2612.OPN.ST.status & 0xff;
+}
+
 
 /* Genesis-Plus-GX: YM2612Config with chip type selection
  * type: YM2612_DISCRETE (0) - 9-bit DAC with ladder effect
@@ -43,6 +43,7 @@ extern void YM2612ResetChip(void);
 extern void YM2612Write(unsigned int a, unsigned int v, int target);
 extern void ym2612_run(int target);
 extern unsigned int YM2612Read(int target);
+extern unsigned int YM2612Status(void);
 
 void gwenesis_ym2612_save_state();
 void gwenesis_ym2612_load_state();
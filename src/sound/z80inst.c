@@ -27,6 +27,8 @@ __license__ = "GPLv3"
 #include "ym2612.h"
 #include "gwenesis_sn76489.h"
 #include "gwenesis_savestate.h"
+#include "psram_stream.h"
+#include "z80_core1.h"
 
 /* Set to 1 to use ARM assembly Z80 core, 0 for C core */
 #define USE_Z80_ARM_ASM 1
@@ -41,6 +43,12 @@ __license__ = "GPLv3"
 static volatile int bus_ack = 0;
 static volatile int reset = 0;
 static volatile int reset_once = 0;
+
+/* 68K view of BUSREQ/RESET: only 68K writes change it, so with the Z80 on
+ * core 1 (Z80_CORE1) core 0 answers reads from it without a sync */
+static int ctrl_bus_ack = 0;
+static int ctrl_reset = 0;
+
 volatile int zclk = 0;
 static int initialized = 0;
 
@@ -53,6 +61,7 @@ unsigned char *Z80_RAM;
 static uint8_t __attribute__((aligned(4))) z80_bank_cache[Z80_BANK_CACHE_COUNT][Z80_BANK_CACHE_SIZE];
 static int z80_bank_cache_tags[Z80_BANK_CACHE_COUNT] = {-1, -1};  /* LRU cache tags */
 static int z80_bank_cache_lru = 0;  /* Next slot to replace */
+static z80_bank_cache_totals_t z80_bank_cache_totals;
 
 /* Make cpu and current_timeslice globally accessible for assembly optimization */
 Z80 cpu;
@@ -95,6 +104,8 @@ void z80_start() {
     reset=1;
     reset_once=0;
     bus_ack=0;
+    ctrl_reset=1;
+    ctrl_bus_ack=0;
     zclk=0;
     z80_bank_cache_tags[0] = -1;  /* Invalidate cache on start */
     z80_bank_cache_tags[1] = -1;
@@ -180,9 +191,27 @@ void z80_set_memory(unsigned char *buffer)
     initialized = 1;
 }
 
+/* Master clock of the Z80 instruction being executed */
+int z80_cycles_master(void) {
+  return zclk + current_timeslice - cpu.ICount * Z80_FREQ_DIVISOR;
+}
+
 void z80_write_ctrl(unsigned int address, unsigned int value) {
+  if (address == 0x1100)
+    ctrl_bus_ack = value ? 1 : 0;
+  else if (address == 0x1200)
+    ctrl_reset = value ? 0 : 1;
+
+#if Z80_CORE1
+  if (z80_core1_post(m68k_cycles_master(), Z80_EV_CTRL, address, value))
+    return;
+#endif
   z80_sync();
+  z80_apply_ctrl(address, value);
+}
 
+/* BUSREQ/RESET write, the Z80 has run up to its time */
+void z80_apply_ctrl(unsigned int address, unsigned int value) {
   if (address == 0x1100) // BUSREQ
   {
     // Bus request. Z80 bus on hold.
@@ -209,20 +238,23 @@ void z80_write_ctrl(unsigned int address, unsigned int value) {
 
 unsigned int z80_read_ctrl(unsigned int address) {
 
+#if Z80_CORE1
+  if (!z80_core1_active)
+#endif
   z80_sync();
 
   if (address == 0x1100) {
 
-    z80_log(__FUNCTION__,"RUNNING = %d ", bus_ack ? 0 : 1);
-    return bus_ack == 1 ? 0 : 1;
+    z80_log(__FUNCTION__,"RUNNING = %d ", ctrl_bus_ack ? 0 : 1);
+    return ctrl_bus_ack == 1 ? 0 : 1;
 
   } else if (address == 0x1101) {
     return 0x00;
 
   } else if (address == 0x1200) {
 
-    z80_log(__FUNCTION__,"RESET = %d ", reset );
-    return reset;
+    z80_log(__FUNCTION__,"RESET = %d ", ctrl_reset );
+    return ctrl_reset;
 
   } else if (address == 0x1201) {
     return 0x00;
@@ -270,14 +302,19 @@ void z80_bank_cache_invalidate(void) {
     z80_bank_cache_lru = 0;
 }
 
+void z80_bank_cache_get_totals(z80_bank_cache_totals_t *out) {
+    *out = z80_bank_cache_totals;
+}
+
 /* Find or allocate a cache slot for the given bank, returns slot index */
 static inline int z80_bank_cache_get_slot(int bank) {
+    z80_bank_cache_totals.lookups++;
+
     /* Check if already cached */
     if (z80_bank_cache_tags[0] == bank) return 0;
     if (z80_bank_cache_tags[1] == bank) return 1;
     
     /* Cache miss - fill next slot (simple round-robin replacement) */
-    extern unsigned char* ROM_DATA;
     unsigned int base_addr = bank << 15;
     
     /* Only cache if within ROM range (< 8MB) */
@@ -285,13 +322,11 @@ static inline int z80_bank_cache_get_slot(int bank) {
         int slot = z80_bank_cache_lru;
         z80_bank_cache_lru = 1 - slot;  /* Toggle 0<->1 */
         
-        /* Copy 32KB from ROM (PSRAM) to cache (SRAM) */
-        const uint32_t *src = (const uint32_t *)(ROM_DATA + base_addr);
-        uint32_t *dst = (uint32_t *)z80_bank_cache[slot];
-        for (int i = 0; i < Z80_BANK_CACHE_SIZE / 4; i++) {
-            dst[i] = src[i];
-        }
+        /* Copy 32KB from ROM (PSRAM) to cache (SRAM), through the 68K bank map */
+        const uint8_t *src = (const uint8_t *)(m68k_rom_map[base_addr >> ROM_BANK_SHIFT] + base_addr);
+        psram_stream_copy_rom(z80_bank_cache[slot], src, Z80_BANK_CACHE_SIZE);
         z80_bank_cache_tags[slot] = bank;
+        z80_bank_cache_totals.misses++;
         return slot;
     }
     return -1;  /* Not cacheable */
@@ -331,6 +366,10 @@ unsigned int zbank_mem_r8(unsigned int address)
     
     /* Non-ROM access (RAM mirror, etc) - use slow path */
     z80_log(__FUNCTION__,"Z80 bank read: %06x", full_addr);
+#if Z80_CORE1
+    if (z80_core1_active)
+      return z80_core1_bank_read(full_addr);
+#endif
     return m68k_read_memory_8(full_addr);
 }
 
@@ -339,6 +378,12 @@ void zbank_mem_w8(unsigned int address, unsigned int value) {
   address |= (Z80_BANK << 15);
 
   z80_log(__FUNCTION__,"Z80 bank write %06x: %02x", address, value);
+#if Z80_CORE1
+  if (z80_core1_active) {
+    z80_core1_bank_write(address, value);
+    return;
+  }
+#endif
   m68k_write_memory_8(address, value);
 
 }
@@ -403,6 +448,8 @@ void gwenesis_z80inst_load_state() {
     initialized = saveGwenesisStateGet(state, "initialized");
     Z80_BANK = saveGwenesisStateGet(state, "Z80_BANK");
     current_timeslice = saveGwenesisStateGet(state, "current_timeslice");
+    ctrl_bus_ack = bus_ack;
+    ctrl_reset = reset;
 
 }
 
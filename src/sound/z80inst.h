@@ -20,7 +20,9 @@ __license__ = "GPLv3"
 #define _Z80_INTERFACE_H_
 
 void z80_write_ctrl(unsigned int address, unsigned int value);
+void z80_apply_ctrl(unsigned int address, unsigned int value);
 unsigned int z80_read_ctrl(unsigned int address);
+int z80_cycles_master(void);
 void z80_start();
 void z80_pulse_reset();
 void z80_execute(unsigned int target);
@@ -38,6 +40,17 @@ unsigned int z80_read_memory_16(unsigned int address);
 unsigned int z80_read_memory_8(unsigned int address);
 void z80_irq_line(unsigned int value);
 
+/* Drop the cached 68K banks (ROM_DATA or the ROM bank map changed) */
+void z80_bank_cache_invalidate(void);
+
+/* Z80 bank cache totals since boot (never reset, take differences) */
+typedef struct {
+  unsigned int lookups;     /* Bank window reads of ROM */
+  unsigned int misses;      /* 32 KB banks copied from PSRAM */
+} z80_bank_cache_totals_t;
+
+void z80_bank_cache_get_totals(z80_bank_cache_totals_t *out);
+
 void gwenesis_z80inst_save_state();
 void gwenesis_z80inst_load_state();
 
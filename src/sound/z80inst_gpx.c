@@ -244,6 +244,15 @@ void z80_irq_line(unsigned int value) {
  * Z80 Bank
  ********************************************/
 
+/* No bank cache: bank reads go through the 68K bus */
+void z80_bank_cache_invalidate(void) {
+}
+
+void z80_bank_cache_get_totals(z80_bank_cache_totals_t *out) {
+    out->lookups = 0;
+    out->misses = 0;
+}
+
 unsigned int zbankreg_mem_r8(unsigned int address) {
     z80_log(__FUNCTION__,"Z80 bank read pointer : %06x", Z80_BANK);
     return Z80_BANK;
@@ -127,6 +127,8 @@ unsigned int gwenesis_vdp_read_memory_16(unsigned int address);
 
 void gwenesis_vdp_write_memory_8(unsigned int address, unsigned int value);
 void gwenesis_vdp_write_memory_16(unsigned int address, unsigned int value);
+void gwenesis_vdp_write_data_port_block(const unsigned short *words,
+                                        unsigned int count, unsigned int wrap);
 
 void gwenesis_vdp_set_buffers(unsigned char *screen_buffer, unsigned char *scaled_buffer);
 void gwenesis_vdp_set_buffer(uint8_t *ptr_screen_buffer);
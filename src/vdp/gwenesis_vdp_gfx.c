@@ -26,6 +26,7 @@ __license__ = "GPLv3"
 #include "gwenesis_io.h"
 #include "gwenesis_bus.h"
 #include "gwenesis_savestate.h"
+#include "cycprof.h"
 
 //#include <assert.h>
 
@@ -47,6 +48,31 @@ extern void draw_line_b_simple_asm(uint8_t* scr, uint8_t* vram_nt, uint32_t col,
 extern void draw_line_a_simple_asm(uint8_t* scr, uint8_t* vram_nt, uint32_t col, uint32_t paty,
                                    uint32_t ntw_mask, uint32_t tile_count);
 extern void draw_window_line_asm(uint8_t* scr, uint8_t* vram_nt, uint32_t paty, uint32_t tile_count);
+extern void draw_line_b_cscroll_asm(uint8_t* scr, const uint32_t* rows, uint32_t col,
+                                    uint32_t ntw_mask, uint32_t background, uint32_t tile_count);
+extern void draw_line_a_cscroll_asm(uint8_t* scr, const uint32_t* rows, uint32_t col,
+                                    uint32_t ntw_mask, uint32_t tile_count);
+
+#if CYCLE_PROFILING
+/* Time every kernel call: the macros shadow the entry points declared above,
+ * the name inside its own expansion still refers to the function */
+#define PROFILED_KERNEL(fn, ...) do { \
+  CYCPROF_BEGIN(); fn(__VA_ARGS__); CYCPROF_END(CYCPROF_VDP, CYCPROF_VDP_##fn); \
+} while (0)
+#define draw_pattern_nofliph_planeB_asm(...) PROFILED_KERNEL(draw_pattern_nofliph_planeB_asm, __VA_ARGS__)
+#define draw_pattern_fliph_planeB_asm(...) PROFILED_KERNEL(draw_pattern_fliph_planeB_asm, __VA_ARGS__)
+#define draw_pattern_nofliph_planeA_asm(...) PROFILED_KERNEL(draw_pattern_nofliph_planeA_asm, __VA_ARGS__)
+#define draw_pattern_fliph_planeA_asm(...) PROFILED_KERNEL(draw_pattern_fliph_planeA_asm, __VA_ARGS__)
+#define draw_pattern_nofliph_sprite_asm(...) PROFILED_KERNEL(draw_pattern_nofliph_sprite_asm, __VA_ARGS__)
+#define draw_pattern_fliph_sprite_asm(...) PROFILED_KERNEL(draw_pattern_fliph_sprite_asm, __VA_ARGS__)
+#define draw_pattern_nofliph_sprite_over_asm(...) PROFILED_KERNEL(draw_pattern_nofliph_sprite_over_asm, __VA_ARGS__)
+#define draw_pattern_fliph_sprite_over_asm(...) PROFILED_KERNEL(draw_pattern_fliph_sprite_over_asm, __VA_ARGS__)
+#define draw_line_b_simple_asm(...) PROFILED_KERNEL(draw_line_b_simple_asm, __VA_ARGS__)
+#define draw_line_a_simple_asm(...) PROFILED_KERNEL(draw_line_a_simple_asm, __VA_ARGS__)
+#define draw_window_line_asm(...) PROFILED_KERNEL(draw_window_line_asm, __VA_ARGS__)
+#define draw_line_b_cscroll_asm(...) PROFILED_KERNEL(draw_line_b_cscroll_asm, __VA_ARGS__)
+#define draw_line_a_cscroll_asm(...) PROFILED_KERNEL(draw_line_a_cscroll_asm, __VA_ARGS__)
+#endif
 
 /* Use assembly implementations */
 #define USE_ASM_VDP 1
@@ -490,6 +516,50 @@ void draw_pattern_planeA(uint8_t* scr, uint16_t name, int paty) {
 static uint16_t ntwidth_x2;
 static uint16_t ntw_mask, nth_mask;
 
+/* Plane A and B scrolling of every line, resolved once per frame by
+ * gwenesis_vdp_render_config() */
+typedef struct {
+    uint16_t hscroll[2];   /* -hscroll & 0x3FF: first column << 3 | fine x */
+    uint32_t row[2];       /* Full screen vscroll: nt row address | paty*4 << 16 */
+} line_scroll_t;
+
+enum { PLANE_A, PLANE_B };
+
+static line_scroll_t line_scroll[240];
+static unsigned int ntaddr_a, ntaddr_b;
+
+/* Nametable row address of a plane at vertical position scrolly, with the
+ * pattern line: nt row address | (pattern line * 4) << 16 */
+static inline __attribute__((always_inline))
+uint32_t nt_row_entry(unsigned int ntaddr, unsigned int scrolly) {
+    uint8_t row = (scrolly >> 3) & nth_mask;
+    return (ntaddr + row * ntwidth_x2) | ((scrolly & 7) << 18);
+}
+
+#if USE_ASM_LINE
+/* Per-tile nametable row of a column scrolled line (one tile of fine
+ * scroll overhang, rounded up to whole 2-cell columns) */
+static uint32_t column_rows[GWENESIS_SCREEN_WIDTH / 8 + 2];
+
+/******************************************************************************
+ *
+ *  Build the row table of the *_cscroll_asm renderers from VSRAM: for every
+ *  tile, nametable row offset | (pattern line * 4) << 16. Both tiles of a
+ *  2-cell column share the VSRAM entry, entries of a plane are 2 apart.
+ *
+ ******************************************************************************/
+static inline __attribute__((always_inline))
+void build_column_rows(const uint16_t* vsram, unsigned int ntaddr, int line, int tiles) {
+    for (int i = 0; i < tiles; i += 2) {
+        uint32_t entry = nt_row_entry(ntaddr, (uint16_t)(*vsram + line));
+
+        column_rows[i] = entry;
+        column_rows[i + 1] = entry;
+        vsram += 2;
+    }
+}
+#endif
+
 /******************************************************************************
  *
  *  Return the Horizontal scrolling
@@ -520,44 +590,42 @@ static inline __attribute__((always_inline))
 void draw_line_b(int line) {
     uint8_t* scr = &render_buffer[PIX_OVERFLOW];
 
-    const unsigned int ntaddr = REG4_NAMETABLE_B;
+    const line_scroll_t* ls = &line_scroll[line];
+    const unsigned int ntaddr = ntaddr_b;
     
-    uint16_t scrollx = FETCH16VRAM(get_hscroll_vram(line) + 2) & 0x3FF;
+    // Horizontal scrolling is already inverted (it goes right, but we need
+    // the offset of the first screen pixel)
+    const uint16_t scrollx = ls->hscroll[PLANE_B];
     const uint16_t* vsram = &VSRAM[1];
-    const uint8_t* end = scr + screen_width;
 
     bool column_scrolling = BIT(gwenesis_vdp_regs[11], 2);
 
-    // Invert horizontal scrolling (because it goes right, but we need to offset
-    // of the first screen pixel)
-    scrollx = -scrollx;
     uint8_t col = (scrollx >> 3) & ntw_mask;
     const uint8_t patx = scrollx & 7;
 
 #if USE_ASM_LINE
-    /* Use assembly for non-column-scrolling case */
-    if (!column_scrolling) {
-        uint16_t scrolly = *vsram + line;
-        uint8_t row = (scrolly >> 3) & nth_mask;
-        uint8_t paty = scrolly & 7;
-        
-        /* Calculate nametable row base */
-        unsigned int nt_base = ntaddr + row * ntwidth_x2;
-        
+    const int tile_count = (screen_width + patx + 7) / 8;   /* round up */
+
+    if (column_scrolling) {
+        build_column_rows(vsram, ntaddr, line, tile_count);
+        draw_line_b_cscroll_asm(scr - patx, column_rows, col, ntw_mask,
+                                gwenesis_vdp_regs[7], tile_count);
+    } else {
+        const uint32_t row = ls->row[PLANE_B];
+
         /* Call assembly line renderer */
         draw_line_b_simple_asm(
             scr - patx,                     /* screen pointer adjusted for fine scroll */
-            VRAM + nt_base,                 /* VRAM + nametable row offset */
+            VRAM + (row & 0xFFFF),          /* VRAM + nametable row offset */
             col,                            /* initial column */
-            paty,                           /* pattern Y offset */
+            row >> 18,                      /* pattern Y offset */
             ntw_mask,                       /* column wrap mask */
             gwenesis_vdp_regs[7],           /* background color */
-            (screen_width + patx + 7) / 8   /* tile count (round up) */
+            tile_count                      /* tile count */
         );
-        return;
     }
-#endif
-
+#else
+    const uint8_t* end = scr + screen_width;
     unsigned int numcell = 0;
     scr -= patx;
     while (scr < end) {
@@ -577,6 +645,7 @@ void draw_line_b(int line) {
         if (column_scrolling && (numcell & 1) == 0)
             vsram += 2;
     }
+#endif
 }
 
 /******************************************************************************
@@ -589,8 +658,9 @@ static inline __attribute__((always_inline))
 void draw_line_aw(int line) {
     uint8_t* scr = &render_buffer[PIX_OVERFLOW];
 
-    unsigned int ntaddr = REG2_NAMETABLE_A;
-    uint16_t scrollx = FETCH16VRAM(get_hscroll_vram(line) + 0) & 0x3FF;
+    const line_scroll_t* ls = &line_scroll[line];
+    unsigned int ntaddr = ntaddr_a;
+    const uint16_t scrollx = ls->hscroll[PLANE_A];
     uint16_t* vsram = &VSRAM[0];
 
     // Check if we are in the window region only
@@ -621,37 +691,47 @@ void draw_line_aw(int line) {
 
     // First draw A plane
     uint8_t* pos = scr + PlanA_first; // scr + screen_width;
+#if !USE_ASM_LINE
     uint8_t* end = scr + PlanA_last; // scr + screen_width
+#endif
 
     //bool column_scrolling = BIT(gwenesis_vdp_regs[11], 2);
     const unsigned int column_scrolling = gwenesis_vdp_regs[11] & 0x4;
 
-    // Invert horizontal scrolling (because it goes right, but we need to offset
-    // of the first screen pixel)
-    scrollx = -scrollx;
     uint8_t col = (scrollx >> 3) & ntw_mask;
     uint8_t patx = scrollx & 7;
 
+    // Plane A is drawn in whole tiles and overhangs its columns by up to 7
+    // pixels on each side. Where it meets the window, keep the plane B
+    // pixels under the overhang: transparent window pixels show plane B.
+    const int split = PlanA_first < PlanA_last && Window_first < Window_last;
+    uint8_t edge_left[8], edge_right[8];
+    if (split) {
+        memcpy(edge_left, scr + PlanA_first - 8, 8);
+        memcpy(edge_right, scr + PlanA_last, 8);
+    }
+
 #if USE_ASM_LINE
-    /* Use assembly for non-column-scrolling Plane A */
-    if (!column_scrolling && PlanA_first < PlanA_last) {
-        uint16_t scrolly = *vsram + line;
-        uint8_t row = (scrolly >> 3) & nth_mask;
-        uint8_t paty = scrolly & 7;
-        
-        unsigned int nt_base = ntaddr + row * ntwidth_x2;
+    if (PlanA_first < PlanA_last) {
         int tile_count = (PlanA_last - PlanA_first + patx + 7) / 8;
-        
-        draw_line_a_simple_asm(
-            pos - patx,
-            VRAM + nt_base,
-            col,
-            paty,
-            ntw_mask,
-            tile_count
-        );
-    } else {
-#endif
+
+        if (column_scrolling) {
+            build_column_rows(vsram, ntaddr, line, tile_count);
+            draw_line_a_cscroll_asm(pos - patx, column_rows, col, ntw_mask, tile_count);
+        } else {
+            const uint32_t row = ls->row[PLANE_A];
+
+            draw_line_a_simple_asm(
+                pos - patx,
+                VRAM + (row & 0xFFFF),
+                col,
+                row >> 18,
+                ntw_mask,
+                tile_count
+            );
+        }
+    }
+#else
     unsigned int numcell = 0;
     pos -= patx;
     while (pos < end) {
@@ -673,10 +753,13 @@ void draw_line_aw(int line) {
         if (column_scrolling && (numcell & 1) == 0)
             vsram += 2;
     }
-#if USE_ASM_LINE
-    }
 #endif
 
+    if (split) {
+        memcpy(scr + PlanA_first - 8, edge_left, 8);
+        memcpy(scr + PlanA_last, edge_right, 8);
+    }
+
     // Second Draw Window Plane
     int row = line >> 3;
     int paty = line & 7;
@@ -939,6 +1022,21 @@ void __time_critical_func(gwenesis_vdp_render_config)() {
     nth_mask = ntheight - 1;
     ntwidth_x2 = ntwidth * 2;
 
+    // Scrolling of every line of the frame
+    ntaddr_a = REG2_NAMETABLE_A;
+    ntaddr_b = REG4_NAMETABLE_B;
+
+    const int lines = REG1_PAL ? 240 : 224;
+    for (int line = 0; line < lines; line++) {
+        const unsigned int hscroll = get_hscroll_vram(line);
+        line_scroll_t* ls = &line_scroll[line];
+
+        ls->hscroll[PLANE_A] = -FETCH16VRAM(hscroll + 0) & 0x3FF;
+        ls->hscroll[PLANE_B] = -FETCH16VRAM(hscroll + 2) & 0x3FF;
+        ls->row[PLANE_A] = nt_row_entry(ntaddr_a, (uint16_t)(VSRAM[0] + line));
+        ls->row[PLANE_B] = nt_row_entry(ntaddr_b, (uint16_t)(VSRAM[1] + line));
+    }
+
     // Window & A planes separation
 
     if (mode_h40)
@@ -994,8 +1092,8 @@ void gwenesis_vdp_render_line(int line) {
     vdpg_log(__FUNCTION__, ": %3d", line);
 
     //unsigned int line = scan_line;
-    // Recalculate plane sizes every frame in case registers changed
-    if (line == 0) gwenesis_vdp_render_config();
+    // Plane sizes and scrolling come from gwenesis_vdp_render_config(),
+    // called before the first rendered line of every frame
 
     // interlace mode not implemented
     if (BITS(gwenesis_vdp_regs[12], 1, 2) != 0)
@@ -1064,40 +1162,23 @@ void gwenesis_vdp_render_line(int line) {
 }
 
 void gwenesis_vdp_gfx_save_state() {
-    /*
+    // render_buffer/sprite_buffer are per-line scratch and rebuilt every line
     SaveState* state;
     state = saveGwenesisStateOpenForWrite("vdp_gfx");
-    saveGwenesisStateSetBuffer(state, "render_buffer", render_buffer, sizeof(render_buffer));
-    saveGwenesisStateSetBuffer(state, "sprite_buffer", sprite_buffer, sizeof(sprite_buffer));
     saveGwenesisStateSet(state, "mode_h40", mode_h40);
     saveGwenesisStateSet(state, "mode_pal", mode_pal);
     saveGwenesisStateSet(state, "screen_width", screen_width);
     saveGwenesisStateSet(state, "screen_height", screen_height);
     saveGwenesisStateSet(state, "sprite_overflow", sprite_overflow);
     saveGwenesisStateSet(state, "sprite_collision", sprite_collision);
-    saveGwenesisStateSet(state, "base_w", base_w);
-    saveGwenesisStateSet(state, "PlanA_firstcol", PlanA_firstcol);
-    saveGwenesisStateSet(state, "PlanA_lastcol", PlanA_lastcol);
-    saveGwenesisStateSet(state, "Window_firstcol", Window_firstcol);
-    saveGwenesisStateSet(state, "Window_lastcol", Window_lastcol);
-    */
 }
 
 void gwenesis_vdp_gfx_load_state() {
-    /*
-      SaveState* state = saveGwenesisStateOpenForRead("vdp_gfx");
-      saveGwenesisStateGetBuffer(state, "render_buffer", render_buffer, sizeof(render_buffer));
-      saveGwenesisStateGetBuffer(state, "sprite_buffer", sprite_buffer, sizeof(sprite_buffer));
-      mode_h40 = saveGwenesisStateGet(state, "mode_h40");
-      mode_pal = saveGwenesisStateGet(state, "mode_pal");
-      screen_width = saveGwenesisStateGet(state, "screen_width");
-      screen_height = saveGwenesisStateGet(state, "screen_height");
-      sprite_overflow = saveGwenesisStateGet(state, "sprite_overflow");
-      sprite_collision = saveGwenesisStateGet(state, "sprite_collision");
-      base_w = saveGwenesisStateGet(state, "base_w");
-      PlanA_firstcol = saveGwenesisStateGet(state, "PlanA_firstcol");
-      PlanA_lastcol = saveGwenesisStateGet(state, "PlanA_lastcol");
-      Window_firstcol = saveGwenesisStateGet(state, "Window_firstcol");
-      Window_lastcol = saveGwenesisStateGet(state, "Window_lastcol");
-      */
+    SaveState* state = saveGwenesisStateOpenForRead("vdp_gfx");
+    mode_h40 = saveGwenesisStateGet(state, "mode_h40");
+    mode_pal = saveGwenesisStateGet(state, "mode_pal");
+    screen_width = saveGwenesisStateGet(state, "screen_width");
+    screen_height = saveGwenesisStateGet(state, "screen_height");
+    sprite_overflow = saveGwenesisStateGet(state, "sprite_overflow");
+    sprite_collision = saveGwenesisStateGet(state, "sprite_collision");
 }
@@ -29,6 +29,7 @@ __license__ = "GPLv3"
 
 #include <assert.h>
 #include "gwenesis_sn76489.h"
+#include "z80_core1.h"
 #include "HDMI.h"
 
 #define RGB888(r, g, b) ((r << 16) | (g << 8) | b)
@@ -808,6 +809,20 @@ void gwenesis_vdp_write_data_port_16(unsigned int value) {
     }
 }
 
+/******************************************************************************
+ *
+ *   SEGA 315-5313 Data Port block write
+ *   Write count words to the data port, as count 16-bit writes would:
+ *   words[i & wrap], wrap = ~0 streams an array, 0 or 1 repeat a word or
+ *   a long (68K dbf copy and fill loops)
+ *
+ ******************************************************************************/
+void gwenesis_vdp_write_data_port_block(const unsigned short *words,
+                                        unsigned int count, unsigned int wrap) {
+    for (unsigned int i = 0; i < count; i++)
+        gwenesis_vdp_write_data_port_16(words[i & wrap]);
+}
+
 /******************************************************************************
  *
  *   SEGA 315-5313 Get Status
@@ -892,8 +907,13 @@ void gwenesis_vdp_write_memory_16(unsigned int address, unsigned int value) {
     if (address < 0x18) {
         // PSG 8 bits write
         vdpm_log(__FUNCTION__, "PSG sclk=%d,mclk=%d", system_clock, m68k_cycles_master());
-        if(audio_enabled && sn76489_enabled)
+        if(audio_enabled && sn76489_enabled) {
+#if Z80_CORE1
+            if (z80_core1_post(m68k_cycles_master(), Z80_EV_PSG, 0, value))
+                return;
+#endif
             gwenesis_SN76489_Write(value, m68k_cycles_master());
+        }
         return;
     }
     // UNHANDLED - disabled spam
@@ -901,8 +921,44 @@ void gwenesis_vdp_write_memory_16(unsigned int address, unsigned int value) {
 }
 
 void gwenesis_vdp_mem_save_state() {
+    SaveState* state;
+    state = saveGwenesisStateOpenForWrite("vdp_mem");
+    saveGwenesisStateSetBuffer(state, "VRAM", VRAM, VRAM_MAX_SIZE);
+    saveGwenesisStateSetBuffer(state, "CRAM", CRAM, sizeof(CRAM));
+    saveGwenesisStateSetBuffer(state, "VSRAM", VSRAM, sizeof(VSRAM));
+    saveGwenesisStateSetBuffer(state, "SAT_CACHE", SAT_CACHE, sizeof(SAT_CACHE));
+    saveGwenesisStateSetBuffer(state, "gwenesis_vdp_regs", gwenesis_vdp_regs, sizeof(gwenesis_vdp_regs));
+    saveGwenesisStateSetBuffer(state, "fifo", fifo, sizeof(fifo));
+    saveGwenesisStateSet(state, "code_reg", code_reg);
+    saveGwenesisStateSet(state, "address_reg", address_reg);
+    saveGwenesisStateSet(state, "command_word_pending", command_word_pending);
+    saveGwenesisStateSet(state, "gwenesis_vdp_status", gwenesis_vdp_status);
+    saveGwenesisStateSet(state, "dma_fill_pending", dma_fill_pending);
+    saveGwenesisStateSet(state, "hvcounter_latch", hvcounter_latch);
+    saveGwenesisStateSet(state, "hvcounter_latched", hvcounter_latched);
+    saveGwenesisStateSet(state, "hint_pending", hint_pending);
 }
 
 void gwenesis_vdp_mem_load_state() {
-
+    SaveState* state = saveGwenesisStateOpenForRead("vdp_mem");
+    saveGwenesisStateGetBuffer(state, "VRAM", VRAM, VRAM_MAX_SIZE);
+    saveGwenesisStateGetBuffer(state, "CRAM", CRAM, sizeof(CRAM));
+    saveGwenesisStateGetBuffer(state, "VSRAM", VSRAM, sizeof(VSRAM));
+    saveGwenesisStateGetBuffer(state, "SAT_CACHE", SAT_CACHE, sizeof(SAT_CACHE));
+    saveGwenesisStateGetBuffer(state, "gwenesis_vdp_regs", gwenesis_vdp_regs, sizeof(gwenesis_vdp_regs));
+    saveGwenesisStateGetBuffer(state, "fifo", fifo, sizeof(fifo));
+    code_reg = saveGwenesisStateGet(state, "code_reg");
+    address_reg = saveGwenesisStateGet(state, "address_reg");
+    command_word_pending = saveGwenesisStateGet(state, "command_word_pending");
+    gwenesis_vdp_status = saveGwenesisStateGet(state, "gwenesis_vdp_status");
+    dma_fill_pending = saveGwenesisStateGet(state, "dma_fill_pending");
+    hvcounter_latch = saveGwenesisStateGet(state, "hvcounter_latch");
+    hvcounter_latched = saveGwenesisStateGet(state, "hvcounter_latched");
+    hint_pending = saveGwenesisStateGet(state, "hint_pending");
+
+    // The HDMI palette is only updated on CRAM writes: push the restored CRAM
+    for (int i = 0; i < CRAM_MAX_SIZE; i++) {
+        unsigned short value = CRAM[i];
+        graphics_set_palette(i, RGB888(CRAM_R(value), CRAM_G(value), CRAM_B(value)));
+    }
 }
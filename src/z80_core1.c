@@ -0,0 +1,309 @@
+/*
+ * Z80 and sound chips on core 1 Implementation
+ *
+ * The queue is a single-producer single-consumer ring: core 0 writes the
+ * entry, then the head; core 1 reads the head, then the entry, then
+ * releases it through the tail. The frontier packs the frame sequence
+ * above the master clock so a frontier of the previous frame is never
+ * taken for one of the current frame after the clocks were reset.
+ *
+ * Counters are totals owned by the core that updates them, the stats call
+ * reports the difference to the previous call.
+ */
+#include "z80_core1.h"
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "m68k.h"
+#include "z80inst.h"
+#include "ym2612.h"
+#include "gwenesis_sn76489.h"
+#include <stdio.h>
+
+#if Z80_CORE1
+
+#define QUEUE_MASK (Z80_CORE1_QUEUE_SIZE - 1)
+
+// Frontier: frame sequence above a 21-bit clock (313 lines * 3420 < 2^21)
+#define FRONTIER_CLOCK_BITS 21
+#define FRONTIER_CLOCK_MASK ((1u << FRONTIER_CLOCK_BITS) - 1)
+#define FRONTIER(seq, clock) (((uint32_t)(seq) << FRONTIER_CLOCK_BITS) | (clock))
+
+// Mailbox states, core 1 moves IDLE -> READ/WRITE, core 0 -> DONE
+#define MBOX_IDLE  0
+#define MBOX_READ  1
+#define MBOX_WRITE 2
+#define MBOX_DONE  3
+
+typedef struct {
+    uint32_t time;
+    uint16_t addr;
+    uint8_t value;
+    uint8_t type;
+} z80_event_t;
+
+extern unsigned char ZRAM[];
+extern bool audio_enabled;
+extern bool sn76489_enabled;
+
+volatile bool z80_core1_active = false;
+
+static z80_event_t queue[Z80_CORE1_QUEUE_SIZE];
+static volatile uint32_t queue_head = 0;   // Core 0
+static volatile uint32_t queue_tail = 0;   // Core 1
+
+static volatile uint32_t frontier = 0;     // Core 0
+static uint32_t frame_seq = 0;             // Core 0: frames started
+static volatile uint32_t frames_posted = 0;
+static volatile uint32_t frames_done = 0;  // Core 1
+static uint32_t syncs_posted = 0;          // Core 0
+static volatile uint32_t syncs_done = 0;   // Core 1
+
+static volatile uint32_t mbox_state = MBOX_IDLE;
+static volatile uint32_t mbox_addr;
+static volatile uint32_t mbox_value;
+
+// Core 1 totals
+static volatile uint32_t total_events;
+static volatile uint32_t total_z80_us;
+static volatile uint32_t total_sound_us;
+static volatile uint32_t total_idle_us;
+// Core 0 totals
+static uint32_t total_sync_wait_us;
+static uint32_t total_remote;
+static uint32_t total_queue_full;
+
+static z80_core1_stats_t last;             // Totals at the previous report
+
+void z80_core1_start(void) {
+    __dmb();
+    z80_core1_active = true;
+}
+
+void __not_in_flash_func(z80_core1_service)(void) {
+    uint32_t state = mbox_state;
+    if (state != MBOX_READ && state != MBOX_WRITE) return;
+
+    __dmb();
+    if (state == MBOX_READ) {
+        mbox_value = m68k_read_memory_8(mbox_addr);
+    } else {
+        m68k_write_memory_8(mbox_addr, mbox_value);
+    }
+    total_remote++;
+    __dmb();
+    mbox_state = MBOX_DONE;
+}
+
+bool __not_in_flash_func(z80_core1_post)(uint32_t time, z80_event_type_t type, uint16_t addr, uint8_t value) {
+    if (!z80_core1_active) return false;
+
+    uint32_t head = queue_head;
+    if (head - queue_tail >= Z80_CORE1_QUEUE_SIZE) {
+        total_queue_full++;
+        while (head - queue_tail >= Z80_CORE1_QUEUE_SIZE) {
+            z80_core1_service();
+        }
+    }
+    z80_event_t *ev = &queue[head & QUEUE_MASK];
+    ev->time = time;
+    ev->addr = addr;
+    ev->value = value;
+    ev->type = (uint8_t)type;
+    __dmb();
+    queue_head = head + 1;
+    return true;
+}
+
+void __not_in_flash_func(z80_core1_publish)(uint32_t clock) {
+    __dmb();
+    frontier = FRONTIER(frame_seq, clock & FRONTIER_CLOCK_MASK);
+}
+
+void __not_in_flash_func(z80_core1_frame_start)(void) {
+    frame_seq++;
+    frames_posted++;
+    z80_core1_post(0, Z80_EV_FRAME_START, 0, 0);
+}
+
+void __not_in_flash_func(z80_core1_frame_end)(uint32_t clock) {
+    z80_core1_post(clock, Z80_EV_FRAME_END, 0, 0);
+}
+
+void __not_in_flash_func(z80_core1_wait_frames)(uint32_t frames) {
+    while (frames_posted - frames_done > frames) {
+        z80_core1_service();
+    }
+    __dmb();
+}
+
+void z80_core1_drain(void) {
+    if (!z80_core1_active) return;
+    z80_core1_wait_frames(0);
+    while (queue_tail != queue_head) {
+        z80_core1_service();
+    }
+    __dmb();
+}
+
+void __not_in_flash_func(z80_core1_sync)(uint32_t time) {
+    uint32_t start_us = time_us_32();
+    syncs_posted++;
+    z80_core1_post(time, Z80_EV_SYNC, 0, 0);
+    while (syncs_done != syncs_posted) {
+        z80_core1_service();
+    }
+    __dmb();
+    total_sync_wait_us += time_us_32() - start_us;
+}
+
+// Hand an access to core 0 and wait for it (core 1)
+static uint32_t __not_in_flash_func(remote_access)(uint32_t state, uint32_t address, uint32_t value) {
+    mbox_addr = address;
+    mbox_value = value;
+    __dmb();
+    mbox_state = state;
+    while (mbox_state != MBOX_DONE) {
+        tight_loop_contents();
+    }
+    __dmb();
+    value = mbox_value;
+    mbox_state = MBOX_IDLE;
+    return value;
+}
+
+static inline bool z80_own_bus(unsigned int address) {
+    return (address & 0xFE0000) == 0xA00000;
+}
+
+unsigned int __not_in_flash_func(z80_core1_bank_read)(unsigned int address) {
+    if (address >= 0xE00000) return FETCH8RAM(address);
+    if (z80_own_bus(address)) return 0xFF;
+    return remote_access(MBOX_READ, address, 0);
+}
+
+void __not_in_flash_func(z80_core1_bank_write)(unsigned int address, unsigned int value) {
+    if (address >= 0xE00000) {
+        WRITE8RAM(address, value);
+        return;
+    }
+    if (z80_own_bus(address)) return;
+    // PSG port of the VDP (0xC00011 and mirrors) belongs to this core
+    if ((address & 0xE00000) == 0xC00000 && (address & 0x1F) >= 0x10 && (address & 0x1F) < 0x18) {
+        if (audio_enabled && sn76489_enabled)
+            gwenesis_SN76489_Write(value, z80_cycles_master());
+        return;
+    }
+    remote_access(MBOX_WRITE, address, value);
+}
+
+// Run the Z80 up to `time`, accounting the core 1 time
+static inline void run_z80(uint32_t time) {
+    extern volatile int zclk;
+    if ((int)time <= zclk) return;
+    uint32_t start_us = time_us_32();
+    z80_run((int)time);
+    total_z80_us += time_us_32() - start_us;
+}
+
+void __not_in_flash_func(z80_core1_loop)(z80_core1_frame_cb_t frame_start, z80_core1_frame_cb_t frame_end,
+                                         z80_core1_frame_cb_t idle) {
+    uint32_t seq = 0;
+    bool in_frame = false;
+
+    while (1) {
+        uint32_t tail = queue_tail;
+        if (tail != queue_head) {
+            __dmb();
+            z80_event_t ev = queue[tail & QUEUE_MASK];
+            if (ev.type != Z80_EV_FRAME_START) run_z80(ev.time);
+
+            switch (ev.type) {
+                case Z80_EV_CTRL:
+                    z80_apply_ctrl(ev.addr, ev.value);
+                    break;
+                case Z80_EV_RAM:
+                    ZRAM[ev.addr & 0x1FFF] = ev.value;
+                    break;
+                case Z80_EV_YM:
+                    YM2612Write(ev.addr, ev.value, (int)ev.time);
+                    break;
+                case Z80_EV_PSG:
+                    gwenesis_SN76489_Write(ev.value, (int)ev.time);
+                    break;
+                case Z80_EV_IRQ:
+                    z80_irq_line(ev.value);
+                    break;
+                case Z80_EV_BANKMAP:
+                    z80_bank_cache_invalidate();
+                    break;
+                case Z80_EV_SYNC:
+                    ym2612_run((int)ev.time);
+                    __dmb();
+                    syncs_done++;
+                    break;
+                case Z80_EV_FRAME_START:
+                    seq++;
+                    in_frame = true;
+                    frame_start();
+                    break;
+                case Z80_EV_FRAME_END: {
+                    uint32_t start_us = time_us_32();
+                    frame_end();
+                    total_sound_us += time_us_32() - start_us;
+                    in_frame = false;
+                    __dmb();
+                    frames_done++;
+                    break;
+                }
+                default:
+                    break;
+            }
+            total_events++;
+            __dmb();
+            queue_tail = tail + 1;
+            continue;
+        }
+
+        // Nothing queued: catch up with the 68K within the frame
+        uint32_t f = frontier;
+        if (in_frame && (f >> FRONTIER_CLOCK_BITS) == (seq & (UINT32_MAX >> FRONTIER_CLOCK_BITS))) {
+            extern volatile int zclk;
+            uint32_t clock = f & FRONTIER_CLOCK_MASK;
+            if ((int)clock > zclk) {
+                __dmb();
+                run_z80(clock);
+                continue;
+            }
+        }
+
+        uint32_t start_us = time_us_32();
+        idle();
+        total_idle_us += time_us_32() - start_us;
+    }
+}
+
+void z80_core1_get_stats(z80_core1_stats_t *out) {
+    z80_core1_stats_t now = {
+        .frames = frames_done,
+        .events = total_events,
+        .z80_us = total_z80_us,
+        .sound_us = total_sound_us,
+        .idle_us = total_idle_us,
+        .syncs = syncs_posted,
+        .sync_wait_us = total_sync_wait_us,
+        .remote = total_remote,
+        .queue_full = total_queue_full,
+    };
+    out->frames = now.frames - last.frames;
+    out->events = now.events - last.events;
+    out->z80_us = now.z80_us - last.z80_us;
+    out->sound_us = now.sound_us - last.sound_us;
+    out->idle_us = now.idle_us - last.idle_us;
+    out->syncs = now.syncs - last.syncs;
+    out->sync_wait_us = now.sync_wait_us - last.sync_wait_us;
+    out->remote = now.remote - last.remote;
+    out->queue_full = now.queue_full - last.queue_full;
+    last = now;
+}
+
+#endif // Z80_CORE1
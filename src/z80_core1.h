@@ -0,0 +1,147 @@
+/*
+ * Z80 and sound chips on core 1
+ *
+ * Build with Z80_CORE1=1 to move the Z80, the YM2612, the PSG and the
+ * audio hand-off to core 1. Core 0 keeps the M68K and the VDP and talks to
+ * the Z80 side through a single-producer queue of events stamped with the
+ * 68K master clock:
+ *   CTRL      - BUSREQ/RESET writes
+ *   RAM       - 68K writes into Z80 RAM
+ *   YM, PSG   - 68K writes to the sound chips
+ *   IRQ       - vblank interrupt line of the Z80
+ *   BANKMAP   - cartridge mapper changes (drops the Z80 bank cache)
+ *   SYNC      - core 0 waits until the Z80 side reached the time
+ *   FRAME_*   - frame boundaries (clock reset, audio hand-off)
+ * Core 1 applies each event after running the Z80 up to its time, and in
+ * between runs the Z80 up to the frontier core 0 publishes after every
+ * line, so the Z80 trails the 68K by at most one line.
+ *
+ * Synchronization rules:
+ *   - 68K reads of Z80 RAM and of the YM2612 status post a SYNC and wait
+ *     for it: the value read is exact.
+ *   - BUSREQ/RESET reads are answered on core 0 from the last 68K writes.
+ *   - Z80 bank reads and writes of 68K RAM access it directly (the 68K may
+ *     be up to a line ahead). PSG writes are applied on core 1. Other 68K
+ *     addresses (VDP, I/O) go through a mailbox that core 0 serves once
+ *     per line and while it waits; Z80 accesses to its own bus through the
+ *     bank window read 0xFF and are dropped.
+ *   - Menus, savestates, quick saves and rewind drain the queue first,
+ *     core 1 is idle between frames after that.
+ * Run-ahead needs the whole machine on one core and is off in this mode.
+ */
+#ifndef Z80_CORE1_H
+#define Z80_CORE1_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef Z80_CORE1
+#define Z80_CORE1 0
+#endif
+
+// Queued events (power of two)
+#ifndef Z80_CORE1_QUEUE_SIZE
+#define Z80_CORE1_QUEUE_SIZE 1024
+#endif
+
+#if Z80_CORE1
+
+typedef enum {
+    Z80_EV_CTRL = 0,
+    Z80_EV_RAM,
+    Z80_EV_YM,
+    Z80_EV_PSG,
+    Z80_EV_IRQ,
+    Z80_EV_BANKMAP,
+    Z80_EV_SYNC,
+    Z80_EV_FRAME_START,
+    Z80_EV_FRAME_END,
+} z80_event_type_t;
+
+typedef struct {
+    uint32_t frames;       // Frames finished on core 1 since the last call
+    uint32_t events;       // Events applied
+    uint32_t z80_us;       // Core 1 time in the Z80
+    uint32_t sound_us;     // ... in the sound chips and the audio hand-off
+    uint32_t idle_us;      // ... waiting for core 0
+    uint32_t syncs;        // SYNC round trips
+    uint32_t sync_wait_us; // Core 0 time waiting for them
+    uint32_t remote;       // Z80 accesses served by core 0
+    uint32_t queue_full;   // Posts that waited for room
+} z80_core1_stats_t;
+
+// Core 1 runs frame callbacks: start resets the clocks, end finishes the
+// frame's samples and hands them to the audio output
+typedef void (*z80_core1_frame_cb_t)(void);
+
+// Set once core 0 starts posting, read by the Z80 bus handlers
+extern volatile bool z80_core1_active;
+
+/**
+ * Start routing the Z80 side to core 1 (core 0, entering gameplay)
+ */
+void z80_core1_start(void);
+
+/**
+ * Queue an event, returns false when the mode is not active and the
+ * caller applies it itself (core 0)
+ */
+bool z80_core1_post(uint32_t time, z80_event_type_t type, uint16_t addr, uint8_t value);
+
+/**
+ * Let the Z80 run up to `clock` of the current frame (core 0, per line)
+ */
+void z80_core1_publish(uint32_t clock);
+
+/**
+ * Frame boundaries (core 0). The frame ends at `clock`.
+ */
+void z80_core1_frame_start(void);
+void z80_core1_frame_end(uint32_t clock);
+
+/**
+ * Wait until at most `frames` posted frames are unfinished (core 0)
+ */
+void z80_core1_wait_frames(uint32_t frames);
+
+/**
+ * Wait until core 1 applied everything posted, it is idle after (core 0)
+ */
+void z80_core1_drain(void);
+
+/**
+ * Wait until the Z80 and the YM2612 reached `time` (core 0)
+ */
+void z80_core1_sync(uint32_t time);
+
+/**
+ * Serve a pending Z80 access to 68K space (core 0)
+ */
+void z80_core1_service(void);
+
+/**
+ * Z80 bank window accesses outside the ROM (core 1)
+ */
+unsigned int z80_core1_bank_read(unsigned int address);
+void z80_core1_bank_write(unsigned int address, unsigned int value);
+
+/**
+ * Core 1 main loop, never returns. `idle` runs while there is nothing
+ * to do (input polling).
+ */
+void z80_core1_loop(z80_core1_frame_cb_t frame_start, z80_core1_frame_cb_t frame_end,
+                    z80_core1_frame_cb_t idle);
+
+/**
+ * Counters since the previous call (core 0)
+ */
+void z80_core1_get_stats(z80_core1_stats_t *out);
+
+#else
+
+#define z80_core1_start()
+#define z80_core1_drain()
+
+#endif // Z80_CORE1
+
+#endif // Z80_CORE1_H
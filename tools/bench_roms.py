@@ -0,0 +1,883 @@
+#!/usr/bin/env python3
+"""
+Benchmark ROMs: build the homebrew workload ROMs of bench/ and summarize
+benchmark runs.
+
+  build  - assemble bench/*.s (68000, Motorola syntax) into bench/*.bin.
+           The assembler below covers what the ROM sources use: the 68000
+           integer instructions, equ/=, dc/dcb/ds, even/align/org, include,
+           fail, rept/endr and macro/endm with \\1..\\9 and \\@ parameters.
+           Local labels start with a dot and belong to the previous global
+           label. PC-relative operands name their target, as in
+           `lea table(pc),a0`. The header checksum at $18E is filled in.
+  report - collect the BENCH lines a BENCH_FRAMES=N build prints over UART
+           (see src/bench.h) into one table, one row per ROM and log, so
+           runs of different builds or boards can be compared.
+
+Usage:
+  bench_roms.py build [--dir bench] [rom.s ...]
+  bench_roms.py report log [log ...]
+"""
+import argparse
+import functools
+import glob
+import operator
+import os
+import re
+import sys
+
+SIZES = {'b': 1, 'w': 2, 'l': 4, 's': 1}
+SIZE_BITS = {1: 0, 2: 1, 4: 2}           # ss field of most instructions
+MOVE_SIZE_BITS = {1: 1, 2: 3, 4: 2}      # MOVE encodes sizes differently
+
+CONDITIONS = {
+    't': 0, 'f': 1, 'hi': 2, 'ls': 3, 'cc': 4, 'hs': 4, 'cs': 5, 'lo': 5,
+    'ne': 6, 'eq': 7, 'vc': 8, 'vs': 9, 'pl': 10, 'mi': 11, 'ge': 12,
+    'lt': 13, 'gt': 14, 'le': 15,
+}
+
+# Addressing modes
+DREG, AREG, IND, POSTINC, PREDEC, DISP, INDEX, ABSW, ABSL, PCDISP, PCINDEX, IMM, \
+    SR, CCR, REGLIST = range(15)
+
+RE_REG = re.compile(r'^(d[0-7]|a[0-7]|sp)$', re.I)
+RE_IND = re.compile(r'^\((a[0-7]|sp)\)$', re.I)
+RE_POSTINC = re.compile(r'^\((a[0-7]|sp)\)\+$', re.I)
+RE_PREDEC = re.compile(r'^-\((a[0-7]|sp)\)$', re.I)
+RE_BASE = re.compile(r'^(.*)\(\s*(a[0-7]|sp|pc)\s*(?:,\s*([da][0-7]|sp)(\.[wl])?\s*)?\)$', re.I)
+RE_REGLIST = re.compile(r'^([da][0-7]|sp)(-([da][0-7]))?(/([da][0-7]|sp)(-([da][0-7]))?)*$', re.I)
+RE_SYMBOL = re.compile(r'[A-Za-z_.][A-Za-z0-9_.]*')
+
+
+class AsmError(Exception):
+    pass
+
+
+def reg_num(name):
+    """(is_address, number) of a register name."""
+    name = name.lower()
+    if name == 'sp':
+        return True, 7
+    return name[0] == 'a', int(name[1])
+
+
+class Operand:
+    def __init__(self, mode, reg=0, expr=None, index=None, size=None):
+        self.mode = mode
+        self.reg = reg          # Register number, register mask for REGLIST
+        self.expr = expr        # Displacement, address or immediate
+        self.index = index      # (is_address, number, long) of INDEX modes
+        self.size = size
+
+
+class Assembler:
+    def __init__(self, path):
+        self.base_dir = os.path.dirname(os.path.abspath(path))
+        self.path = path
+        self.symbols = {}
+        self.macros = {}
+        self.macro_count = 0
+
+    # ---------------------------------------------------------------- source
+
+    def read_lines(self, path, depth=0):
+        """Source lines with includes, macros and rept blocks expanded."""
+        if depth > 16:
+            raise AsmError('include nesting too deep')
+        full = os.path.join(self.base_dir, path)
+        with open(full) as f:
+            raw = [(path, n + 1, line.rstrip('\n')) for n, line in enumerate(f)]
+        return self.expand(raw, depth)
+
+    def expand(self, raw, depth):
+        out = []
+        i = 0
+        while i < len(raw):
+            where = raw[i]
+            label, op, args = split_line(where[2])
+            low = op.lower()
+            if low == 'macro':
+                body, i = self.block(raw, i + 1, 'macro', 'endm')
+                self.macros[label.lower()] = body
+                continue
+            if low == 'rept':
+                body, i = self.block(raw, i + 1, 'rept', 'endr')
+                count = self.eval_now(args[0], where)
+                if label:
+                    out.append((where[0], where[1], label))
+                for _ in range(count):
+                    out.extend(self.expand(body, depth))
+                continue
+            if low in ('equ', '=') and label and not label.startswith('.'):
+                # Known early so rept counts can use it
+                try:
+                    self.symbols[label] = self.evaluate(args[0], 0, None, True)
+                except AsmError:
+                    pass
+            if low == 'include':
+                if label:
+                    out.append((where[0], where[1], label))
+                out.extend(self.read_lines(unquote(args[0]), depth + 1))
+            elif low in self.macros:
+                self.macro_count += 1
+                if label:
+                    out.append((where[0], where[1], label))
+                body = []
+                for (p, n, text) in self.macros[low]:
+                    text = text.replace('\\@', '_%d' % self.macro_count)
+                    for k in range(9, 0, -1):
+                        text = text.replace('\\%d' % k, args[k - 1] if k <= len(args) else '')
+                    body.append((p, n, text))
+                out.extend(self.expand(body, depth))
+            else:
+                out.append(where)
+            i += 1
+        return out
+
+    def block(self, raw, i, start, end):
+        body = []
+        nested = 0
+        while i < len(raw):
+            op = split_line(raw[i][2])[1].lower()
+            if op == start:
+                nested += 1
+            elif op == end:
+                if nested == 0:
+                    return body, i + 1
+                nested -= 1
+            body.append(raw[i])
+            i += 1
+        raise AsmError('%s without %s' % (start, end))
+
+    def eval_now(self, text, where):
+        try:
+            return self.evaluate(text, 0, None, True)
+        except AsmError as e:
+            raise AsmError('%s:%d: %s' % (where[0], where[1], e))
+
+    # ----------------------------------------------------------- expressions
+
+    def evaluate(self, text, pc, scope, final):
+        """Value of an expression. Unknown symbols are 0 until the final pass."""
+        def resolve(name):
+            full = self.qualify(name, scope)
+            if full in self.symbols:
+                return self.symbols[full]
+            if final:
+                raise AsmError('undefined symbol %s' % name)
+            return 0
+        return parse_expression(text)(resolve, pc)
+
+    def qualify(self, name, scope):
+        if name.startswith('.') and scope:
+            return scope + name
+        return name
+
+    # -------------------------------------------------------------- operands
+
+    def operand(self, text):
+        s = text.strip()
+        low = s.lower()
+        if low == 'sr':
+            return Operand(SR)
+        if low == 'ccr':
+            return Operand(CCR)
+        if s.startswith('#'):
+            return Operand(IMM, expr=s[1:])
+        if RE_REG.match(s):
+            is_a, n = reg_num(s)
+            return Operand(AREG if is_a else DREG, n)
+        m = RE_IND.match(s)
+        if m:
+            return Operand(IND, reg_num(m.group(1))[1])
+        m = RE_POSTINC.match(s)
+        if m:
+            return Operand(POSTINC, reg_num(m.group(1))[1])
+        m = RE_PREDEC.match(s)
+        if m:
+            return Operand(PREDEC, reg_num(m.group(1))[1])
+        if RE_REGLIST.match(s) and ('/' in s or '-' in s):
+            return Operand(REGLIST, reglist_mask(s))
+        m = RE_BASE.match(s)
+        if m:
+            disp = m.group(1).strip() or '0'
+            if disp.startswith('(') and disp.endswith(','):
+                raise AsmError('bad operand "%s"' % text)
+            base = m.group(2).lower()
+            index = None
+            if m.group(3):
+                is_a, n = reg_num(m.group(3))
+                index = (is_a, n, (m.group(4) or '.w').lower() == '.l')
+            if base == 'pc':
+                return Operand(PCINDEX if index else PCDISP, 0, disp, index)
+            reg = reg_num(base)[1]
+            return Operand(INDEX if index else DISP, reg, disp, index)
+        if low.endswith('.w') and len(s) > 2:
+            return Operand(ABSW, expr=s[:-2])
+        if low.endswith('.l') and len(s) > 2:
+            return Operand(ABSL, expr=s[:-2])
+        return Operand(ABSL, expr=s)
+
+    def ea_field(self, op):
+        """6-bit mode/register field of an effective address."""
+        if op.mode in (DREG, AREG, IND, POSTINC, PREDEC, DISP, INDEX):
+            return ((op.mode - DREG) << 3) | op.reg
+        return {ABSW: 0x38, ABSL: 0x39, PCDISP: 0x3A, PCINDEX: 0x3B, IMM: 0x3C}[op.mode]
+
+    def ea_words(self, op, size, pc, ctx):
+        """Extension words of an effective address whose first word is at pc."""
+        if op.mode in (DREG, AREG, IND, POSTINC, PREDEC):
+            return []
+        if op.mode == DISP:
+            return [self.word(ctx.value(op.expr), ctx, signed=True)]
+        if op.mode == INDEX:
+            return [self.brief(op, ctx.value(op.expr), ctx)]
+        if op.mode == ABSW:
+            return [self.word(ctx.value(op.expr), ctx, signed=True, either=True)]
+        if op.mode == ABSL:
+            v = ctx.value(op.expr) & 0xFFFFFFFF
+            return [v >> 16, v & 0xFFFF]
+        if op.mode == PCDISP:
+            return [self.word(ctx.value(op.expr) - pc, ctx, signed=True)]
+        if op.mode == PCINDEX:
+            return [self.brief(op, ctx.value(op.expr) - pc, ctx)]
+        if op.mode == IMM:
+            v = ctx.value(op.expr)
+            if size == 4:
+                v &= 0xFFFFFFFF
+                return [v >> 16, v & 0xFFFF]
+            if size == 1:
+                self.check(v, -0x80, 0xFF, ctx)
+                return [v & 0xFF]
+            return [self.word(v, ctx, signed=False, either=True)]
+        raise AsmError('operand not allowed here')
+
+    def ea_size(self, op, size):
+        if op.mode in (DREG, AREG, IND, POSTINC, PREDEC):
+            return 0
+        if op.mode in (ABSL,) or (op.mode == IMM and size == 4):
+            return 2
+        if op.mode in (SR, CCR, REGLIST):
+            raise AsmError('operand not allowed here')
+        return 1
+
+    def brief(self, op, disp, ctx):
+        self.check(disp, -0x80, 0x7F, ctx)
+        is_a, n, long_index = op.index
+        return (is_a << 15) | (n << 12) | (long_index << 11) | (disp & 0xFF)
+
+    def word(self, v, ctx, signed, either=False):
+        if either:
+            self.check(v, -0x8000, 0xFFFF, ctx)
+        elif signed:
+            self.check(v, -0x8000, 0x7FFF, ctx)
+        else:
+            self.check(v, 0, 0xFFFF, ctx)
+        return v & 0xFFFF
+
+    def check(self, v, lo, hi, ctx):
+        if ctx.final and not lo <= v <= hi:
+            raise AsmError('value %d out of range' % v)
+
+    # ---------------------------------------------------------- instructions
+
+    def instruction(self, mnemonic, args, pc, ctx):
+        """Words of one instruction at pc."""
+        name, _, suffix = mnemonic.lower().partition('.')
+        if suffix and suffix not in SIZES:
+            raise AsmError('bad size .%s' % suffix)
+        size = SIZES.get(suffix, 2)
+        ops = [self.operand(a) for a in args]
+
+        def ea(i, sz=size, first=1):
+            # Extension words of operand i, first = words before them
+            return self.ea_words(ops[i], sz, pc + 2 * first, ctx)
+
+        def nargs(n):
+            if len(ops) != n:
+                raise AsmError('%s takes %d operand(s)' % (name, n))
+
+        def need(i, *modes):
+            if ops[i].mode not in modes:
+                raise AsmError('bad operand %d for %s' % (i + 1, name))
+
+        data_alterable = (DREG, IND, POSTINC, PREDEC, DISP, INDEX, ABSW, ABSL)
+        memory_alterable = (IND, POSTINC, PREDEC, DISP, INDEX, ABSW, ABSL)
+        any_ea = data_alterable + (AREG, PCDISP, PCINDEX, IMM)
+        control = (IND, DISP, INDEX, ABSW, ABSL, PCDISP, PCINDEX)
+
+        if name in ('nop', 'rts', 'rte', 'reset'):
+            nargs(0)
+            return [{'nop': 0x4E71, 'rts': 0x4E75, 'rte': 0x4E73, 'reset': 0x4E70}[name]]
+        if name == 'stop':
+            nargs(1)
+            need(0, IMM)
+            return [0x4E72] + ea(0, 2)
+        if name == 'trap':
+            nargs(1)
+            need(0, IMM)
+            return [0x4E40 | (ctx.value(ops[0].expr) & 15)]
+
+        if name == 'move':
+            nargs(2)
+            src, dst = ops
+            if dst.mode == SR:
+                need(0, *(data_alterable + (IMM, PCDISP, PCINDEX)))
+                return [0x46C0 | self.ea_field(src)] + ea(0, 2)
+            if dst.mode == CCR:
+                return [0x44C0 | self.ea_field(src)] + ea(0, 2)
+            if src.mode == SR:
+                need(1, *data_alterable)
+                return [0x40C0 | self.ea_field(dst)] + ea(1, 2)
+            if dst.mode == AREG:
+                name = 'movea'
+            else:
+                need(0, *any_ea)
+                need(1, *data_alterable)
+                if src.mode == AREG and size == 1:
+                    raise AsmError('move.b from an address register')
+                d = self.ea_field(dst)
+                d = ((d & 7) << 3) | (d >> 3)
+                words = ea(0)
+                return [(MOVE_SIZE_BITS[size] << 12) | (d << 6) | self.ea_field(src)] + \
+                    words + ea(1, size, 1 + len(words))
+        if name == 'movea':
+            nargs(2)
+            need(0, *any_ea)
+            need(1, AREG)
+            if size == 1:
+                raise AsmError('movea.b')
+            return [(MOVE_SIZE_BITS[size] << 12) | (ops[1].reg << 9) | (1 << 6) |
+                    self.ea_field(ops[0])] + ea(0)
+        if name == 'moveq':
+            nargs(2)
+            need(0, IMM)
+            need(1, DREG)
+            v = ctx.value(ops[0].expr)
+            self.check(v, -0x80, 0x7F, ctx)
+            return [0x7000 | (ops[1].reg << 9) | (v & 0xFF)]
+        if name == 'movem':
+            nargs(2)
+            size = 4 if suffix == 'l' else 2
+            if ops[0].mode in (REGLIST, DREG, AREG):
+                regs, dst, to_memory = ops[0], ops[1], True
+                need(1, IND, PREDEC, DISP, INDEX, ABSW, ABSL)
+            else:
+                regs, dst, to_memory = ops[1], ops[0], False
+                need(0, IND, POSTINC, DISP, INDEX, ABSW, ABSL, PCDISP, PCINDEX)
+            mask = regs.reg if regs.mode == REGLIST else 1 << (regs.reg + (8 if regs.mode == AREG else 0))
+            if dst.mode == PREDEC:
+                mask = int('{:016b}'.format(mask)[::-1], 2)
+            ea_index = 1 if to_memory else 0
+            return [0x4880 | ((not to_memory) << 10) | ((size == 4) << 6) | self.ea_field(dst), mask] + \
+                ea(ea_index, size, 2)
+        if name == 'lea':
+            nargs(2)
+            need(0, *control)
+            need(1, AREG)
+            return [0x41C0 | (ops[1].reg << 9) | self.ea_field(ops[0])] + ea(0, 4)
+        if name == 'pea':
+            nargs(1)
+            need(0, *control)
+            return [0x4840 | self.ea_field(ops[0])] + ea(0, 4)
+        if name in ('jmp', 'jsr'):
+            nargs(1)
+            need(0, *control)
+            return [(0x4EC0 if name == 'jmp' else 0x4E80) | self.ea_field(ops[0])] + ea(0, 4)
+
+        if name in ('clr', 'neg', 'not', 'tst', 'negx'):
+            nargs(1)
+            need(0, *data_alterable)
+            base = {'clr': 0x4200, 'neg': 0x4400, 'not': 0x4600, 'tst': 0x4A00, 'negx': 0x4000}[name]
+            return [base | (SIZE_BITS[size] << 6) | self.ea_field(ops[0])] + ea(0)
+        if name == 'ext':
+            nargs(1)
+            need(0, DREG)
+            return [(0x48C0 if size == 4 else 0x4880) | ops[0].reg]
+        if name == 'swap':
+            nargs(1)
+            need(0, DREG)
+            return [0x4840 | ops[0].reg]
+        if name == 'exg':
+            nargs(2)
+            a, b = ops
+            if a.mode == DREG and b.mode == DREG:
+                return [0xC140 | (a.reg << 9) | b.reg]
+            if a.mode == AREG and b.mode == AREG:
+                return [0xC148 | (a.reg << 9) | b.reg]
+            if a.mode == AREG:
+                a, b = b, a
+            return [0xC188 | (a.reg << 9) | b.reg]
+
+        if name in ('add', 'sub', 'and', 'or', 'cmp', 'eor', 'adda', 'suba', 'cmpa',
+                    'addi', 'subi', 'andi', 'ori', 'cmpi', 'eori'):
+            nargs(2)
+            src, dst = ops
+            base = 'and' if name.startswith('and') else name.rstrip('ai')
+            if dst.mode == AREG and base in ('add', 'sub', 'cmp'):
+                if size == 1:
+                    raise AsmError('%s.b to an address register' % base)
+                opcode = {'add': 0xD000, 'sub': 0x9000, 'cmp': 0xB000}[base]
+                return [opcode | (dst.reg << 9) | ((7 if size == 4 else 3) << 6) |
+                        self.ea_field(src)] + ea(0)
+            if src.mode == IMM:
+                if dst.mode in (SR, CCR):
+                    opcode = {'and': 0x023C, 'or': 0x003C, 'eor': 0x0A3C}[base]
+                    return [opcode | (0x40 if dst.mode == SR else 0)] + ea(0, 2 if dst.mode == SR else 1)
+                need(1, *(data_alterable + ((PCDISP, PCINDEX) if base == 'cmp' else ())))
+                opcode = {'or': 0x0000, 'and': 0x0200, 'sub': 0x0400, 'add': 0x0600,
+                          'eor': 0x0A00, 'cmp': 0x0C00}[base]
+                words = ea(0)
+                return [opcode | (SIZE_BITS[size] << 6) | self.ea_field(dst)] + \
+                    words + ea(1, size, 1 + len(words))
+            if base == 'eor':
+                need(0, DREG)
+                need(1, *data_alterable)
+                return [0xB100 | (src.reg << 9) | (SIZE_BITS[size] << 6) | self.ea_field(dst)] + ea(1)
+            opcode = {'add': 0xD000, 'sub': 0x9000, 'and': 0xC000, 'or': 0x8000, 'cmp': 0xB000}[base]
+            if dst.mode == DREG:
+                need(0, *any_ea)
+                if src.mode == AREG and (size == 1 or base in ('and', 'or')):
+                    raise AsmError('bad source for %s' % name)
+                return [opcode | (dst.reg << 9) | (SIZE_BITS[size] << 6) | self.ea_field(src)] + ea(0)
+            if base == 'cmp':
+                raise AsmError('cmp needs a data register destination')
+            need(0, DREG)
+            need(1, *memory_alterable)
+            return [opcode | (src.reg << 9) | ((4 + SIZE_BITS[size]) << 6) | self.ea_field(dst)] + ea(1)
+
+        if name in ('addq', 'subq'):
+            nargs(2)
+            need(0, IMM)
+            v = ctx.value(ops[0].expr)
+            if ctx.final and not 1 <= v <= 8:
+                raise AsmError('%s data must be 1..8' % name)
+            if ops[1].mode == AREG and size == 1:
+                raise AsmError('%s.b to an address register' % name)
+            if ops[1].mode != AREG:
+                need(1, *data_alterable)
+            return [(0x5000 if name == 'addq' else 0x5100) | ((v & 7) << 9) |
+                    (SIZE_BITS[size] << 6) | self.ea_field(ops[1])] + ea(1, size)
+
+        shifts = {'as': 0, 'ls': 1, 'rox': 2, 'ro': 3}
+        m = re.match(r'^(as|ls|rox|ro)([lr])$', name)
+        if m:
+            kind, left = shifts[m.group(1)], m.group(2) == 'l'
+            if len(ops) == 1:
+                need(0, *memory_alterable)
+                return [0xE0C0 | (kind << 9) | (left << 8) | self.ea_field(ops[0])] + ea(0)
+            nargs(2)
+            need(1, DREG)
+            if ops[0].mode == IMM:
+                v = ctx.value(ops[0].expr)
+                if ctx.final and not 1 <= v <= 8:
+                    raise AsmError('shift count must be 1..8')
+                count, by_reg = v & 7, 0
+            else:
+                need(0, DREG)
+                count, by_reg = ops[0].reg, 1
+            return [0xE000 | (count << 9) | (left << 8) | (SIZE_BITS[size] << 6) |
+                    (by_reg << 5) | (kind << 3) | ops[1].reg]
+
+        if name in ('mulu', 'muls', 'divu', 'divs'):
+            nargs(2)
+            need(1, DREG)
+            opcode = {'mulu': 0xC0C0, 'muls': 0xC1C0, 'divu': 0x80C0, 'divs': 0x81C0}[name]
+            return [opcode | (ops[1].reg << 9) | self.ea_field(ops[0])] + ea(0, 2)
+
+        if name in ('btst', 'bchg', 'bclr', 'bset'):
+            nargs(2)
+            kind = ('btst', 'bchg', 'bclr', 'bset').index(name)
+            if ops[0].mode == IMM:
+                bit = ctx.value(ops[0].expr)
+                words = [0x0800 | (kind << 6) | self.ea_field(ops[1]), bit & 0xFF]
+                return words + ea(1, 1, 2)
+            need(0, DREG)
+            return [0x0100 | (ops[0].reg << 9) | (kind << 6) | self.ea_field(ops[1])] + ea(1, 1)
+
+        if name in ('bra', 'bsr') or (name[0] == 'b' and name[1:] in CONDITIONS and name[1:] not in ('t', 'f')):
+            nargs(1)
+            cond = {'bra': 0, 'bsr': 1}.get(name, CONDITIONS.get(name[1:]))
+            target = ctx.value(ops[0].expr)
+            disp = target - (pc + 2)
+            if suffix == 's' or suffix == 'b':
+                if ctx.final and (not -128 <= disp <= 127 or disp in (0, -1)):
+                    raise AsmError('short branch out of range (%d)' % disp)
+                return [0x6000 | (cond << 8) | (disp & 0xFF)]
+            return [0x6000 | (cond << 8), self.word(disp, ctx, signed=True)]
+        if name.startswith('db') and (name[2:] in CONDITIONS or name == 'dbra'):
+            nargs(2)
+            need(0, DREG)
+            cond = 1 if name == 'dbra' else CONDITIONS[name[2:]]
+            disp = ctx.value(ops[1].expr) - (pc + 2)
+            return [0x50C8 | (cond << 8) | ops[0].reg, self.word(disp, ctx, signed=True)]
+        if name.startswith('s') and name[1:] in CONDITIONS:
+            nargs(1)
+            need(0, *data_alterable)
+            return [0x50C0 | (CONDITIONS[name[1:]] << 8) | self.ea_field(ops[0])] + ea(0, 1)
+
+        raise AsmError('unknown instruction %s' % mnemonic)
+
+    # ------------------------------------------------------------- assembly
+
+    def assemble(self):
+        lines = self.read_lines(os.path.basename(self.path))
+        previous = None
+        for final in (False, False, True):
+            image = self.run(lines, final)
+            if not final:
+                if previous == self.symbols:
+                    image = self.run(lines, True)
+                    break
+                previous = dict(self.symbols)
+        return image
+
+    def run(self, lines, final):
+        out = bytearray()
+        scope = None
+
+        class Context:
+            pass
+
+        ctx = Context()
+        ctx.final = final
+
+        for (path, number, text) in lines:
+            try:
+                label, op, args = split_line(text)
+                pc = len(out)
+                ctx.value = lambda e, pc=pc: self.evaluate(e, pc, scope, final)
+                low = op.lower()
+                if low in ('equ', '='):
+                    self.symbols[self.qualify(label, scope)] = self.evaluate(args[0], pc, scope, final)
+                    continue
+                if label:
+                    if not label.startswith('.'):
+                        scope = label
+                    self.symbols[self.qualify(label, scope)] = pc
+                if not op:
+                    continue
+                if low.startswith('dc.'):
+                    size = SIZES[low[3:]]
+                    for a in args:
+                        if a.startswith('"'):
+                            if size != 1:
+                                raise AsmError('strings need dc.b')
+                            out += unquote(a).encode('ascii')
+                            continue
+                        v = ctx.value(a)
+                        self.check(v, -(1 << (8 * size - 1)), (1 << (8 * size)) - 1, ctx)
+                        out += (v & ((1 << (8 * size)) - 1)).to_bytes(size, 'big')
+                elif low.startswith('dcb.') or low.startswith('ds.'):
+                    size = SIZES[low.split('.')[1]]
+                    count = ctx.value(args[0])
+                    fill = ctx.value(args[1]) if len(args) > 1 else 0
+                    out += (fill & ((1 << (8 * size)) - 1)).to_bytes(size, 'big') * count
+                elif low == 'even':
+                    if len(out) & 1:
+                        out.append(0)
+                elif low == 'align':
+                    boundary = 1 << ctx.value(args[0])
+                    out += bytes((-len(out)) % boundary)
+                elif low in ('org',):
+                    target = ctx.value(args[0])
+                    if target < len(out):
+                        raise AsmError('org moves backwards')
+                    out += bytes(target - len(out))
+                elif low == 'fail':
+                    raise AsmError(' '.join(args) or 'fail')
+                else:
+                    if len(out) & 1:
+                        raise AsmError('instruction at an odd address')
+                    for w in self.instruction(op, args, pc, ctx):
+                        out += (w & 0xFFFF).to_bytes(2, 'big')
+            except AsmError as e:
+                raise AsmError('%s:%d: %s\n    %s' % (path, number, e, text.strip()))
+            except (ValueError, KeyError, IndexError) as e:
+                raise AsmError('%s:%d: cannot parse (%s)\n    %s' % (path, number, e, text.strip()))
+        return out
+
+
+def divide(a, b):
+    q = abs(a) // abs(b)
+    return -q if (a < 0) != (b < 0) else q
+
+
+BINARY_LEVELS = [
+    {'|': operator.or_},
+    {'^': operator.xor},
+    {'&': operator.and_},
+    {'<<': operator.lshift, '>>': operator.rshift},
+    {'+': operator.add, '-': operator.sub},
+    {'*': operator.mul, '/': divide, '%': lambda a, b: a - b * divide(a, b)},
+]
+
+
+@functools.lru_cache(maxsize=None)
+def parse_expression(text):
+    """An expression as a function of (resolve symbol, pc), parsed once"""
+    tokens = tokenize(text)
+    pos = [0]
+
+    def peek():
+        return tokens[pos[0]] if pos[0] < len(tokens) else None
+
+    def take():
+        pos[0] += 1
+        return tokens[pos[0] - 1]
+
+    def constant(v):
+        return lambda resolve, pc: v
+
+    def primary():
+        t = take() if peek() is not None else None
+        if t is None:
+            raise AsmError('missing operand in "%s"' % text)
+        if t == '(':
+            f = binary(0)
+            if peek() != ')':
+                raise AsmError('missing ) in "%s"' % text)
+            take()
+            return f
+        if t in ('-', '~', '!'):
+            f = primary()
+            unary = {'-': operator.neg, '~': operator.invert, '!': lambda v: int(not v)}[t]
+            return lambda resolve, pc: unary(f(resolve, pc))
+        if t == '*':
+            return lambda resolve, pc: pc
+        if t[0] == '$':
+            return constant(int(t[1:], 16))
+        if t[0] == '%':
+            return constant(int(t[1:], 2))
+        if t[0].isdigit():
+            return constant(int(t, 0) if t.lower().startswith('0x') else int(t))
+        if t[0] == "'":
+            v = 0
+            for ch in t[1:-1]:
+                v = (v << 8) | ord(ch)
+            return constant(v)
+        if not RE_SYMBOL.fullmatch(t):
+            raise AsmError('unexpected "%s" in "%s"' % (t, text))
+        return lambda resolve, pc: resolve(t)
+
+    def binary(level):
+        if level == len(BINARY_LEVELS):
+            return primary()
+        f = binary(level + 1)
+        while peek() in BINARY_LEVELS[level]:
+            op = BINARY_LEVELS[level][take()]
+            r = binary(level + 1)
+            f = (lambda op, f, r: lambda resolve, pc: op(f(resolve, pc), r(resolve, pc)))(op, f, r)
+        return f
+
+    f = binary(0)
+    if peek() is not None:
+        raise AsmError('unexpected "%s" in "%s"' % (peek(), text))
+    return f
+
+
+@functools.lru_cache(maxsize=None)
+def tokenize(text):
+    tokens = []
+    i = 0
+    while i < len(text):
+        c = text[i]
+        if c.isspace():
+            i += 1
+            continue
+        if text.startswith('<<', i) or text.startswith('>>', i):
+            tokens.append(text[i:i + 2])
+            i += 2
+            continue
+        if c == '$':
+            m = re.match(r'\$[0-9a-fA-F]+', text[i:])
+        elif c == '%' and i + 1 < len(text) and text[i + 1] in '01' and \
+                (not tokens or tokens[-1] in '()+-*/%&|^~!<<>>'):
+            m = re.match(r'%[01]+', text[i:])
+        elif c.isdigit():
+            m = re.match(r'0[xX][0-9a-fA-F]+|\d+', text[i:])
+        elif c == "'":
+            m = re.match(r"'[^']*'", text[i:])
+        elif c.isalpha() or c in '_.':
+            m = RE_SYMBOL.match(text, i)
+            tokens.append(m.group(0))
+            i = m.end()
+            continue
+        else:
+            m = None
+        if m:
+            tokens.append(m.group(0))
+            i += len(m.group(0))
+        else:
+            tokens.append(c)
+            i += 1
+    return tuple(tokens)
+
+
+@functools.lru_cache(maxsize=None)
+def split_line(text):
+    """(label, mnemonic, operands) of a source line."""
+    text = strip_comment(text)
+    if not text.strip():
+        return '', '', ()
+    label = ''
+    rest = text
+    if text[:1].strip():
+        m = re.match(r'([A-Za-z_.][A-Za-z0-9_.]*):?', text)
+        if not m:
+            raise AsmError('bad label in "%s"' % text)
+        label = m.group(1)
+        rest = text[m.end():]
+    else:
+        m = re.match(r'\s*([A-Za-z_.][A-Za-z0-9_.]*):(\s|$)', text)
+        if m:
+            label = m.group(1)
+            rest = text[m.end():]
+    parts = rest.strip().split(None, 1)
+    if not parts:
+        return label, '', ()
+    op = parts[0]
+    args = tuple(split_operands(parts[1])) if len(parts) > 1 else ()
+    if op.startswith('=') and len(op) > 1:
+        args = (op[1:],) + args
+        op = '='
+    return label, op, args
+
+
+def strip_comment(text):
+    if text.startswith('*') or text.lstrip().startswith(';'):
+        return ''
+    quote = None
+    for i, c in enumerate(text):
+        if quote:
+            if c == quote:
+                quote = None
+        elif c in '"':
+            quote = c
+        elif c == "'" and i + 2 < len(text) and "'" in text[i + 1:]:
+            quote = c
+        elif c == ';':
+            return text[:i]
+    return text
+
+
+def split_operands(text):
+    args = []
+    depth = 0
+    quote = None
+    current = ''
+    for c in text:
+        if quote:
+            current += c
+            if c == quote:
+                quote = None
+            continue
+        if c in '"\'':
+            quote = c
+        elif c == '(':
+            depth += 1
+        elif c == ')':
+            depth -= 1
+        elif c == ',' and depth == 0:
+            args.append(current.strip())
+            current = ''
+            continue
+        current += c
+    if current.strip():
+        args.append(current.strip())
+    return args
+
+
+def unquote(text):
+    text = text.strip()
+    if len(text) >= 2 and text[0] == text[-1] and text[0] in '"\'':
+        return text[1:-1]
+    return text
+
+
+def reglist_mask(text):
+    mask = 0
+    for part in text.split('/'):
+        first, _, last = part.partition('-')
+        a_first, n_first = reg_num(first)
+        a_last, n_last = reg_num(last) if last else (a_first, n_first)
+        if a_first != a_last:
+            raise AsmError('register range crosses D/A in "%s"' % text)
+        for n in range(n_first, n_last + 1):
+            mask |= 1 << (n + (8 if a_first else 0))
+    return mask
+
+
+def set_checksum(image):
+    """Header checksum: 16-bit sum of the words from $200 to the end."""
+    total = 0
+    for i in range(0x200, len(image) - 1, 2):
+        total += (image[i] << 8) | image[i + 1]
+    image[0x18E:0x190] = (total & 0xFFFF).to_bytes(2, 'big')
+
+
+def cmd_build(args):
+    sources = args.sources or sorted(glob.glob(os.path.join(args.dir, '*.s')))
+    if not sources:
+        sys.exit('no ROM sources in %s' % args.dir)
+    for src in sources:
+        try:
+            image = Assembler(src).assemble()
+        except AsmError as e:
+            sys.exit('%s' % e)
+        if len(image) < 0x200:
+            sys.exit('%s: no ROM header' % src)
+        # Round up to a 64 KB multiple like cartridge images
+        image += bytes(-len(image) % 0x10000)
+        set_checksum(image)
+        out = os.path.splitext(src)[0] + '.bin'
+        with open(out, 'wb') as f:
+            f.write(image)
+        print('%-28s %7d bytes' % (out, len(image)))
+
+
+# BENCH <rom> frames=N us=T m68k=.. z80=.. sound=.. vdp=.. wait=.. other=.. screen=crc ram=crc
+RE_BENCH = re.compile(r'^BENCH (\S+) (.*)$')
+
+
+def cmd_report(args):
+    rows = []
+    keys = []
+    for path in args.logs:
+        for line in open(path, errors='replace'):
+            m = RE_BENCH.match(line.strip())
+            if not m:
+                continue
+            fields = dict(f.split('=', 1) for f in m.group(2).split() if '=' in f)
+            for k in fields:
+                if k not in keys:
+                    keys.append(k)
+            rows.append((os.path.basename(m.group(1)), os.path.basename(path), fields))
+    if not rows:
+        sys.exit('no BENCH lines found')
+    header = ['rom', 'log'] + keys
+    table = [header] + [[rom, log] + [fields.get(k, '-') for k in keys] for rom, log, fields in rows]
+    widths = [max(len(r[i]) for r in table) for i in range(len(header))]
+    for r in table:
+        print('  '.join(c.ljust(w) if i < 2 else c.rjust(w) for i, (c, w) in enumerate(zip(r, widths))))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Benchmark ROMs')
+    sub = parser.add_subparsers(dest='cmd', required=True)
+
+    p = sub.add_parser('build', help='assemble the benchmark ROMs')
+    p.add_argument('--dir', default=os.path.normpath(os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'bench')))
+    p.add_argument('sources', nargs='*', help='ROM sources (default: all in --dir)')
+    p.set_defaults(func=cmd_build)
+
+    p = sub.add_parser('report', help='tabulate BENCH lines of UART logs')
+    p.add_argument('logs', nargs='+')
+    p.set_defaults(func=cmd_report)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,318 @@
+#!/usr/bin/env python3
+"""
+Profile-guided hot-code placement and SRAM usage report.
+
+  place  - read PC sample dumps (PCS lines from a PC_SAMPLING=1 build, see
+           src/pcsample.h) and the link map of that same build, attribute
+           the samples to functions and pick the hottest M68K, Z80, VDP and
+           YM2612 functions still executing from flash, within a byte
+           budget. Writes the hot list consumed by -DHOT_CODE_LIST.
+  apply  - rename the listed .text.<fn> sections of the given objects to
+           .time_critical.hot.<fn>; the SDK linker script places
+           .time_critical* in .data, which crt0 copies to SRAM at boot.
+  report - SRAM usage by output section and by kind of input section.
+
+Sections are renamed in the objects rather than claimed by a linker-script
+fragment because ld assigns an input section to the first matching
+statement, and the SDK script's .text catch-all comes first.
+
+Usage:
+  hot_code.py place --map murmgenesis.elf.map [--budget BYTES] [--top N]
+                    [--out hot_code.txt] samples.log [samples.log ...]
+  hot_code.py apply --objcopy OBJCOPY hot_code.txt obj [obj ...]
+  hot_code.py report murmgenesis.elf.map [--out sram.txt]
+"""
+import argparse
+import bisect
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+HOT_PREFIX = '.time_critical.hot.'
+
+# Object path pattern -> category eligible for placement
+CATEGORIES = [
+    ('m68k', re.compile(r'cpus/M68K')),
+    ('z80', re.compile(r'cpus/Z80|sound/z80')),
+    ('vdp', re.compile(r'/vdp/')),
+    ('ym2612', re.compile(r'sound/ym2612')),
+]
+
+HEX = r'0x[0-9a-fA-F]+'
+RE_REGION = re.compile(r'^(\w+)\s+(%s)\s+(%s)' % (HEX, HEX))
+RE_OUT = re.compile(r'^(\.\S+|/DISCARD/)(?:\s+(%s)\s+(%s))?' % (HEX, HEX))
+RE_IN = re.compile(r'^ (\.\S+|COMMON)(?:\s+(%s)\s+(%s)\s+(\S.*))?$' % (HEX, HEX))
+RE_CONT = re.compile(r'^\s+(%s)\s+(%s)(?:\s+(\S.*))?$' % (HEX, HEX))
+RE_SAMPLE = re.compile(r'PCS ([0-9a-fA-F]+) (\d+)')
+
+
+class Section:
+    def __init__(self, name, addr, size, obj=None, output=None):
+        self.name = name
+        self.addr = addr
+        self.size = size
+        self.obj = obj
+        self.output = output
+        self.samples = 0
+
+
+def parse_map(path):
+    """Memory regions, output sections and input sections of a GNU ld map."""
+    regions = {}
+    outputs = []
+    inputs = []
+    in_layout = False
+    in_regions = False
+    pending = None
+    current = None
+
+    for line in open(path, errors='replace'):
+        line = line.rstrip('\n')
+        if line.startswith('Memory Configuration'):
+            in_regions = True
+            continue
+        if line.startswith('Linker script and memory map'):
+            in_regions = False
+            in_layout = True
+            continue
+        if in_regions:
+            m = RE_REGION.match(line)
+            if m:
+                regions[m.group(1)] = (int(m.group(2), 16), int(m.group(3), 16))
+            continue
+        if not in_layout:
+            continue
+
+        if pending:
+            m = RE_CONT.match(line)
+            kind, name = pending
+            pending = None
+            if m:
+                addr, size = int(m.group(1), 16), int(m.group(2), 16)
+                if kind == 'out':
+                    current = Section(name, addr, size)
+                    outputs.append(current)
+                else:
+                    inputs.append(Section(name, addr, size, m.group(3), current))
+                continue
+
+        m = RE_OUT.match(line)
+        if m:
+            if m.group(2) is None:
+                pending = ('out', m.group(1))
+            else:
+                current = Section(m.group(1), int(m.group(2), 16), int(m.group(3), 16))
+                outputs.append(current)
+            continue
+        m = RE_IN.match(line)
+        if m:
+            if m.group(2) is None:
+                pending = ('in', m.group(1))
+            else:
+                inputs.append(Section(m.group(1), int(m.group(2), 16), int(m.group(3), 16),
+                                      m.group(4), current))
+    return regions, outputs, inputs
+
+
+def region_of(regions, addr):
+    for name, (origin, length) in regions.items():
+        if origin <= addr < origin + length:
+            return name
+    return None
+
+
+def category_of(section):
+    if section.obj is None:
+        return None
+    path = section.obj.replace('\\', '/')
+    for name, pattern in CATEGORIES:
+        if pattern.search(path):
+            return name
+    return None
+
+
+def function_of(section):
+    for prefix in ('.text.', HOT_PREFIX, '.time_critical.'):
+        if section.name.startswith(prefix):
+            return section.name[len(prefix):]
+    return '%s(%s)' % (os.path.basename(section.obj or '?'), section.name)
+
+
+def load_samples(paths):
+    counts = {}
+    for path in paths:
+        for line in open(path, errors='replace'):
+            m = RE_SAMPLE.search(line)
+            if m:
+                pc = int(m.group(1), 16)
+                counts[pc] = counts.get(pc, 0) + int(m.group(2))
+    return counts
+
+
+def attribute(regions, inputs, counts):
+    """Add the samples to the input sections holding them, returns the unmatched count."""
+    code = sorted((s for s in inputs if s.size and region_of(regions, s.addr)),
+                  key=lambda s: s.addr)
+    starts = [s.addr for s in code]
+    unmatched = 0
+    for pc, n in counts.items():
+        i = bisect.bisect_right(starts, pc) - 1
+        if i >= 0 and pc < code[i].addr + code[i].size:
+            code[i].samples += n
+        else:
+            unmatched += n
+    return unmatched
+
+
+def cmd_place(args):
+    regions, _, inputs = parse_map(args.map)
+    counts = load_samples(args.samples)
+    total = sum(counts.values())
+    if total == 0:
+        sys.exit('hot_code: no PCS lines in %s' % ', '.join(args.samples))
+    unmatched = attribute(regions, inputs, counts)
+
+    sampled = sorted((s for s in inputs if s.samples), key=lambda s: -s.samples)
+    in_flash = sum(s.samples for s in sampled if region_of(regions, s.addr) == 'FLASH')
+
+    candidates = [s for s in sampled
+                  if s.name.startswith('.text.')
+                  and region_of(regions, s.addr) == 'FLASH'
+                  and category_of(s)
+                  and s.samples >= args.min_samples]
+    chosen = []
+    used = 0
+    for s in candidates:
+        size = (s.size + 3) & ~3
+        if used + size > args.budget:
+            continue
+        chosen.append(s)
+        used += size
+        if args.top and len(chosen) >= args.top:
+            break
+    moved = sum(s.samples for s in chosen)
+
+    pct = lambda n: 100.0 * n / total
+    print('%d samples, %.1f%% in flash, %d outside the map' % (total, pct(in_flash), unmatched))
+    print('Hottest functions:')
+    for s in sampled[:args.show]:
+        print('  %6.2f%%  %-6s %-6s %5d B  %s' % (pct(s.samples), region_of(regions, s.addr),
+                                                 category_of(s) or '-', s.size, function_of(s)))
+    print('Placing %d functions, %d of %d bytes, %.1f%% of samples leave flash'
+          % (len(chosen), used, args.budget, pct(moved)))
+    for name, _ in CATEGORIES:
+        group = [s for s in chosen if category_of(s) == name]
+        if group:
+            print('  %-6s %4d functions %6d B  %5.1f%%' % (
+                name, len(group), sum(s.size for s in group), pct(sum(s.samples for s in group))))
+
+    with open(args.out, 'w') as f:
+        f.write('# Generated by tools/hot_code.py place - %d functions, %d bytes\n' % (len(chosen), used))
+        f.write('# budget %d bytes, %.1f%% of %d samples\n' % (args.budget, pct(moved), total))
+        for s in chosen:
+            f.write('%s  # %s %d samples %d B\n' % (s.name, category_of(s), s.samples, s.size))
+
+
+def cmd_apply(args):
+    names = []
+    for line in open(args.list):
+        line = line.split('#', 1)[0].strip()
+        if line:
+            if not line.startswith('.text.'):
+                sys.exit('hot_code: %s: not a .text section: %s' % (args.list, line))
+            names.append(line)
+    if not names:
+        return
+
+    # Renaming a section an object does not have is a no-op, so every
+    # object gets the whole list
+    with tempfile.NamedTemporaryFile('w', suffix='.rsp', delete=False) as rsp:
+        for name in names:
+            rsp.write('--rename-section %s=%s%s\n' % (name, HOT_PREFIX, name[len('.text.'):]))
+    try:
+        for obj in args.objects:
+            if obj.endswith(('.o', '.obj')):
+                subprocess.check_call([args.objcopy, '@' + rsp.name, obj])
+    finally:
+        os.unlink(rsp.name)
+
+
+def cmd_report(args):
+    regions, outputs, inputs = parse_map(args.map)
+    ram = [r for r in regions if r != 'FLASH']
+    lines = ['SRAM usage (%s)' % os.path.basename(args.map)]
+
+    for region in ram:
+        origin, length = regions[region]
+        secs = [s for s in outputs if s.size and region_of(regions, s.addr) == region]
+        used = sum(s.size for s in secs)
+        lines.append('%-10s %7d / %7d bytes (%.1f%%)' % (region, used, length, 100.0 * used / length))
+        for s in secs:
+            lines.append('  %-24s 0x%08x %7d' % (s.name, s.addr, s.size))
+
+    kinds = [
+        ('profiled hot code', lambda n: n.startswith(HOT_PREFIX)),
+        ('time-critical code', lambda n: n.startswith(('.time_critical', '.scratch_'))),
+        ('other code', lambda n: n.startswith('.text')),
+        ('initialised data', lambda n: n.startswith(('.data', '.sdata', '.rodata'))),
+        ('zeroed data', lambda n: n.startswith(('.bss', '.sbss')) or n == 'COMMON'),
+        ('uninitialised', lambda n: n.startswith('.uninitialized')),
+    ]
+    in_ram = [s for s in inputs if s.size and region_of(regions, s.addr) in ram]
+    lines.append('By kind:')
+    rest = list(in_ram)
+    for label, match in kinds:
+        group = [s for s in rest if match(s.name)]
+        rest = [s for s in rest if not match(s.name)]
+        lines.append('  %-20s %7d' % (label, sum(s.size for s in group)))
+    lines.append('  %-20s %7d' % ('other', sum(s.size for s in rest)))
+
+    lines.append('Largest input sections:')
+    for s in sorted(in_ram, key=lambda s: -s.size)[:args.show]:
+        lines.append('  %7d  %-40s %s' % (s.size, s.name, os.path.basename(s.obj or '')))
+
+    text = '\n'.join(lines) + '\n'
+    if args.out:
+        with open(args.out, 'w') as f:
+            f.write(text)
+        # Only the totals go to the build log
+        print('\n'.join(l for l in lines if not l.startswith(' ')
+                        and l not in ('By kind:', 'Largest input sections:')))
+    else:
+        sys.stdout.write(text)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Profile-guided hot-code placement')
+    sub = parser.add_subparsers(dest='cmd', required=True)
+
+    p = sub.add_parser('place', help='pick hot functions from PC samples')
+    p.add_argument('--map', required=True, help='link map of the sampled build')
+    p.add_argument('--budget', type=int, default=32768, help='SRAM bytes to spend (default 32768)')
+    p.add_argument('--top', type=int, default=0, help='at most N functions (default: budget only)')
+    p.add_argument('--min-samples', type=int, default=2, help='ignore colder functions (default 2)')
+    p.add_argument('--show', type=int, default=30, help='hottest functions to print')
+    p.add_argument('--out', default='hot_code.txt')
+    p.add_argument('samples', nargs='+', help='UART logs with PCS lines')
+    p.set_defaults(func=cmd_place)
+
+    p = sub.add_parser('apply', help='move listed functions to SRAM sections')
+    p.add_argument('--objcopy', required=True)
+    p.add_argument('list')
+    p.add_argument('objects', nargs='*')
+    p.set_defaults(func=cmd_apply)
+
+    p = sub.add_parser('report', help='SRAM usage by section')
+    p.add_argument('map')
+    p.add_argument('--out')
+    p.add_argument('--show', type=int, default=25, help='largest input sections to list')
+    p.set_defaults(func=cmd_report)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == '__main__':
+    main()